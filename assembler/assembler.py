@@ -173,11 +173,11 @@ class InstructionFormat:
             "INT": (1, [AddressingMode.IMM], "Generate interrupt"),
             "SYSCALL": (1, [AddressingMode.IMM], "System call"),
             
-            # Register + Immediate operand
-            "IN": (2, [(AddressingMode.REG, AddressingMode.IMM)], "Input from port"),
+            # Register + port (immediate or register)
+            "IN": (2, [(AddressingMode.REG, [AddressingMode.IMM, AddressingMode.REG])], "Input from port"),
             
-            # Port + value
-            "OUT": (2, [(AddressingMode.IMM, [AddressingMode.REG, AddressingMode.IMM])], "Output to port"),
+            # Port (immediate or register) + value register
+            "OUT": (2, [([AddressingMode.IMM, AddressingMode.REG], AddressingMode.REG)], "Output to port"),
             
             # Register + target address
             "LOOP": (2, [(AddressingMode.REG, AddressingMode.IMM)], "Decrement and jump if not zero"),
@@ -890,6 +890,18 @@ class Assembler:
                 # Register to register
                 instruction = self.encode_instruction(opcode, AddressingMode.REG, reg1, reg2_val, 0)
             
+            elif opcode_str == "OUT":
+                # Port, value: encoded like IN with the value register in reg1
+                if mode1 == AddressingMode.IMM:
+                    port = operands[0][3]
+                    instruction = self.encode_instruction(opcode, AddressingMode.IMM, reg2_val, 0, port)
+                    
+                    # Track unresolved references
+                    if 0 in for_source:
+                        self.unresolved_references.append((len(self.instructions), for_source[0], 'imm'))
+                else:
+                    instruction = self.encode_instruction(opcode, AddressingMode.REG, reg2_val, reg1, 0)
+            
             elif mode1 == AddressingMode.REG:
                 # Destination is a register
                 instruction = self.encode_instruction(opcode, mode2, reg1, reg2_val, imm)
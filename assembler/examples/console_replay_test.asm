@@ -0,0 +1,30 @@
+; Console input under record/replay (see tools/test_replay_console.py)
+; Reads one byte with syscall 3, then the rest of the line with syscall 4,
+; and echoes both as "first[rest]". A replayed run must print what the
+; recorded run printed, whatever its own stdin holds.
+.text
+    LOAD R0, prompt_msg
+    SYSCALL #2            ; Prompt, flushed before the read blocks
+
+    SYSCALL #3            ; Read char
+    SYSCALL #0            ; Echo it
+    LOAD R0, #91          ; '['
+    SYSCALL #0
+
+    LOAD R0, input_buffer
+    LOAD R5, #32
+    SYSCALL #4            ; Read string, same input buffer as syscall 3
+
+    LOAD R0, input_buffer
+    SYSCALL #2
+    LOAD R0, #93          ; ']'
+    SYSCALL #0
+    LOAD R0, #10
+    SYSCALL #0
+    HALT
+
+.data
+prompt_msg:
+    .asciiz "> "
+input_buffer:
+    .space 32
@@ -0,0 +1,86 @@
+; Overlapping DMA transfers longer than one 256-byte chunk
+; Fills a buffer with 0, 1, 2, ..., moves 512 bytes up by one byte, checks
+; the result, then moves them back down and checks again. Both transfers
+; must give the same result as a single memmove. Prints one line each.
+.text
+    LOAD R6, buffer
+    LOAD R9, #0
+fill_loop:
+    STOREB R9, [R6]
+    ADD R6, #1
+    ADD R9, #1
+    CMP R9, #600
+    JNZ fill_loop
+
+    ; Up: destination starts inside the source
+    LOAD R7, buffer
+    OUT #0x30, R7         ; Channel 0 source
+    ADD R7, #1
+    OUT #0x31, R7         ; Destination
+    CALL transfer
+    LOAD R0, up_msg
+    SYSCALL #2
+    LOAD R6, buffer
+    ADD R6, #1
+    CALL check
+
+    ; Down: source starts inside the destination
+    LOAD R7, buffer
+    OUT #0x31, R7
+    ADD R7, #1
+    OUT #0x30, R7
+    CALL transfer
+    LOAD R0, down_msg
+    SYSCALL #2
+    LOAD R6, buffer
+    CALL check
+    HALT
+
+; Move 512 bytes on channel 0 and wait for it to finish
+transfer:
+    LOAD R7, #512
+    OUT #0x32, R7         ; Length
+    LOAD R7, #1
+    OUT #0x34, R7         ; Start
+wait_loop:
+    IN R7, #0x36          ; Status
+    CMP R7, #1
+    JZ wait_loop
+    RET
+
+; Check that the 512 bytes at R6 hold 0, 1, 2, ... and print the result
+check:
+    LOAD R9, #0
+check_loop:
+    LOADB R7, [R6]
+    MOVE R8, R9
+    AND R8, #255
+    CMP R7, R8
+    JNZ check_failed
+    ADD R6, #1
+    ADD R9, #1
+    CMP R9, #512
+    JNZ check_loop
+    LOAD R0, ok_msg
+    SYSCALL #2
+    RET
+check_failed:
+    LOAD R0, failed_msg
+    SYSCALL #2
+    MOVE R0, R9
+    SYSCALL #1
+    LOAD R0, #10
+    SYSCALL #0
+    RET
+
+.data
+up_msg:
+    .asciiz "up: "
+down_msg:
+    .asciiz "down: "
+ok_msg:
+    .asciiz "ok\n"
+failed_msg:
+    .asciiz "wrong byte at "
+buffer:
+    .space 600
@@ -0,0 +1,43 @@
+; Embedding check (see tools/test_libvm.py), run by tools/embed_test.c
+; Echoes the character the host put on console input, then calls the
+; host's syscalls 100 (add) and 101 (upper-case in place) and the FNV
+; hash plugin's syscall 200. The last call hands syscall 101 a range that
+; runs past the end of memory, which faults and stops the program.
+.text
+    SYSCALL #3            ; Read a character
+    SYSCALL #0
+    LOAD R0, #10
+    SYSCALL #0
+
+    LOAD R0, #40
+    LOAD R5, #2
+    SYSCALL #100          ; Host add
+    SYSCALL #1
+    LOAD R0, #10
+    SYSCALL #0
+
+    LOAD R0, text
+    LOAD R5, #5
+    SYSCALL #200          ; Plugin hash of "hello"
+    SYSCALL #5
+    LOAD R0, #10
+    SYSCALL #0
+
+    LOAD R0, text
+    LOAD R5, #5
+    SYSCALL #101          ; Host upper-case
+    LOAD R0, text
+    SYSCALL #2
+    LOAD R0, #10
+    SYSCALL #0
+
+    LOAD R0, #0xFFF0
+    LOAD R5, #32
+    SYSCALL #101          ; Faults
+    LOAD R0, text
+    SYSCALL #2
+    HALT
+
+.data
+text:
+    .asciiz "hello"
@@ -0,0 +1,59 @@
+; File sandbox escapes (see tools/test_files_sandbox.py)
+; Opens and stats names that the test creates inside the sandbox, and
+; prints R5 after each call: 0 = success, 1 = refused. Names that reach
+; outside the sandbox through a symlink must be refused.
+.text
+    LOAD R0, inside_name
+    CALL try_open
+    LOAD R0, file_link_name
+    CALL try_open
+    LOAD R0, dir_link_name
+    CALL try_open
+    LOAD R0, inner_name
+    CALL try_open
+
+    ; Status of the link itself: succeeds with type 2 (other)
+    LOAD R0, file_link_name
+    LOAD R5, stat_buffer
+    SYSCALL #15
+    MOVE R0, R5
+    SYSCALL #1
+    LOAD R0, #32
+    SYSCALL #0
+    LOAD R6, stat_buffer
+    LOADB R0, [R6+8]
+    SYSCALL #1
+    LOAD R0, #10
+    SYSCALL #0
+
+    ; Status through a linked directory is refused
+    LOAD R0, dir_link_name
+    LOAD R5, stat_buffer
+    SYSCALL #15
+    MOVE R0, R5
+    SYSCALL #1
+    LOAD R0, #10
+    SYSCALL #0
+    HALT
+
+; Open R0 for reading, print R5 and a space
+try_open:
+    LOAD R5, #0
+    SYSCALL #10
+    MOVE R0, R5
+    SYSCALL #1
+    LOAD R0, #32
+    SYSCALL #0
+    RET
+
+.data
+inside_name:
+    .asciiz "inside.txt"
+file_link_name:
+    .asciiz "file_link"
+dir_link_name:
+    .asciiz "dir_link/secret.txt"
+inner_name:
+    .asciiz "/sub/inner.txt"
+stat_buffer:
+    .space 12
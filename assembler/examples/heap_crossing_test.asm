@@ -0,0 +1,101 @@
+; Block transfers that run from below the heap into it (see
+; tools/test_heap_crossing.py). Reads a case letter, allocates a heap
+; block, then makes one transfer into the 64 bytes before 0xC030, which
+; covers the first block header. A transfer that reaches the heap must
+; fault; a case that stays below the heap frees the block and prints
+; "heap ok".
+;   n: random fill of 0xBFF0-0xBFFF (control, stays below the heap)
+;   r: random fill (syscall 42)
+;   f: file read (syscall 12) from heap_crossing.txt in the sandbox
+;   l: line read (syscall 52) of the rest of the input line
+;   s: string print (syscall 51) of 16 non-zero bytes ending at 0xBFFF
+;   d: disk read of one sector into 0xBF00 (run with -i)
+;   c: channel read (syscall 61); the range is checked before the channel,
+;      so the fault comes even without an input channel
+.text
+    SYSCALL #3            ; Case letter
+    MOVE R9, R0
+    ALLOC R10, #16
+
+    CMP R9, #110          ; 'n'
+    JZ case_control
+    CMP R9, #114          ; 'r'
+    JZ case_random
+    CMP R9, #102          ; 'f'
+    JZ case_file
+    CMP R9, #108          ; 'l'
+    JZ case_line
+    CMP R9, #115          ; 's'
+    JZ case_string
+    CMP R9, #100          ; 'd'
+    JZ case_disk
+    CMP R9, #99           ; 'c'
+    JZ case_channel
+    HALT
+
+case_control:
+    LOAD R0, #0xBFF0
+    LOAD R5, #16
+    SYSCALL #42
+    JMP finish
+
+case_random:
+    LOAD R0, #0xBFF0
+    LOAD R5, #64
+    SYSCALL #42
+    JMP finish
+
+case_file:
+    LOAD R0, file_name
+    LOAD R5, #0
+    SYSCALL #10           ; Open for reading; R0 = handle
+    LOAD R5, #0xBFF0
+    LOAD R6, #64
+    SYSCALL #12
+    JMP finish
+
+case_line:
+    LOAD R0, #0xBFF0
+    LOAD R5, #64
+    SYSCALL #52
+    JMP finish
+
+case_string:
+    LOAD R6, #0xBFF0
+    LOAD R7, #65          ; 'A'
+string_fill:
+    STOREB R7, [R6]
+    ADD R6, #1
+    CMP R6, #0xC000
+    JNZ string_fill
+    LOAD R0, #0xBFF0
+    SYSCALL #51
+    JMP finish
+
+case_disk:
+    LOAD R7, #0
+    OUT #0x10, R7         ; Sector
+    LOAD R7, #0xBF00
+    OUT #0x11, R7         ; Buffer
+    LOAD R7, #1
+    OUT #0x12, R7         ; Sector count
+    OUT #0x13, R7         ; Read
+    JMP finish
+
+case_channel:
+    LOAD R0, #0xBFF0
+    LOAD R5, #64
+    SYSCALL #61
+    JMP finish
+
+finish:
+    FREE R10
+    LOAD R0, ok_msg
+    SYSCALL #2
+    HALT
+
+.data
+ok_msg:
+    .asciiz "heap ok\n"
+file_name:
+    .asciiz "heap_crossing.txt"
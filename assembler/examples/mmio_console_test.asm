@@ -0,0 +1,29 @@
+; Console through memory-mapped I/O (see tools/test_mmio_console.py)
+; Run with -M 0x7FF0: the console's ports appear as dwords at 0x7FF0
+; (data), 0x7FF4 (status), 0x7FF8 (vector) and 0x7FFC (input flags).
+; Prints a greeting with byte stores, then echoes input read with byte
+; loads until end of input, all without IN, OUT or syscalls.
+.text
+    LOAD R6, #0x7FF0      ; Console data register
+    LOAD R7, greeting
+print_loop:
+    LOADB R0, [R7]
+    CMP R0, #0
+    JZ echo_loop
+    STOREB R0, [R6]
+    ADD R7, #1
+    JMP print_loop
+
+echo_loop:
+    LOADB R0, [R6]        ; Next input byte, 0 at end of input
+    CMP R0, #0
+    JZ done
+    STOREB R0, [R6]
+    JMP echo_loop
+
+done:
+    HALT
+
+.data
+greeting:
+    .asciiz "mmio: "
@@ -0,0 +1,84 @@
+; Three stage pipeline (see tools/test_pipeline.py)
+; Run as 'vm pipeline_test.bin -c pipeline_test.bin -c pipeline_test.bin'.
+; Each copy picks its job from the channel status port: the first stage
+; has no input channel and copies stdin lines onto its output with
+; read_line, the middle stage upper-cases whatever it reads, and the last
+; stage has no output channel and writes what it reads to the console
+; with write_buffer. Closing the channel at the end of the input passes
+; end-of-stream down the pipe.
+.text
+    IN R9, #0x62          ; Channel status
+    MOVE R10, R9
+    AND R10, #1           ; Input channel connected?
+    JZ source
+    AND R9, #2            ; Output channel connected?
+    JZ sink
+
+filter:
+    LOAD R0, buffer
+    LOAD R5, #64
+    SYSCALL #61           ; channel_read
+    CMP R0, #0
+    JZ filter_done
+    MOVE R8, R0
+    LOAD R6, buffer
+    MOVE R11, R8
+upper:
+    LOADB R7, [R6]
+    CMP R7, #97
+    JC upper_next         ; Below 'a'
+    CMP R7, #122
+    JA upper_next         ; Above 'z'
+    SUB R7, #32
+    STOREB R7, [R6]
+upper_next:
+    ADD R6, #1
+    SUB R11, #1
+    JNZ upper
+    LOAD R0, buffer
+    MOVE R5, R8
+    SYSCALL #60           ; channel_write
+    JMP filter
+filter_done:
+    SYSCALL #62           ; channel_close
+    HALT
+
+source:
+    LOAD R0, buffer
+    LOAD R5, #64
+    SYSCALL #52           ; read_line, R5 = 1 at end of input
+    CMP R5, #1
+    JZ source_done
+    MOVE R5, R0
+    LOAD R0, buffer
+    SYSCALL #60
+    LOAD R0, newline
+    LOAD R5, #1
+    SYSCALL #60
+    JMP source
+source_done:
+    SYSCALL #62
+    HALT
+
+sink:
+    LOAD R0, buffer
+    LOAD R5, #64
+    SYSCALL #61
+    CMP R0, #0
+    JZ sink_done
+    MOVE R5, R0
+    LOAD R0, buffer
+    SYSCALL #50           ; write_buffer
+    JMP sink
+sink_done:
+    LOAD R0, done_msg
+    SYSCALL #51           ; write_string
+    HALT
+
+.data
+newline:
+    .asciiz "\n"
+done_msg:
+    .asciiz "end of stream\n"
+buffer:
+    .space 64
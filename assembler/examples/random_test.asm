@@ -0,0 +1,58 @@
+; Random numbers (see tools/test_random.py)
+; Seeds the generator and prints draws of syscall 40: 2000 with max 6, 200
+; with max 1 and 100 with max 0, which means the full 32-bit range. Then
+; fills the 30 bytes between two guard bytes
+; with syscall 42 and prints the count it returns, the guards and the
+; filled bytes as numbers.
+.text
+    LOAD R0, #777
+    SYSCALL #41           ; Seed
+
+    LOAD R8, #2000
+    LOAD R9, #6
+    CALL print_draws
+    LOAD R8, #200
+    LOAD R9, #1
+    CALL print_draws
+    LOAD R8, #100
+    LOAD R9, #0
+    CALL print_draws
+
+    LOAD R0, buffer
+    ADD R0, #1
+    LOAD R5, #30
+    SYSCALL #42           ; Fill buffer[1..30]
+    SYSCALL #1
+    LOAD R0, #10
+    SYSCALL #0
+
+    LOAD R6, buffer
+    LOAD R8, #32
+print_bytes:
+    LOADB R0, [R6]
+    SYSCALL #1
+    LOAD R0, #32
+    SYSCALL #0
+    ADD R6, #1
+    SUB R8, #1
+    JNZ print_bytes
+    LOAD R0, #10
+    SYSCALL #0
+    HALT
+
+; Print R8 draws in [0, R9] on one line
+print_draws:
+    MOVE R0, R9
+    SYSCALL #40
+    SYSCALL #1
+    LOAD R0, #32
+    SYSCALL #0
+    SUB R8, #1
+    JNZ print_draws
+    LOAD R0, #10
+    SYSCALL #0
+    RET
+
+.data
+buffer:
+    .asciiz "U                              U"
@@ -0,0 +1,37 @@
+; Snapshot round trip (see tools/test_snapshot.py)
+; Prints ten random numbers and a heap-held counter, five before the label
+; 'middle' and five after it. A run saved at 'middle' and resumed must
+; print the same as a run straight through: registers, memory, heap and
+; random generator all come back.
+.text
+    LOAD R0, #12345
+    SYSCALL #41           ; Seed the generator
+    ALLOC R10, #4
+    LOAD R9, #0
+    STOREB R9, [R10]
+    LOAD R8, #5
+    CALL print_numbers
+
+middle:
+    LOAD R8, #5
+    CALL print_numbers
+    FREE R10
+    HALT
+
+; Print R8 lines of "count random"
+print_numbers:
+    LOADB R9, [R10]
+    ADD R9, #1
+    STOREB R9, [R10]
+    MOVE R0, R9
+    SYSCALL #1
+    LOAD R0, #32
+    SYSCALL #0
+    LOAD R0, #1000
+    SYSCALL #40
+    SYSCALL #1
+    LOAD R0, #10
+    SYSCALL #0
+    SUB R8, #1
+    JNZ print_numbers
+    RET
@@ -0,0 +1,30 @@
+; Syscall table (see tools/test_syscall_table.py)
+; An unused number below 70 only sets R5 = 1, which is printed. Syscall
+; 200 hashes "hello" when plugins/fnv_hash.so is loaded and faults when it
+; is not. Syscall 150 is never registered and always faults, so the last
+; line is never printed.
+.text
+    LOAD R5, #7
+    SYSCALL #65           ; Unused built-in number
+    MOVE R0, R5
+    SYSCALL #1
+    LOAD R0, #10
+    SYSCALL #0
+
+    LOAD R0, message
+    LOAD R5, #5
+    SYSCALL #200          ; FNV-1a hash from the plugin
+    SYSCALL #5
+    LOAD R0, #10
+    SYSCALL #0
+
+    SYSCALL #150          ; Not registered
+    LOAD R0, unreachable
+    SYSCALL #2
+    HALT
+
+.data
+message:
+    .asciiz "hello"
+unreachable:
+    .asciiz "still running\n"
@@ -0,0 +1,57 @@
+#ifndef _CHANNEL_H_
+#define _CHANNEL_H_
+
+#include <stdint.h>
+#include "vm_types.h"
+
+// A channel is a byte stream from one VM to another VM in the same process,
+// possibly running on another thread. Each VM has at most one input and one
+// output channel, so VMs chain into a pipeline.
+
+// Port offsets (relative to the device base port)
+#define CHANNEL_PORT_AVAIL    0  // Read: bytes waiting on the input channel
+#define CHANNEL_PORT_SPACE    1  // Read: free bytes on the output channel
+#define CHANNEL_PORT_STATUS   2  // Read: CHANNEL_STATUS_* flags
+#define CHANNEL_PORT_CONTROL  3  // Write CHANNEL_CMD_CLOSE: end the output stream
+#define CHANNEL_PORT_COUNT    4
+
+// Status flags
+#define CHANNEL_STATUS_INPUT  0x01  // An input channel is connected
+#define CHANNEL_STATUS_OUTPUT 0x02  // An output channel is connected
+#define CHANNEL_STATUS_EOF    0x04  // Input writer has closed and the input is drained
+#define CHANNEL_STATUS_BROKEN 0x08  // Output reader has gone; writes are discarded
+
+// Control commands
+#define CHANNEL_CMD_CLOSE     1
+
+// Ring size used by channel_connect when none is given
+#define CHANNEL_DEFAULT_SIZE  (64 * 1024)
+
+// A blocked side yields its time slice this many times before sleeping
+#define CHANNEL_SPIN_YIELDS   64
+
+// Device lifecycle
+int io_attach_channel(VM *vm, uint16_t base_port);
+
+// Connect writer's output to reader's input through a new ring of at least
+// capacity bytes (0 = CHANNEL_DEFAULT_SIZE). Both VMs must be initialized and
+// neither end may already be connected.
+int channel_connect(VM *writer, VM *reader, uint32_t capacity);
+
+// Copy len bytes into the output channel, waiting while it is full. Returns
+// the bytes written, less than len only if there is no output or the reader
+// has gone.
+uint32_t channel_write(VM *vm, const uint8_t *data, uint32_t len);
+
+// Copy up to size bytes from the input channel, waiting until at least one
+// byte is available. Returns 0 at end of stream or if there is no input.
+uint32_t channel_read(VM *vm, uint8_t *data, uint32_t size);
+
+// End the output stream; the reader sees end of stream once it is drained.
+// Closing is also done when the VM's devices are cleaned up.
+void channel_close(VM *vm);
+
+// Status flags for the guest (CHANNEL_STATUS_*)
+uint32_t channel_status(VM *vm);
+
+#endif // _CHANNEL_H_
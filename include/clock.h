@@ -0,0 +1,30 @@
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+#include "vm_types.h"
+
+// Clock modes
+#define CLOCK_MODE_REAL       0  // Host monotonic time; sleep blocks
+#define CLOCK_MODE_VIRTUAL    1  // Derived from executed instructions; sleep skips ahead
+
+// Virtual time advanced per executed instruction (a 100 MHz guest)
+#define CLOCK_VIRTUAL_NS_PER_INSTRUCTION 10
+
+// The virtual clock folds the 32-bit instruction counter into its 64-bit
+// base at least this often, so the counter never wraps between reads
+#define CLOCK_REBASE_INTERVAL 0x40000000
+
+// (Re)start the clock at zero in the given mode
+void clock_init(VM *vm, uint8_t mode);
+
+// Restart the clock in the given mode, reading ns now (snapshot restore)
+void clock_restore(VM *vm, uint8_t mode, uint64_t ns);
+
+// Nanoseconds since the clock started
+uint64_t clock_now_ns(VM *vm);
+
+// Wait in real mode; advance the clock and return at once in virtual mode
+// or when replaying a log
+void clock_sleep_ns(VM *vm, uint64_t ns);
+
+#endif // _CLOCK_H_
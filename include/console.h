@@ -0,0 +1,93 @@
+#ifndef _CONSOLE_H_
+#define _CONSOLE_H_
+
+#include <stddef.h>
+#include "vm_types.h"
+
+// Console port offsets (relative to the device base port)
+#define CONSOLE_PORT_DATA     0  // Read: next input byte (waits, 0 at end of input), Write: output byte
+#define CONSOLE_PORT_STATUS   1  // Read: input bytes buffered, Write: byte to stderr
+#define CONSOLE_PORT_VECTOR   2  // Interrupt vector raised when input arrives (0 = none)
+#define CONSOLE_PORT_INPUT    3  // Read: CONSOLE_INPUT_* flags
+#define CONSOLE_PORT_COUNT    4
+
+// Memory-mapped window: port n is the dword at base + 4 * n. Accesses of
+// any size at the start of a slot reach the port; other bytes read as 0.
+#define CONSOLE_MMIO_SIZE     (CONSOLE_PORT_COUNT * 4)
+
+// Input flags
+#define CONSOLE_INPUT_READY   0x01  // At least one byte can be read without waiting
+#define CONSOLE_INPUT_EOF     0x02  // Input has ended and everything has been read
+
+// Output ring size and writer thread tuning
+#define CONSOLE_RING_SIZE       (64 * 1024)
+#define CONSOLE_WAKE_THRESHOLD  4096   // Wake the writer once this much is queued
+#define CONSOLE_LINGER_US       2000   // Writer waits this long to batch small output
+#define CONSOLE_CAPTURE_INITIAL 4096   // First allocation of the buffer sink
+
+// Input buffer filled by the input poller thread, and how often (in
+// instructions) the run loop checks it for the input interrupt
+#define CONSOLE_INPUT_SIZE          4096
+#define CONSOLE_INPUT_POLL_INTERVAL 1024
+
+// Output sinks: where guest output (console port 0 and syscalls 0-9, 50-59)
+// goes. File descriptors are written by the writer thread; the buffer and
+// the callback are filled directly on the VM thread, without the ring.
+#define CONSOLE_SINK_FD       0  // Host descriptor, stdout by default
+#define CONSOLE_SINK_BUFFER   1  // Growable in-memory buffer, see console_output
+#define CONSOLE_SINK_CALLBACK 2  // Host function
+
+typedef void (*ConsoleSinkFn)(VM *vm, const char *data, size_t len, void *user_data);
+
+// Device lifecycle
+int io_attach_console(VM *vm, uint16_t base_port);
+
+// Map the console ports into guest memory at base, so plain loads and
+// stores reach the console (see mmio.h)
+int console_map_mmio(VM *vm, uint16_t base);
+
+// Select the output sink; pending output goes to the old sink first. The
+// descriptor is not closed by the VM.
+int console_set_output_fd(VM *vm, int fd);
+int console_set_output_buffer(VM *vm);
+int console_set_output_callback(VM *vm, ConsoleSinkFn callback, void *user_data);
+
+// Select the input descriptor; input buffered from the old one is dropped,
+// and the descriptor is not closed by the VM. A new VM has no input (reads
+// see the end of input), so VMs sharing a process don't race for stdin;
+// the program run by main reads stdin.
+#define CONSOLE_NO_INPUT      (-1)
+int console_set_input_fd(VM *vm, int fd);
+
+// Output captured by the buffer sink (NUL-terminated, NULL for other sinks);
+// the pointer is valid until the next guest output or clear
+const char *console_output(VM *vm, size_t *len);
+void console_clear_output(VM *vm);
+
+// Guest output; queued for the writer thread unless in debug mode
+void console_write(VM *vm, const char *data, size_t len);
+void console_putc(VM *vm, char c);
+void console_printf(VM *vm, const char *format, ...);
+
+// Wait until all queued output has reached the host
+void console_flush(VM *vm);
+
+// Guest input; flushes pending output first so prompts are visible. Input is
+// read from the input descriptor by a poller thread started on first use,
+// except in debug mode, where the debugger shares stdin and reads stay
+// synchronous.
+int console_getc(VM *vm);
+
+// Bytes that can be read without waiting (0 at end of input)
+uint32_t console_input_available(VM *vm);
+
+// Sleep up to ns of host time, ending early when input arrives, and raise the
+// input interrupt at once. Returns -1 without sleeping if the input interrupt
+// is not enabled.
+int console_wait_input(VM *vm, uint64_t ns);
+
+// Read one line without the newline into buffer (NUL-terminated);
+// returns the length, or -1 at end of input with nothing read
+int console_read_line(VM *vm, char *buffer, size_t size);
+
+#endif // _CONSOLE_H_
@@ -0,0 +1,44 @@
+#ifndef _COVERAGE_H_
+#define _COVERAGE_H_
+
+#include "vm_types.h"
+
+// Code coverage: one bit per code segment address, set when an instruction
+// at that address executes. The engine sets the bit directly (no hook
+// call), and without hooks registered it keeps the plain interpreter, so
+// coverage costs one bit-set per instruction. Bitmaps from many VMs or runs are combined with an OR.
+#define COVERAGE_BITS    CODE_SEGMENT_SIZE
+#define COVERAGE_WORDS   (COVERAGE_BITS / 64)
+
+// Saved bitmap: magic, version, bit count, then the words in host byte order
+#define COVERAGE_MAGIC   "VMCV"
+#define COVERAGE_VERSION 1
+
+#define COVERAGE_MARK(bits, pc) \
+    do { \
+        if ((pc) < COVERAGE_BITS) { \
+            (bits)[(pc) >> 6] |= 1ULL << ((pc) & 63); \
+        } \
+    } while (0)
+
+#define COVERAGE_HIT(bits, address) (((bits)[(address) >> 6] >> ((address) & 63)) & 1)
+
+// Start recording into a cleared bitmap; call before the run
+int coverage_start(VM *vm);
+
+// OR the VM's bitmap into 'into' with atomic operations, so VMs on
+// different threads can merge into one shared bitmap
+void coverage_merge(VM *vm, uint64_t *into);
+
+// OR 'bits' into the bitmap saved at path (created if missing) under an
+// exclusive file lock, so concurrent runs can share one file. The merged
+// result is left in 'bits'.
+int coverage_merge_file(VM *vm, const char *path, uint64_t *bits);
+
+// Write 'bits' as an lcov tracefile, one record per source file of the
+// VM's debug information
+int coverage_write_lcov(VM *vm, const char *path, const uint64_t *bits);
+
+void coverage_stop(VM *vm);
+
+#endif // _COVERAGE_H_
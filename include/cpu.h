@@ -9,6 +9,7 @@ int cpu_reset(VM *vm);
 
 // Instruction execution
 int cpu_execute_instruction(VM *vm, Instruction *instr);
+int cpu_execute_instruction_hooked(VM *vm, Instruction *instr);  // With hook calls (hooks.h)
 int cpu_step(VM *vm);
 
 // Register operations
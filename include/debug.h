@@ -11,6 +11,8 @@ void free_debug_info(VM *vm);
 
 Symbol* find_symbol_by_address(VM *vm, uint32_t address);
 
+Symbol* find_symbol_by_name(VM *vm, const char *name);
+
 SourceLine* find_source_line_by_address(VM *vm, uint32_t address);
 
 void debug_print_source_info(VM *vm);
@@ -0,0 +1,46 @@
+#ifndef _DISK_H_
+#define _DISK_H_
+
+#include "vm_types.h"
+
+#define DISK_SECTOR_SIZE      512
+#define DISK_MAX_TRANSFER     127  // Sectors per command (must fit the 64K address space)
+
+// Disk port offsets (relative to the device base port)
+#define DISK_PORT_SECTOR      0  // First sector of the transfer
+#define DISK_PORT_BUFFER      1  // Guest buffer address
+#define DISK_PORT_NSECTORS    2  // Number of sectors
+#define DISK_PORT_COMMAND     3  // Write: DISK_CMD_*
+#define DISK_PORT_STATUS      4  // Read: DISK_STATUS_* of the last command
+#define DISK_PORT_VECTOR      5  // Completion interrupt vector (0 = none)
+#define DISK_PORT_MODE        6  // DISK_MODE_* flags
+#define DISK_PORT_CAPACITY    7  // Read: image size in sectors
+#define DISK_PORT_COUNT       8
+
+// Commands
+#define DISK_CMD_READ         1  // Image -> guest memory
+#define DISK_CMD_WRITE        2  // Guest memory -> image
+#define DISK_CMD_FLUSH        3  // Write dirty sectors back to the image file
+
+// Status values
+#define DISK_STATUS_OK        0
+#define DISK_STATUS_ERROR     1  // Bad sector range, read-only image or host I/O error
+
+// Mode flags
+#define DISK_MODE_WRITEBACK   0x01  // Only sync the image on FLUSH (default: sync every write)
+
+// Transfer statistics
+typedef struct {
+    uint64_t sectors_read;
+    uint64_t sectors_written;
+    uint64_t flushes;
+    double   elapsed_seconds;   // Host time since the disk was attached
+} DiskStats;
+
+// Device lifecycle
+int io_attach_disk(VM *vm, uint16_t base_port, const char *image_path);
+
+// Returns 0 if no disk is attached
+int disk_get_stats(VM *vm, DiskStats *stats);
+
+#endif // _DISK_H_
@@ -0,0 +1,43 @@
+#ifndef _DMA_H_
+#define _DMA_H_
+
+#include "vm_types.h"
+
+#define DMA_CHANNELS          4
+
+// Channel port offsets; channel n starts at base + n * DMA_CHANNEL_PORTS
+#define DMA_PORT_SOURCE       0  // Source address (or port with DMA_CTRL_SRC_PORT)
+#define DMA_PORT_DEST         1  // Destination address (or port with DMA_CTRL_DST_PORT)
+#define DMA_PORT_LENGTH       2  // Number of bytes to transfer
+#define DMA_PORT_STRIDE       3  // Low 16 bits: source stride, high 16 bits: destination stride
+#define DMA_PORT_CONTROL      4  // Write: DMA_CTRL_* flags, 0 aborts
+#define DMA_PORT_VECTOR       5  // Completion interrupt vector (0 = none)
+#define DMA_PORT_STATUS       6  // Read: DMA_STATUS_*
+#define DMA_PORT_REMAINING    7  // Read: bytes not yet transferred
+#define DMA_CHANNEL_PORTS     8
+#define DMA_PORT_COUNT        (DMA_CHANNELS * DMA_CHANNEL_PORTS)
+
+// Control flags
+#define DMA_CTRL_START        0x01  // Start the transfer
+#define DMA_CTRL_SRC_PORT     0x02  // Source is an I/O port (device-to-memory)
+#define DMA_CTRL_DST_PORT     0x04  // Destination is an I/O port (memory-to-device)
+
+// Channel status
+#define DMA_STATUS_IDLE       0
+#define DMA_STATUS_BUSY       1
+#define DMA_STATUS_DONE       2
+#define DMA_STATUS_ERROR      3  // Range outside guest memory or not accessible
+
+// Transfer pacing: bytes moved per chunk and instructions between chunks
+#define DMA_CHUNK_SIZE        256
+#define DMA_CHUNK_INTERVAL    16
+
+// Overlapping contiguous memory-to-memory transfers behave like one memmove
+// of the whole range: when the destination starts inside the source, chunks
+// are copied from the end. Strided transfers copy element by element, first
+// to last, so an overlap sees elements already written.
+
+// Device lifecycle
+int io_attach_dma(VM *vm, uint16_t base_port);
+
+#endif // _DMA_H_
@@ -0,0 +1,37 @@
+#ifndef _EVENTS_H_
+#define _EVENTS_H_
+
+#include "vm_types.h"
+
+// Deadlines are expressed in virtual time (executed instruction count).
+// Comparisons use a signed difference so the 32-bit counter may wrap.
+#define EVENTS_IDLE_HORIZON 0x40000000  // Re-check interval when the queue is empty
+
+// Callback invoked when a scheduled event becomes due
+typedef void (*EventCallback)(VM *vm, void *data);
+
+// Event queue lifecycle
+int events_init(VM *vm);
+void events_cleanup(VM *vm);
+
+// Schedule a callback 'delay' instructions from now
+int events_schedule(VM *vm, uint32_t delay, EventCallback callback, void *data);
+
+// Remove every pending event matching callback and data
+void events_cancel(VM *vm, EventCallback callback, void *data);
+
+// Instructions until the first pending event matching callback and data
+// (0 if already due), or -1 if there is none. Devices save this in snapshots.
+int64_t events_remaining(VM *vm, EventCallback callback, void *data);
+
+// Move every pending deadline by delta instructions, for when the
+// instruction count jumps (snapshot restore, vm_reset)
+void events_shift(VM *vm, uint32_t delta);
+
+// Run all events whose deadline has been reached
+void events_dispatch(VM *vm);
+
+// Fast check used by the run loop: has the earliest deadline been reached?
+#define EVENTS_DUE(vm) ((int32_t)((vm)->instruction_count - (vm)->next_event) >= 0)
+
+#endif // _EVENTS_H_
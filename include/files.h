@@ -0,0 +1,50 @@
+#ifndef _FILES_H_
+#define _FILES_H_
+
+#include "vm_types.h"
+
+// Guest file handles are 1..FILES_MAX_HANDLES; 0 is never valid
+#define FILES_MAX_HANDLES     32
+#define FILES_MAX_PATH        256
+
+// Open modes (syscall 10, param2)
+#define FILE_MODE_READ        0  // Read only
+#define FILE_MODE_WRITE       1  // Write, create or truncate
+#define FILE_MODE_APPEND      2  // Append, create if missing
+#define FILE_MODE_READWRITE   3  // Read and write an existing file
+
+// Seek origins (syscall 14, param3)
+#define FILE_SEEK_SET         0
+#define FILE_SEEK_CUR         1
+#define FILE_SEEK_END         2
+
+// Stat buffer layout written by syscall 15 (three dwords)
+#define FILE_STAT_SIZE        0  // File size in bytes
+#define FILE_STAT_MTIME       4  // Modification time, seconds since the epoch
+#define FILE_STAT_TYPE        8  // FILE_TYPE_*
+#define FILE_STAT_BYTES       12
+
+#define FILE_TYPE_REGULAR     0
+#define FILE_TYPE_DIRECTORY   1
+#define FILE_TYPE_OTHER       2
+
+// Lifecycle
+int files_init(VM *vm);
+void files_cleanup(VM *vm);
+
+// Restrict guest paths to a host directory (default: current directory)
+int files_set_root(VM *vm, const char *root);
+
+// Close every guest handle (done on RESET)
+void files_close_all(VM *vm);
+
+// Syscall backends; return -1 on failure. A bad guest buffer also sets
+// vm->last_error, which the caller propagates as a fault.
+int32_t files_open(VM *vm, uint16_t path_addr, uint8_t mode);
+int32_t files_close(VM *vm, uint32_t handle);
+int32_t files_read(VM *vm, uint32_t handle, uint16_t buffer_addr, uint16_t count);
+int32_t files_write(VM *vm, uint32_t handle, uint16_t buffer_addr, uint16_t count);
+int32_t files_seek(VM *vm, uint32_t handle, int32_t offset, uint32_t origin);
+int32_t files_stat(VM *vm, uint16_t path_addr, uint16_t buffer_addr);
+
+#endif // _FILES_H_
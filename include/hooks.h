@@ -0,0 +1,51 @@
+#ifndef _HOOKS_H_
+#define _HOOKS_H_
+
+#include "vm_types.h"
+
+#define HOOKS_MAX 8  // Hook sets registered at once
+
+// Instrumentation callbacks. Any member may be NULL. Addresses are guest
+// addresses; 'from' is the address of the instruction that transferred
+// control. Memory reads are reported before the access and writes after
+// it, so a write hook can look at the new value (vm_guest_ptr).
+typedef struct {
+    void (*instruction)(VM *vm, uint16_t pc, const Instruction *instr, void *data);
+    void (*memory_read)(VM *vm, uint16_t address, uint16_t size, void *data);
+    void (*memory_write)(VM *vm, uint16_t address, uint16_t size, void *data);
+    void (*branch)(VM *vm, uint16_t from, uint16_t to, void *data);   // Taken jumps and loops
+    void (*call)(VM *vm, uint16_t from, uint16_t to, void *data);
+    void (*ret)(VM *vm, uint16_t from, uint16_t to, void *data);
+    void (*syscall)(VM *vm, uint16_t number, void *data);             // Before the call
+    void (*interrupt)(VM *vm, uint8_t vector, void *data);            // Handler entry
+    void (*alloc)(VM *vm, uint16_t address, uint16_t size, void *data);
+    void (*free)(VM *vm, uint16_t address, void *data);
+} VMHooks;
+
+// Register a hook set; 'hooks' must stay valid until it is removed. The run
+// loop picks its engine when a run starts (vm_run, vm_run_for,
+// vm_run_until): with no hooks registered it runs the plain interpreter,
+// which has no hook calls at all, otherwise an instrumented copy of it.
+int hooks_add(VM *vm, const VMHooks *hooks, void *data);
+
+// Remove the set registered with this hooks and data
+void hooks_remove(VM *vm, const VMHooks *hooks, void *data);
+
+// Non-zero while any set is registered
+int hooks_active(VM *vm);
+
+void hooks_cleanup(VM *vm);
+
+// Calls from the instrumented engine, one per event kind
+void hooks_instruction(VM *vm, uint16_t pc, const Instruction *instr);
+void hooks_memory_read(VM *vm, uint16_t address, uint16_t size);
+void hooks_memory_write(VM *vm, uint16_t address, uint16_t size);
+void hooks_branch(VM *vm, uint16_t from, uint16_t to);
+void hooks_call(VM *vm, uint16_t from, uint16_t to);
+void hooks_ret(VM *vm, uint16_t from, uint16_t to);
+void hooks_syscall(VM *vm, uint16_t number);
+void hooks_interrupt(VM *vm, uint8_t vector);
+void hooks_alloc(VM *vm, uint16_t address, uint16_t size);
+void hooks_free(VM *vm, uint16_t address);
+
+#endif // _HOOKS_H_
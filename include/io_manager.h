@@ -0,0 +1,85 @@
+#ifndef _IO_MANAGER_H_
+#define _IO_MANAGER_H_
+
+#include <stddef.h>
+#include "vm_types.h"
+
+// I/O Device Types
+#define IO_DEVICE_CONSOLE     0
+#define IO_DEVICE_DISK        1
+#define IO_DEVICE_TIMER       2
+#define IO_DEVICE_PIC         3
+#define IO_DEVICE_DMA         4
+#define IO_DEVICE_VRING       5
+#define IO_DEVICE_CHANNEL     6
+#define IO_DEVICE_CUSTOM      100
+
+// Initial size of the device table (grows on demand)
+#define IO_INITIAL_DEVICES    16
+
+// Standard port assignments
+#define IO_PORT_CONSOLE       0x0000
+#define IO_PORT_TIMER         0x0008
+#define IO_PORT_DISK          0x0010
+#define IO_PORT_PIC           0x0020
+#define IO_PORT_DMA           0x0030
+#define IO_PORT_VRING         0x0050
+#define IO_PORT_CHANNEL       0x0060
+
+// I/O device structure
+typedef struct {
+    uint8_t  type;            // Device type
+    uint16_t base_port;       // Base I/O port
+    uint16_t port_range;      // Number of ports used
+    void    *device_data;     // Device-specific data
+
+    // Device operations
+    int     (*init)(VM *vm, void *device_data);
+    void    (*cleanup)(VM *vm, void *device_data);
+    uint32_t (*read)(VM *vm, void *device_data, uint16_t port);
+    void     (*write)(VM *vm, void *device_data, uint16_t port, uint32_t value);
+
+    // Snapshot support (optional): save stores the guest-visible state in
+    // buffer and returns its length, restore takes it back. Host resources
+    // (files, sockets, threads) stay as they are.
+    size_t   (*save)(VM *vm, void *device_data, uint8_t *buffer, size_t size);
+    int      (*restore)(VM *vm, void *device_data, const uint8_t *buffer, size_t len);
+
+    // Reset support (optional): return the guest-visible state to power-on
+    // and cancel the device's pending events
+    void     (*reset)(VM *vm, void *device_data);
+} IODevice;
+
+// Largest device state in a snapshot
+#define IO_STATE_MAX          4096
+
+// I/O system lifecycle
+int io_init(VM *vm);
+void io_cleanup(VM *vm);
+
+// Device registration and port access
+int io_add_device(VM *vm, IODevice *device);
+uint32_t io_read(VM *vm, uint16_t port);
+void io_write(VM *vm, uint16_t port, uint32_t value);
+
+// Device state for snapshots: one record per device with a save callback.
+// Restore matches records to devices by type and base port.
+int io_save_state(VM *vm, FILE *file);
+int io_restore_state(VM *vm, FILE *file);
+
+// Return every device with a reset callback to its power-on state
+void io_reset(VM *vm);
+
+// Status information for debugging
+void io_get_status(VM *vm, char *buffer, size_t buffer_size);
+
+// Standard devices
+int io_attach_console(VM *vm, uint16_t base_port);
+int io_attach_timer(VM *vm, uint16_t base_port);
+int io_attach_pic(VM *vm, uint16_t base_port);
+int io_attach_dma(VM *vm, uint16_t base_port);
+int io_attach_vring(VM *vm, uint16_t base_port);
+int io_attach_channel(VM *vm, uint16_t base_port);
+int io_attach_disk(VM *vm, uint16_t base_port, const char *image_path);
+
+#endif // _IO_MANAGER_H_
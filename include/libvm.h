@@ -0,0 +1,125 @@
+#ifndef _LIBVM_H_
+#define _LIBVM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Embedding API, built as libvm.a and libvm.so by 'make lib'. The VM is an
+// opaque handle: hosts include only this header and never see its layout,
+// so they keep working across changes to the VM's internals. Each VM is
+// independent; run different VMs on different threads, one VM per thread.
+// Functions returning int give 0 on success or a VM error code, described
+// by vm_get_error_message. Link with -lvm -lpthread -ldl.
+typedef struct VM VM;
+
+// Host allocator for the VM and its guest memory (the large allocations)
+typedef struct {
+    void *(*alloc)(size_t size, void *user_data);
+    void (*free)(void *ptr, void *user_data);
+    void *user_data;
+} VMAllocator;
+
+// Guest console output (console port 0, syscalls 0-9 and 50-59)
+typedef void (*VMOutputFn)(VM *vm, const char *data, size_t len, void *user_data);
+
+// Host syscall: args holds R0, R5, R6, R7 at the time of the call. Results
+// go in registers (vm_set_register). Returns 0, or an error code to fault
+// the SYSCALL instruction.
+typedef int (*VMSyscallFn)(VM *vm, const uint32_t *args);
+
+// Memory-mapped device callbacks: offset is relative to the region base,
+// size is the access size (1, 2 or 4)
+typedef uint32_t (*VMMmioReadFn)(VM *vm, void *data, uint16_t offset, uint8_t size);
+typedef void (*VMMmioWriteFn)(VM *vm, void *data, uint16_t offset, uint8_t size, uint32_t value);
+
+// Ring device queues: the guest posts filled buffers on TX and empty
+// buffers on RX
+#define VM_RING_TX 0
+#define VM_RING_RX 1
+
+// A buffer taken from a ring queue
+typedef struct {
+    uint16_t id;                   // Descriptor index, handed back to vm_ring_push
+    uint16_t addr;                 // Guest address of the buffer
+    uint16_t len;                  // Buffer length in bytes
+    uint8_t *data;                 // Host pointer to the buffer
+} VMRingBuffer;
+
+// Called when the guest notifies a ring queue of new buffers
+typedef void (*VMRingNotifyFn)(VM *vm, int queue, void *data);
+
+// Settings for vm_create; a zeroed struct gives the defaults
+typedef struct {
+    uint32_t memory_size;          // Guest memory in bytes (0 = 64 KB)
+    const VMAllocator *allocator;  // NULL = malloc/free
+    VMOutputFn output;             // NULL = stdout
+    void *output_data;             // Passed to output
+    FILE *log;                     // Loader and runtime messages (NULL = silent)
+    void *user_data;               // Returned by vm_get_user_data
+} VMConfig;
+
+// Lifecycle; vm_create returns NULL if the VM can't be set up
+VM *vm_create(const VMConfig *config);
+void vm_destroy(VM *vm);
+
+// Guest console input (console port 0, syscalls 3, 4 and 52) comes from a
+// host descriptor, which the VM does not close. A new VM has no input, so
+// its reads see the end of input; -1 goes back to that. Give each VM its
+// own descriptor: VMs reading the same one take bytes from each other.
+int vm_set_input_fd(VM *vm, int fd);
+
+// Load a program image (the assembler's output) from memory or a file
+int vm_load_program(VM *vm, const uint8_t *program, uint32_t size);
+int vm_load_program_file(VM *vm, const char *filename);
+
+// Run at most count instructions, or until the program halts. A host
+// event loop can call this with a budget per turn.
+int vm_run_for(VM *vm, uint32_t count);
+int vm_run(VM *vm);
+int vm_halted(VM *vm);
+uint32_t vm_get_instruction_count(VM *vm);
+
+// Install or replace a syscall; may_block flushes console output first
+int vm_register_syscall(VM *vm, uint16_t number, const char *name, uint8_t arg_count,
+                        uint8_t may_block, VMSyscallFn handler);
+
+// Registers R0-R15, and checked access to guest memory. vm_guest_ptr
+// returns NULL if 'size' bytes at 'address' are outside memory or lack the
+// access (VM_ACCESS_* flags, or-ed together).
+#define VM_ACCESS_READ  1
+#define VM_ACCESS_WRITE 2
+#define VM_ACCESS_EXEC  4
+uint32_t vm_get_register(VM *vm, unsigned int reg);
+void vm_set_register(VM *vm, unsigned int reg, uint32_t value);
+uint8_t *vm_guest_ptr(VM *vm, uint16_t address, uint16_t size, uint8_t access);
+
+// Route the guest's loads and stores in [base, base + size) to a device
+// instead of memory. Regions may not overlap; up to 16 can be mapped.
+int vm_mmio_map(VM *vm, uint16_t base, uint16_t size, VMMmioReadFn read,
+                VMMmioWriteFn write, void *data);
+void vm_mmio_unmap(VM *vm, uint16_t base);
+
+// Host side of the ring device (ports 0x50-0x58). Take buffers with
+// vm_ring_pop (1 if one was available), return them with vm_ring_push, then
+// vm_ring_flush publishes the pushed entries with one interrupt. The send
+// and receive helpers copy one message and return its length, or -1 if no
+// buffer is available; they don't flush.
+int vm_ring_pop(VM *vm, int queue, VMRingBuffer *buffer);
+int vm_ring_push(VM *vm, int queue, uint16_t id, uint16_t len);
+void vm_ring_flush(VM *vm);
+void vm_ring_set_notify(VM *vm, VMRingNotifyFn notify, void *data);
+int vm_ring_send(VM *vm, const void *data, uint16_t len);
+int vm_ring_receive(VM *vm, void *data, uint16_t size);
+
+// Load a native plugin, which binds its functions to syscalls (up to 8 per
+// VM). Plugins are unloaded by vm_destroy.
+int vm_load_plugin(VM *vm, const char *path);
+
+void *vm_get_user_data(VM *vm);
+
+// Last error
+int vm_get_last_error(VM *vm);
+const char *vm_get_error_message(VM *vm);
+
+#endif // _LIBVM_H_
@@ -4,18 +4,27 @@
 #include "vm_types.h"
 
 // Memory protection constants
-#define PROT_NONE  0x00     // No access permissions
-#define PROT_READ  0x01     // Read permission
-#define PROT_WRITE 0x02     // Write permission
-#define PROT_EXEC  0x04     // Execute permission
+#define VM_PROT_NONE  0x00     // No access permissions
+#define VM_PROT_READ  0x01     // Read permission
+#define VM_PROT_WRITE 0x02     // Write permission
+#define VM_PROT_EXEC  0x04     // Execute permission
 
 // Internal memory management functions
 int memory_init(VM *vm, uint32_t size);
 void memory_cleanup(VM *vm);
 
+// Replace memory with a copy-on-write mapping of size bytes of fd at offset
+// (page-aligned). Pages are read from the file on first touch.
+int memory_map_image(VM *vm, int fd, uint64_t offset, uint32_t size);
+
 // Memory access functions with bounds checking
 int memory_check_address(VM *vm, uint16_t address, uint16_t size);
 int memory_check_address_permissions(VM *vm, uint16_t address, uint16_t size, uint8_t required_perm);
+
+// Bytes from address to the end of the range one checked access could
+// cover: the heap start or end of memory below the heap, the end of the
+// allocated block inside it, 0 if address is outside memory or in no block
+uint32_t memory_accessible_span(VM *vm, uint16_t address);
 uint8_t* memory_get_ptr(VM *vm, uint16_t address);
 
 // Low-level memory operations
@@ -0,0 +1,25 @@
+#ifndef _MMIO_H_
+#define _MMIO_H_
+
+#include "vm_types.h"
+
+#define MMIO_MAX_REGIONS      16
+
+// Device callbacks; offset is relative to the region base, size is 1, 2 or 4
+typedef uint32_t (*MmioReadFn)(VM *vm, void *data, uint16_t offset, uint8_t size);
+typedef void (*MmioWriteFn)(VM *vm, void *data, uint16_t offset, uint8_t size, uint32_t value);
+
+// Fast check used by the memory accessors: one compare against the span
+// covering all regions. Addresses outside it take the direct-memory path.
+#define MMIO_HIT(vm, address) ((uint32_t)((address) - (vm)->mmio_base) < (vm)->mmio_span)
+
+// Region management
+int mmio_map(VM *vm, uint16_t base, uint16_t size, MmioReadFn read, MmioWriteFn write, void *data);
+void mmio_unmap(VM *vm, uint16_t base);
+void mmio_cleanup(VM *vm);
+
+// Slow path for addresses inside the span; return 0 if no region claims the access
+int mmio_read(VM *vm, uint16_t address, uint8_t size, uint32_t *value);
+int mmio_write(VM *vm, uint16_t address, uint8_t size, uint32_t value);
+
+#endif // _MMIO_H_
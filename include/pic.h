@@ -0,0 +1,32 @@
+#ifndef _PIC_H_
+#define _PIC_H_
+
+#include "vm_types.h"
+
+#define PIC_NUM_VECTORS       256
+
+// PIC port offsets (relative to the device base port)
+#define PIC_PORT_SELECT       0  // Vector addressed by the other ports
+#define PIC_PORT_PRIORITY     1  // Priority of the selected vector (higher wins)
+#define PIC_PORT_MASK         2  // 1 = selected vector masked
+#define PIC_PORT_PENDING      3  // Read: selected vector pending, Write: 1 = raise, 0 = clear
+#define PIC_PORT_COUNT        4
+
+// Device lifecycle
+int io_attach_pic(VM *vm, uint16_t base_port);
+
+// Interrupt lines used by devices
+void pic_raise(VM *vm, uint8_t vector);
+void pic_lower(VM *vm, uint8_t vector);
+
+// Configuration
+void pic_set_priority(VM *vm, uint8_t vector, uint8_t priority);
+void pic_set_mask(VM *vm, uint8_t vector, int masked);
+
+// Re-evaluate pending interrupts after the interrupt flag changes
+void pic_update(VM *vm);
+
+// Deliver the highest-priority pending interrupt (called when vm->irq_pending is set)
+void pic_service(VM *vm);
+
+#endif // _PIC_H_
@@ -0,0 +1,21 @@
+#ifndef _PLUGIN_H_
+#define _PLUGIN_H_
+
+#include "vm_types.h"
+
+#define PLUGIN_MAX            8
+#define PLUGIN_INIT_SYMBOL    "vm_plugin_init"
+
+// Entry point every plugin exports. It binds its functions to syscall
+// numbers with vm_register_syscall and returns 0 on success. Plugins
+// include only libvm.h: the VM's internal headers and struct layout can
+// change, and a host using libvm.so exports nothing else.
+typedef int (*PluginInitFn)(VM *vm);
+
+// Load a shared object and run its init function
+int plugins_load(VM *vm, const char *path);
+
+// Unload all plugins; the syscall table must no longer reference them
+void plugins_unload(VM *vm);
+
+#endif // _PLUGIN_H_
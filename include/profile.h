@@ -0,0 +1,29 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include "vm_types.h"
+
+// Sampling profiler. A virtual-time event samples the guest PC every
+// 'interval' instructions on average (with jitter, so loops whose period
+// divides the interval are not always caught at the same point). Each
+// sample is charged to the call stack at that moment, kept as a shadow
+// stack from the CALL, RET and interrupt hooks. Frames are named from the
+// symbol table, so load the program with vm->load_symbols set.
+#define PROFILE_DEFAULT_INTERVAL 1000
+#define PROFILE_STACK_MAX        64    // Deeper frames are counted but not kept
+#define PROFILE_TOP              20    // Rows in each table of profile_report
+
+// Start sampling the VM; call after the program is loaded
+int profile_start(VM *vm, uint32_t interval);
+
+// Write the samples as folded stacks ("main;fn;leaf count" per line), the
+// input format of flamegraph.pl
+int profile_write_folded(VM *vm, const char *path);
+
+// Log the 'top' functions and source lines with the most samples
+void profile_report(VM *vm, int top);
+
+// Stop sampling and drop the samples
+void profile_stop(VM *vm);
+
+#endif // _PROFILE_H_
@@ -0,0 +1,23 @@
+#ifndef _RANDOM_H_
+#define _RANDOM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// xoshiro256** generator; the state is four 64-bit words and must not be all zero
+#define RANDOM_STATE_WORDS    4
+#define RANDOM_DEFAULT_SEED   0x12345678
+
+// Expand a seed into a full state with splitmix64
+void random_seed(uint64_t *state, uint64_t seed);
+
+// Next 64 random bits
+uint64_t random_next(uint64_t *state);
+
+// Uniform value in [0, bound), without modulo bias; bound 0 means the full 32 bits
+uint32_t random_below(uint64_t *state, uint32_t bound);
+
+// Fill a buffer with random bytes, a full 64-bit output per step
+void random_fill(uint64_t *state, uint8_t *buffer, size_t size);
+
+#endif // _RANDOM_H_
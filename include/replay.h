@@ -0,0 +1,72 @@
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include "vm_types.h"
+
+// Record/replay of nondeterministic inputs. While recording, every value the
+// VM takes from the host (clock readings, console input, file syscall
+// results, channel and socket data) is appended to a log together with the
+// instruction count at which it was taken. On playback the host is not
+// consulted; the logged values are fed back at the same points, so the run
+// is bit-identical. A run that leaves the recorded path stops with
+// VM_ERROR_REPLAY.
+#define REPLAY_OFF            0
+#define REPLAY_RECORD         1
+#define REPLAY_PLAYBACK       2
+
+#define REPLAYING(vm)         ((vm)->replay_mode == REPLAY_PLAYBACK)
+
+// Log file: magic, version, clock mode and initial random state, then records:
+//   kind (1 byte), instruction count delta (varint), then
+//   value kinds:  change from the last value of the kind (zigzag varint)
+//   event kinds:  calls not logged since the last record (varint), value change
+//   data kinds:   length (varint) and the bytes
+#define REPLAY_MAGIC          "VMRL"
+#define REPLAY_VERSION        1
+#define REPLAY_BUFFER_SIZE    65536
+
+// Kind flags; the low six bits number the kind
+#define REPLAY_DATA           0x80  // Carries a byte string
+#define REPLAY_EVENT          0x40  // Only nonzero values are logged
+#define REPLAY_KIND_MASK      0x3F
+#define REPLAY_KINDS          64
+
+// Record kinds
+#define REPLAY_CLOCK          0x01  // Host clock reading in nanoseconds
+#define REPLAY_SLEEP          0x02  // Sleep that input can end early: -1, 0 or 1
+#define REPLAY_CONSOLE_CHAR   0x03  // Console input byte, or EOF
+#define REPLAY_CONSOLE_LINE   0x04  // Console line length, or -1
+#define REPLAY_CONSOLE_STATUS 0x05  // Console bytes available, flags, or poller use
+#define REPLAY_FILE           0x06  // File syscall result
+#define REPLAY_CHANNEL        0x07  // Channel transfer count, status or port value
+#define REPLAY_SOCKET         0x08  // Bytes sent to the ring bridge socket, or -1
+#define REPLAY_CONSOLE_EVENT  (REPLAY_EVENT | 0x09)  // Input interrupt check (CONSOLE_EVENT_*)
+#define REPLAY_SOCKET_ACCEPT  (REPLAY_EVENT | 0x0A)  // Bridge client connected
+#define REPLAY_SOCKET_RECEIVE (REPLAY_EVENT | 0x0B)  // Bytes received from the bridge, or -1
+#define REPLAY_LINE_DATA      (REPLAY_DATA | 0x0C)   // Console line bytes
+#define REPLAY_FILE_DATA      (REPLAY_DATA | 0x0D)   // Bytes read from a file
+#define REPLAY_CHANNEL_DATA   (REPLAY_DATA | 0x0E)   // Bytes read from a channel
+#define REPLAY_SOCKET_DATA    (REPLAY_DATA | 0x0F)   // Bytes received from the bridge
+
+// Start recording to, or playing back from, a log. Playback restores the
+// clock mode and random state saved in the log. Call after the program is
+// loaded and before it runs.
+int replay_start(VM *vm, const char *path, int mode);
+
+// Close the log; on playback, warns if records were left unused
+void replay_stop(VM *vm);
+
+// Record a value, or on playback return the logged one (value is ignored)
+int64_t replay_value(VM *vm, uint8_t kind, int64_t value);
+
+// Record len bytes, or on playback copy the logged bytes into data, which
+// must hold len. The length is checked against the log.
+void replay_data(VM *vm, uint8_t kind, void *data, uint32_t len);
+
+// Take a host value through the log. The host expression is not evaluated
+// on playback, and costs nothing extra when replay is off.
+#define REPLAY_VALUE(vm, kind, expr) \
+    ((vm)->replay_mode == REPLAY_OFF ? (int64_t)(expr) : \
+     replay_value((vm), (kind), REPLAYING(vm) ? 0 : (int64_t)(expr)))
+
+#endif // _REPLAY_H_
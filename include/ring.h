@@ -0,0 +1,31 @@
+#ifndef _RING_H_
+#define _RING_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+// Single-producer/single-consumer lock-free byte ring.
+// One thread may call ring_write, one other thread may call
+// ring_peek/ring_consume; no locking is needed between them.
+typedef struct {
+    uint8_t *buffer;
+    uint32_t capacity;           // Always a power of two
+    _Atomic uint32_t head;       // Total bytes written (producer owned)
+    _Atomic uint32_t tail;       // Total bytes consumed (consumer owned)
+} Ring;
+
+// Lifecycle
+int ring_init(Ring *ring, uint32_t capacity);
+void ring_free(Ring *ring);
+
+// Bytes currently stored
+uint32_t ring_used(Ring *ring);
+
+// Producer: copy up to len bytes in, returns the number stored
+uint32_t ring_write(Ring *ring, const uint8_t *data, uint32_t len);
+
+// Consumer: get the largest contiguous readable span, then release it
+uint32_t ring_peek(Ring *ring, const uint8_t **data);
+void ring_consume(Ring *ring, uint32_t len);
+
+#endif // _RING_H_
@@ -0,0 +1,23 @@
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include "vm_types.h"
+
+// Snapshot file: header, CPU and VM-wide state, device states (see
+// io_save_state), then the memory image at a page-aligned offset. Zero
+// pages are left as holes, so the file is sparse, and restore maps the
+// image copy-on-write instead of reading it. Fields are in host byte order.
+#define SNAPSHOT_MAGIC        "VMSS"
+#define SNAPSHOT_VERSION      1
+#define SNAPSHOT_ALIGN        65536  // Memory image offset; a multiple of any host page size
+#define SNAPSHOT_PAGE         4096   // Unit for skipping zero memory
+
+// Save the VM's state to path. Guest output is flushed first; open guest
+// files, console input not yet read and channel connections are not saved.
+int snapshot_save(VM *vm, const char *path);
+
+// Replace the VM's state with a snapshot. The VM must have the devices the
+// snapshot has state for; guest file handles are closed.
+int snapshot_restore(VM *vm, const char *path);
+
+#endif // _SNAPSHOT_H_
@@ -0,0 +1,30 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include "vm_types.h"
+
+// Execution statistics: instructions per opcode and per addressing mode,
+// taken and not-taken branches, memory accesses per segment and syscalls
+// per number, collected through the instrumentation hooks.
+//
+// Host time is attributed like syscall latency (see syscalls.h): reading
+// the clock around every instruction would cost more than most
+// instructions, so one instruction in about STATS_TIMING_INTERVAL is timed,
+// from its hook to the next instruction's, and each opcode's total is
+// extrapolated from its timed share. The cost of the clock reads is
+// measured at start and subtracted.
+#define STATS_TIMING_INTERVAL 16
+
+// Start counting; call after the program is loaded
+int stats_start(VM *vm);
+
+// Log the tables, hottest opcodes first
+void stats_report(VM *vm);
+
+// Write the counters as JSON
+int stats_write_json(VM *vm, const char *path);
+
+// Stop counting and drop the counters
+void stats_stop(VM *vm);
+
+#endif // _STATS_H_
@@ -0,0 +1,59 @@
+#ifndef _SYSCALLS_H_
+#define _SYSCALLS_H_
+
+#include <stdio.h>
+#include "vm_types.h"
+
+/**
+ * Syscall conventions:
+ * - Syscall number is in immediate field of instruction
+ * - Parameters are passed in registers R0_ACC, R5, R6, R7
+ * - Return value is placed in R0_ACC
+ * - Error code is placed in R5 (0 = success)
+ */
+#define SYSCALL_TABLE_SIZE    256  // Valid syscall numbers are 0-255
+#define SYSCALL_BUILTIN_LIMIT 70   // Numbers below this belong to the built-in groups
+#define SYSCALL_NAME_LENGTH   24
+
+// Reading the host clock costs more than a simple syscall, so non-blocking
+// syscalls are timed once every SYSCALL_TIMING_INTERVAL calls and the total
+// is extrapolated. Blocking syscalls are always timed.
+#define SYSCALL_TIMING_INTERVAL 16
+
+// Handler: args holds R0_ACC, R5, R6, R7 at the time of the call (R5 is
+// cleared before the handler runs). Returns VM_ERROR_NONE, or an error code
+// to fault the SYSCALL instruction.
+typedef int (*SyscallHandler)(VM *vm, const uint32_t *args);
+
+// Table entry with metadata and statistics
+typedef struct {
+    SyscallHandler handler;
+    char     name[SYSCALL_NAME_LENGTH];
+    uint8_t  arg_count;       // Registers used as parameters
+    uint8_t  may_block;       // Console output is flushed before the call
+    uint64_t calls;           // Number of invocations
+    uint64_t timed_calls;     // Invocations that were timed
+    uint64_t timed_ns;        // Host time spent in the timed invocations
+} SyscallEntry;
+
+// Table lifecycle; syscalls_init installs the built-in syscalls
+int syscalls_init(VM *vm);
+void syscalls_cleanup(VM *vm);
+
+// Install or replace a syscall
+int syscalls_register(VM *vm, uint16_t number, const char *name, uint8_t arg_count,
+                      uint8_t may_block, SyscallHandler handler);
+
+// Execute a syscall from the SYSCALL instruction
+int syscalls_dispatch(VM *vm, uint16_t number);
+
+// Entry for a number, or NULL if none is registered
+const SyscallEntry *syscalls_lookup(VM *vm, uint16_t number);
+
+// Estimated cumulative host time spent in a syscall
+uint64_t syscalls_total_ns(const SyscallEntry *entry);
+
+// Print invocation counts and latency of every syscall used so far
+void syscalls_print_stats(VM *vm, FILE *out);
+
+#endif // _SYSCALLS_H_
@@ -0,0 +1,26 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+// Timer device port offsets (relative to the device base port)
+#define TIMER_PORT_COUNTER    0  // Write: period, Read: remaining until expiry
+#define TIMER_PORT_CONTROL    1  // Write: 0=stop, 1=start, 2=reset
+#define TIMER_PORT_MODE       2  // Mode flags (TIMER_MODE_*)
+#define TIMER_PORT_VECTOR     3  // Interrupt vector raised on expiry
+#define TIMER_PORT_EXPIRED    4  // Read: expiration count, Write: clear
+#define TIMER_PORT_COUNT      5
+
+// Control commands
+#define TIMER_CMD_STOP        0
+#define TIMER_CMD_START       1
+#define TIMER_CMD_RESET       2
+
+// Mode flags
+#define TIMER_MODE_PERIODIC   0x01  // Reload after expiry (otherwise one-shot)
+#define TIMER_MODE_WALLCLOCK  0x02  // Period in microseconds of clock time (host or virtual)
+
+#define TIMER_DEFAULT_VECTOR  8
+
+// Instruction interval between clock checks in wall-clock mode
+#define TIMER_WALL_POLL_INTERVAL 256
+
+#endif // _TIMER_H_
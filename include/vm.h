@@ -3,15 +3,22 @@
 
 #include "vm_types.h"
 #include "instruction_set.h"
+#include "syscalls.h"
 
 // VM lifecycle functions
 int vm_init(VM *vm, uint32_t memory_size);
+// As vm_init, with guest memory from alloc/release (both NULL = malloc/free)
+int vm_init_with_allocator(VM *vm, uint32_t memory_size,
+                           void *(*alloc)(size_t size, void *data),
+                           void (*release)(void *ptr, void *data), void *data);
 void vm_cleanup(VM *vm);
 int vm_reset(VM *vm);
 
 // VM execution functions
 int vm_run(VM *vm);                       // Run until halted
 int vm_step(VM *vm);                      // Execute single instruction
+int vm_run_for(VM *vm, uint32_t count);   // Run at most count instructions
+int vm_run_until(VM *vm, int64_t count, int32_t address);  // Run to a count or PC (-1 = no limit)
 int vm_execute_instruction(VM *vm);       // Execute current instruction at PC
 
 // Memory operations
@@ -38,6 +45,14 @@ void vm_pop_all_registers(VM *vm);
 int vm_io_read(VM *vm, uint16_t port);
 void vm_io_write(VM *vm, uint16_t port, uint32_t value);
 
+// Host extensions: install a syscall (see syscalls.h for the handler contract)
+int vm_register_syscall(VM *vm, uint16_t number, const char *name, uint8_t arg_count,
+                        uint8_t may_block, SyscallHandler handler);
+
+// Checked pointer to 'size' bytes of guest memory with the given PROT_* access;
+// returns NULL and records a fault if the range is invalid
+uint8_t *vm_guest_ptr(VM *vm, uint16_t address, uint16_t size, uint8_t access);
+
 // Interrupt handling
 void vm_interrupt(VM *vm, uint8_t vector);
 void vm_set_interrupt_handler(VM *vm, uint8_t vector, uint16_t handler_address);
@@ -51,6 +66,12 @@ void vm_clear_breakpoint(VM *vm, uint16_t address);
 int vm_load_program(VM *vm, const uint8_t *program, uint32_t size);
 int vm_load_program_file(VM *vm, const char *filename);
 
+// Host log for loader and runtime messages, kept apart from guest output
+// (which goes to the console sink, see console.h). Defaults to stdout;
+// NULL silences it.
+void vm_set_log(VM *vm, FILE *stream);
+void vm_log(VM *vm, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
 // Error handling
 const char* vm_get_error_string(int error_code);
 int vm_get_last_error(VM *vm);
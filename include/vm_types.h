@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <stdbool.h>
 
 // Register definitions
@@ -33,6 +34,9 @@
 #define HEAP_SEGMENT_BASE   0xC000
 #define HEAP_SEGMENT_SIZE   0x4000
 
+// Fast interrupt entry: number of nested interrupts served from shadow banks
+#define SHADOW_BANK_DEPTH   4
+
 // Special stack frame offsets
 #define FRAME_PREV_BP_OFFSET    0
 #define FRAME_RET_ADDR_OFFSET   4
@@ -85,25 +89,69 @@ typedef struct {
     uint16_t immediate;      // 12-bit immediate/offset
 } Instruction;
 
-// Virtual Machine state
-typedef struct {
+// Virtual Machine state (opaque to embedders, see libvm.h)
+typedef struct VM {
     // CPU registers
     uint32_t registers[16];  // R0-R15
     
     // Memory
     uint8_t *memory;         // Main memory array
     uint32_t memory_size;    // Total size of memory
+    uint8_t memory_mapped;   // Memory is a private mapping of a snapshot file
+    void *(*memory_alloc)(size_t size, void *data);  // Host allocator for memory (NULL = malloc)
+    void (*memory_free)(void *ptr, void *data);
+    void *allocator_data;
+    void *mmio;              // Memory-mapped device regions (defined in mmio.c)
+    uint32_t mmio_base;      // Lowest address routed to MMIO checks
+    uint32_t mmio_span;      // Size of the checked range (0 = no regions)
     
     // VM state flags
     uint8_t halted;          // VM halted flag
     uint8_t debug_mode;      // Debug mode flag
+    uint8_t load_symbols;    // Load the symbol table outside debug mode (to resolve labels)
+    FILE *log_stream;        // Host log for loader and runtime messages (NULL = silent)
+    void *user_data;         // Embedder's pointer, not used by the VM
     
     // I/O state
-    void *io_devices;        // I/O devices structure (defined in io_devices.h)
+    void *io_devices;        // I/O devices structure (defined in io_manager.c)
+    void *console;           // Console output state (defined in console.c)
+    void *files;             // Guest file descriptor table (defined in files.c)
+    void *disk;              // Block device state (defined in disk.c)
+    void *vring;             // Shared-memory ring device (defined in vring.c)
+    void *vring_bridge;      // Socket bridge for the ring device (defined in vring_bridge.c)
+    void *channel;           // Streams to and from other VMs (defined in channel.c)
+    void *syscalls;          // Syscall table (SyscallEntry array, see syscalls.h)
+    void *plugins;           // Loaded native plugins (defined in plugin.c)
+    void *hooks;             // Instrumentation hooks (defined in hooks.c)
+    void *profile;           // Sampling profiler (defined in profile.c)
+    void *stats;             // Execution statistics (defined in stats.c)
+    uint64_t *coverage;      // Executed code addresses, one bit each (see coverage.h)
+    
+    // Guest random number generator (xoshiro256**, see random.h)
+    uint64_t random_state[4];
+    
+    // Guest clock (see clock.h)
+    uint8_t clock_mode;         // CLOCK_MODE_REAL or CLOCK_MODE_VIRTUAL
+    uint64_t clock_base_ns;     // Real: host time at start; virtual: time at clock_base_count
+    uint32_t clock_base_count;  // Instruction count the virtual time is measured from
+    
+    // Record/replay of host inputs (see replay.h)
+    uint8_t replay_mode;        // REPLAY_OFF, REPLAY_RECORD or REPLAY_PLAYBACK
+    void *replay;               // Open log (defined in replay.c)
+    
+    // Event scheduling
+    void *event_queue;          // Pending device events (defined in events.c)
+    uint32_t next_event;        // Instruction count of the earliest pending event
     
     // Interrupt state
     uint32_t interrupt_vector;  // Current interrupt vector
     uint8_t interrupt_enabled;  // Interrupt enable status
+    void *pic;                  // Interrupt controller state (defined in pic.c)
+    uint8_t irq_pending;        // Set when a device interrupt can be delivered
+    uint8_t fast_interrupts;    // Save context in shadow banks instead of the stack
+    uint8_t interrupt_depth;    // Interrupt handlers currently active
+    uint8_t shadow_depth;       // Shadow banks currently in use
+    uint32_t shadow_registers[SHADOW_BANK_DEPTH][16]; // Saved register banks
     
     // Instruction cycle info for debugging
     uint32_t instruction_count; // Number of instructions executed
@@ -132,5 +180,6 @@ typedef struct {
 #define VM_ERROR_IO_ERROR             11 // I/O operation error
 #define VM_ERROR_PROTECTION_FAULT     12 // Memory protection fault
 #define VM_ERROR_NESTED_INTERRUPT     13 // Nested interrupt
+#define VM_ERROR_REPLAY               14 // Run left the recorded path
 
 #endif // _VM_TYPES_H_
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef _VRING_H_
+#define _VRING_H_
+
+#include "vm_types.h"
+
+// Queues: the guest posts filled buffers on TX and empty buffers on RX
+#define VRING_QUEUE_TX        0  // Guest -> host
+#define VRING_QUEUE_RX        1  // Host -> guest
+#define VRING_QUEUES          2
+#define VRING_MAX_SIZE        256
+
+// Port offsets (relative to the device base port)
+#define VRING_PORT_SELECT     0  // Queue addressed by the ports below
+#define VRING_PORT_SIZE       1  // Number of entries, a power of two up to VRING_MAX_SIZE
+#define VRING_PORT_DESC       2  // Guest address of the descriptor table
+#define VRING_PORT_AVAIL      3  // Guest address of the available ring
+#define VRING_PORT_USED       4  // Guest address of the used ring
+#define VRING_PORT_ENABLE     5  // Write 1: enable (checks the layout), 0: disable and reset indices
+#define VRING_PORT_NOTIFY     6  // Write a queue number: new available entries
+#define VRING_PORT_VECTOR     7  // Interrupt vector raised when used entries are published (0 = none)
+#define VRING_PORT_STATUS     8  // Read: bit n set if queue n has new used entries; reading clears
+#define VRING_PORT_COUNT      9
+
+// Guest memory layout, all fields 16-bit little-endian:
+//   descriptor table: size x { addr, len }
+//   available ring:   { flags, idx, ring[size] }   written by the guest
+//   used ring:        { flags, idx, ring[size] x { id, len } }   written by the host
+// The idx fields count entries ever added and wrap at 16 bits.
+#define VRING_DESC_SIZE       4
+#define VRING_AVAIL_SIZE(n)   (4 + 2 * (n))
+#define VRING_USED_SIZE(n)    (4 + 4 * (n))
+
+// Available ring flags
+#define VRING_AVAIL_NO_INTERRUPT 0x0001  // Guest is polling; don't interrupt for this queue
+
+// Default interrupt vector for completions
+#define VRING_DEFAULT_VECTOR  0
+
+// A buffer taken from a queue's available ring
+typedef struct {
+    uint16_t id;              // Descriptor index, handed back to vring_push
+    uint16_t addr;            // Guest address of the buffer
+    uint16_t len;             // Buffer length in bytes
+    uint8_t *data;            // Host pointer to the buffer
+} VringBuffer;
+
+// Called when the guest writes the notify port
+typedef void (*VringNotifyFn)(VM *vm, int queue, void *data);
+
+// Device lifecycle
+int io_attach_vring(VM *vm, uint16_t base_port);
+
+// Host side. Take buffers with vring_pop, return them with vring_push, then
+// vring_flush publishes all pushed entries and raises one interrupt for the batch.
+int vring_pop(VM *vm, int queue, VringBuffer *buffer);
+int vring_push(VM *vm, int queue, uint16_t id, uint16_t len);
+void vring_flush(VM *vm);
+void vring_set_notify(VM *vm, VringNotifyFn notify, void *data);
+
+// Message helpers built on the calls above; both return the byte count or -1
+// if no buffer is available. Neither flushes.
+int vring_send(VM *vm, const void *data, uint16_t len);
+int vring_receive(VM *vm, void *data, uint16_t size);
+
+// Unix-domain socket bridge: frames are a 16-bit little-endian length and payload.
+// Incoming frames fill RX buffers, TX buffers are written out as frames.
+#define VRING_BRIDGE_POLL_INTERVAL 512
+int vring_bridge_open(VM *vm, const char *path);
+void vring_bridge_close(VM *vm);
+
+#endif // _VRING_H_
@@ -0,0 +1,35 @@
+/**
+ * Example plugin: FNV-1a hashing as syscall 200
+ *
+ * Build with "make plugins" and run with:
+ *     ./vm -p plugins/fnv_hash.so program.bin
+ *
+ * Syscall 200: R0_ACC = buffer address, R5 = length -> R0_ACC = 32-bit hash
+ *
+ * Like every plugin it uses only the API in libvm.h.
+ */
+#include "libvm.h"
+
+#define FNV_SYSCALL           200
+#define FNV_OFFSET_BASIS      0x811C9DC5u
+#define FNV_PRIME             0x01000193u
+
+static int fnv_hash(VM *vm, const uint32_t *args) {
+    uint16_t length = args[1];
+    const uint8_t *data = vm_guest_ptr(vm, args[0], length, VM_ACCESS_READ);
+    if (!data && length > 0) {
+        return vm_get_last_error(vm);
+    }
+
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (uint16_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * FNV_PRIME;
+    }
+
+    vm_set_register(vm, 0, hash);
+    return 0;
+}
+
+int vm_plugin_init(VM *vm) {
+    return vm_register_syscall(vm, FNV_SYSCALL, "fnv_hash", 2, 0, fnv_hash);
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include "vm_types.h"
+#include "events.h"
+#include "clock.h"
+#include "replay.h"
+
+// Host monotonic time in nanoseconds
+static uint64_t clock_host_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Instructions since the last rebase, converted to virtual nanoseconds
+static uint64_t clock_virtual_ns(VM *vm) {
+    uint32_t executed = vm->instruction_count - vm->clock_base_count;
+    return vm->clock_base_ns + (uint64_t)executed * CLOCK_VIRTUAL_NS_PER_INSTRUCTION;
+}
+
+static void clock_rebase(VM *vm, void *data) {
+    vm->clock_base_ns = clock_virtual_ns(vm);
+    vm->clock_base_count = vm->instruction_count;
+    events_schedule(vm, CLOCK_REBASE_INTERVAL, clock_rebase, NULL);
+}
+
+void clock_init(VM *vm, uint8_t mode) {
+    vm->clock_mode = mode;
+    vm->clock_base_count = vm->instruction_count;
+    events_cancel(vm, clock_rebase, NULL);
+
+    if (mode == CLOCK_MODE_VIRTUAL) {
+        vm->clock_base_ns = 0;
+        events_schedule(vm, CLOCK_REBASE_INTERVAL, clock_rebase, NULL);
+    } else {
+        vm->clock_base_ns = clock_host_ns();
+    }
+}
+
+void clock_restore(VM *vm, uint8_t mode, uint64_t ns) {
+    clock_init(vm, mode);
+    if (mode == CLOCK_MODE_VIRTUAL) {
+        vm->clock_base_ns = ns;
+    } else {
+        vm->clock_base_ns -= ns;
+    }
+}
+
+uint64_t clock_now_ns(VM *vm) {
+    if (vm->clock_mode == CLOCK_MODE_VIRTUAL) {
+        return clock_virtual_ns(vm);
+    }
+    return (uint64_t)REPLAY_VALUE(vm, REPLAY_CLOCK, clock_host_ns() - vm->clock_base_ns);
+}
+
+void clock_sleep_ns(VM *vm, uint64_t ns) {
+    if (vm->clock_mode == CLOCK_MODE_VIRTUAL) {
+        vm->clock_base_ns = clock_virtual_ns(vm) + ns;
+        vm->clock_base_count = vm->instruction_count;
+        return;
+    }
+
+    // On playback the logged clock readings already include the sleep
+    if (REPLAYING(vm)) {
+        return;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        // Interrupted by a signal; sleep for the rest
+    }
+}
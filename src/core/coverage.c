@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include "vm.h"
+#include "coverage.h"
+
+typedef struct {
+    char     magic[4];
+    uint32_t version;
+    uint32_t bits;
+    uint32_t reserved;
+} CoverageHeader;
+
+// A source line and whether any of its addresses ran
+typedef struct {
+    uint32_t line_num;
+    uint8_t hit;
+} CoverageLine;
+
+static int coverage_fail(VM *vm, const char *path, const char *what) {
+    vm->last_error = VM_ERROR_IO_ERROR;
+    snprintf(vm->error_message, sizeof(vm->error_message),
+             "Coverage '%s': %s", path, what);
+    return VM_ERROR_IO_ERROR;
+}
+
+int coverage_start(VM *vm) {
+    if (!vm) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    if (!vm->coverage) {
+        vm->coverage = (uint64_t *)malloc(COVERAGE_WORDS * sizeof(uint64_t));
+        if (!vm->coverage) {
+            vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "Failed to allocate coverage bitmap");
+            return VM_ERROR_MEMORY_ALLOCATION;
+        }
+    }
+    memset(vm->coverage, 0, COVERAGE_WORDS * sizeof(uint64_t));
+    return VM_ERROR_NONE;
+}
+
+void coverage_merge(VM *vm, uint64_t *into) {
+    if (!vm || !vm->coverage || !into) {
+        return;
+    }
+
+    for (int i = 0; i < COVERAGE_WORDS; i++) {
+        if (vm->coverage[i]) {
+            __atomic_fetch_or(&into[i], vm->coverage[i], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+int coverage_merge_file(VM *vm, const char *path, uint64_t *bits) {
+    if (!vm || !path || !bits) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return coverage_fail(vm, path, strerror(errno));
+    }
+    if (flock(fd, LOCK_EX) != 0) {
+        int error = errno;
+        close(fd);
+        return coverage_fail(vm, path, strerror(error));
+    }
+
+    CoverageHeader header;
+    uint64_t saved[COVERAGE_WORDS];
+    ssize_t got = pread(fd, &header, sizeof(header), 0);
+
+    // A file that was just created is empty; anything else must be a bitmap
+    if (got != 0) {
+        if (got != (ssize_t)sizeof(header) ||
+            memcmp(header.magic, COVERAGE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != COVERAGE_VERSION || header.bits != COVERAGE_BITS ||
+            pread(fd, saved, sizeof(saved), sizeof(header)) != (ssize_t)sizeof(saved)) {
+            close(fd);
+            return coverage_fail(vm, path, "not a coverage bitmap from this version");
+        }
+        for (int i = 0; i < COVERAGE_WORDS; i++) {
+            bits[i] |= saved[i];
+        }
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COVERAGE_MAGIC, sizeof(header.magic));
+    header.version = COVERAGE_VERSION;
+    header.bits = COVERAGE_BITS;
+
+    int ok = pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+             pwrite(fd, bits, COVERAGE_WORDS * sizeof(uint64_t), sizeof(header)) ==
+                 (ssize_t)(COVERAGE_WORDS * sizeof(uint64_t));
+    int error = errno;
+
+    // Closing releases the lock
+    if (close(fd) != 0 || !ok) {
+        return coverage_fail(vm, path, ok ? strerror(errno) : strerror(error));
+    }
+    return VM_ERROR_NONE;
+}
+
+static int coverage_line_compare(const void *a, const void *b) {
+    const CoverageLine *x = (const CoverageLine *)a;
+    const CoverageLine *y = (const CoverageLine *)b;
+    return x->line_num < y->line_num ? -1 : x->line_num > y->line_num;
+}
+
+// Instructions in the code segment that belong to a source file
+static int coverage_counts(const SourceLine *line) {
+    const char *source = line->source;
+    if (!line->source_file || line->address >= COVERAGE_BITS || !source) {
+        return 0;
+    }
+    while (*source == ' ' || *source == '\t') {
+        source++;
+    }
+    return *source != '\0' && *source != '.';  // Skip directives
+}
+
+int coverage_write_lcov(VM *vm, const char *path, const uint64_t *bits) {
+    if (!vm || !path || !bits) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    DebugInfo *info = vm->debug_info;
+    if (!info || !info->source_line_count) {
+        vm->last_error = VM_ERROR_INVALID_ADDRESS;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Coverage needs the program's debug information");
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    CoverageLine *lines = (CoverageLine *)malloc(info->source_line_count * sizeof(CoverageLine));
+    uint8_t *written = (uint8_t *)calloc(info->source_line_count, 1);
+    if (!lines || !written) {
+        free(lines);
+        free(written);
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate coverage lines");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        free(lines);
+        free(written);
+        return coverage_fail(vm, path, strerror(errno));
+    }
+
+    // One record per source file, in order of first appearance
+    fprintf(file, "TN:\n");
+    for (uint32_t first = 0; first < info->source_line_count; first++) {
+        SourceLine *start = &info->source_lines[first];
+        if (written[first] || !coverage_counts(start)) {
+            continue;
+        }
+
+        uint32_t count = 0;
+        for (uint32_t i = first; i < info->source_line_count; i++) {
+            SourceLine *line = &info->source_lines[i];
+            if (!written[i] && coverage_counts(line) &&
+                strcmp(line->source_file, start->source_file) == 0) {
+                lines[count].line_num = line->line_num;
+                lines[count].hit = (uint8_t)COVERAGE_HIT(bits, line->address);
+                count++;
+                written[i] = 1;
+            }
+        }
+        qsort(lines, count, sizeof(CoverageLine), coverage_line_compare);
+
+        // A line with several addresses is hit if any of them ran
+        uint32_t found = 0;
+        uint32_t hit = 0;
+        fprintf(file, "SF:%s\n", start->source_file);
+        for (uint32_t i = 0; i < count; i++) {
+            uint8_t line_hit = lines[i].hit;
+            while (i + 1 < count && lines[i + 1].line_num == lines[i].line_num) {
+                line_hit |= lines[++i].hit;
+            }
+            fprintf(file, "DA:%u,%u\n", lines[i].line_num, line_hit);
+            found++;
+            hit += line_hit;
+        }
+        fprintf(file, "LF:%u\nLH:%u\nend_of_record\n", found, hit);
+    }
+
+    free(lines);
+    free(written);
+    if (fclose(file) != 0) {
+        return coverage_fail(vm, path, strerror(errno));
+    }
+    return VM_ERROR_NONE;
+}
+
+void coverage_stop(VM *vm) {
+    if (vm && vm->coverage) {
+        free(vm->coverage);
+        vm->coverage = NULL;
+    }
+}
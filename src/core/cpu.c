@@ -5,6 +5,8 @@
 #include "instruction_set.h"
 #include "decoder.h"
 #include "vm.h"
+#include "pic.h"
+#include "hooks.h"
 
 // CPU initialization
 int cpu_init(VM *vm) {
@@ -33,6 +35,10 @@ int cpu_init(VM *vm) {
     vm->instruction_count = 0;
     vm->last_error = VM_ERROR_NONE;
     
+    // No interrupt handlers active
+    vm->interrupt_depth = 0;
+    vm->shadow_depth = 0;
+    
     return VM_ERROR_NONE;
 }
 
@@ -352,8 +358,17 @@ void cpu_interrupt(VM *vm, uint8_t vector) {
     // Save current interrupt vector
     vm->interrupt_vector = vector;
     
-    // Save current execution context
-    vm_push_all_registers(vm);
+    // Save current execution context. In fast mode the outermost levels swap
+    // to a shadow bank; deeper nesting falls back to the stack
+    if (vm->fast_interrupts && vm->shadow_depth < SHADOW_BANK_DEPTH &&
+        vm->shadow_depth == vm->interrupt_depth) {
+        memcpy(vm->shadow_registers[vm->shadow_depth++], vm->registers, sizeof(vm->registers));
+    } else {
+        vm_push_all_registers(vm);
+    }
+    if (vm->interrupt_depth < UINT8_MAX) {
+        vm->interrupt_depth++;
+    }
     
     // Disable interrupts while in interrupt handler
     vm->registers[R4_SR] &= ~INT_FLAG;
@@ -376,6 +391,11 @@ void cpu_interrupt(VM *vm, uint8_t vector) {
     }
     // Jump to handler
     vm->registers[R3_PC] = handler_addr;
+    
+    // Interrupts are rare enough to check for hooks here, in both engines
+    if (vm->hooks) {
+        hooks_interrupt(vm, vector);
+    }
 }
 
 
@@ -383,10 +403,23 @@ void cpu_return_from_interrupt(VM *vm) {
     if (!vm) {
         return;
     }
-    vm_pop_all_registers(vm);
+    
+    if (vm->interrupt_depth > 0) {
+        vm->interrupt_depth--;
+    }
+    
+    // Levels at or below the shadow depth were saved in a bank
+    if (vm->shadow_depth > 0 && vm->interrupt_depth < vm->shadow_depth) {
+        memcpy(vm->registers, vm->shadow_registers[--vm->shadow_depth], sizeof(vm->registers));
+    } else {
+        vm_pop_all_registers(vm);
+    }
     
     // Clear current interrupt vector
     vm->interrupt_vector = 0;
+    
+    // Restored flags may re-enable interrupts that were held pending
+    pic_update(vm);
 }
 
 void cpu_enable_interrupts(VM *vm) {
@@ -396,6 +429,9 @@ void cpu_enable_interrupts(VM *vm) {
     
     vm->registers[R4_SR] |= INT_FLAG;
     vm->interrupt_enabled = 1;  // Also update the VM state
+    
+    // Deliver interrupts raised while disabled
+    pic_update(vm);
 }
 
 void cpu_disable_interrupts(VM *vm) {
@@ -405,6 +441,7 @@ void cpu_disable_interrupts(VM *vm) {
     
     vm->registers[R4_SR] &= ~INT_FLAG;
     vm->interrupt_enabled = 0;  // Also update the VM state
+    vm->irq_pending = 0;
 }
 
 int cpu_execute_instruction(VM *vm, Instruction *instr) {
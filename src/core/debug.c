@@ -1,5 +1,6 @@
 #include <debug.h>
 #include <stdio.h>
+#include "vm.h"
 
 void load_debug_symbols(VM *vm, const uint8_t *data, uint32_t size) {
     if (!vm || !data || size < 4) {
@@ -20,7 +21,7 @@ void load_debug_symbols(VM *vm, const uint8_t *data, uint32_t size) {
     uint32_t symbol_count = *((uint32_t*)ptr);
     ptr += 4;
     
-    printf("Loading %u symbols...\n", symbol_count);
+    vm_log(vm, "Loading %u symbols...\n", symbol_count);
     
     // Allocate symbol array
     vm->debug_info->symbols = (Symbol*)malloc(symbol_count * sizeof(Symbol));
@@ -94,7 +95,7 @@ void load_debug_symbols(VM *vm, const uint8_t *data, uint32_t size) {
     uint32_t line_count = *((uint32_t*)ptr);
     ptr += 4;
     
-    printf("Loading %u source lines...\n", line_count);
+    vm_log(vm, "Loading %u source lines...\n", line_count);
     
     // Allocate source line array
     vm->debug_info->source_lines = (SourceLine*)malloc(line_count * sizeof(SourceLine));
@@ -150,9 +151,9 @@ void load_debug_symbols(VM *vm, const uint8_t *data, uint32_t size) {
         uint16_t file_len = *((uint16_t*)ptr);
         ptr += 2;
         
-        // Source file path
+        // Source file path; the last line's path ends the section
         if (file_len > 0) {
-            if (ptr + file_len >= data + size) break;
+            if (ptr + file_len > data + size) break;
             
             // Check if we've already seen this path
             char temp_path[512] = {0};
@@ -193,7 +194,7 @@ void load_debug_symbols(VM *vm, const uint8_t *data, uint32_t size) {
             if (file_index == -1 && file_count < 100) {
                 file_paths[file_count] = strdup(temp_path);
                 file_index = file_count++;
-                printf("New source file %d: %s (basename: %s)\n", 
+                vm_log(vm, "New source file %d: %s (basename: %s)\n", 
                        file_index, file_paths[file_index], basename);
             }
             
@@ -216,7 +217,7 @@ void load_debug_symbols(VM *vm, const uint8_t *data, uint32_t size) {
         
         // Display debug info for every 100th line
         if (i % 100 == 0) {
-            printf("Source line %d: addr=0x%04X file=%s line=%d src=%s\n", 
+            vm_log(vm, "Source line %d: addr=0x%04X file=%s line=%d src=%s\n", 
                    i, line->address, 
                    line->source_file ? line->source_file : "(none)",
                    line->line_num,
@@ -229,7 +230,7 @@ void load_debug_symbols(VM *vm, const uint8_t *data, uint32_t size) {
         free(file_paths[i]);
     }
     
-    printf("Debug symbols loaded: %u symbols, %u source lines\n", 
+    vm_log(vm, "Debug symbols loaded: %u symbols, %u source lines\n", 
            vm->debug_info->symbol_count, vm->debug_info->source_line_count);
 }
 
@@ -290,13 +291,29 @@ Symbol* find_symbol_by_address(VM *vm, uint32_t address) {
     return closest;
 }
 
+// Find a symbol by exact name
+Symbol* find_symbol_by_name(VM *vm, const char *name) {
+    if (!vm || !vm->debug_info || !name) {
+        return NULL;
+    }
+    
+    for (uint32_t i = 0; i < vm->debug_info->symbol_count; i++) {
+        Symbol *sym = &vm->debug_info->symbols[i];
+        if (sym->name && strcmp(sym->name, name) == 0) {
+            return sym;
+        }
+    }
+    
+    return NULL;
+}
+
 void debug_print_source_info(VM *vm) {
     if (!vm || !vm->debug_info) {
-        printf("No debug information available\n");
+        vm_log(vm, "No debug information available\n");
         return;
     }
     
-    printf("\n--- Debug Source Files Info ---\n");
+    vm_log(vm, "\n--- Debug Source Files Info ---\n");
     int unique_files = 0;
     char *previous_file = NULL;
     
@@ -307,35 +324,35 @@ void debug_print_source_info(VM *vm) {
         if (line->source_file && (!previous_file || 
             strcmp(line->source_file, previous_file) != 0)) {
             
-            printf("Source file at addr 0x%04X: '%s'\n", 
+            vm_log(vm, "Source file at addr 0x%04X: '%s'\n", 
                    line->address, line->source_file);
             
             previous_file = line->source_file;
             unique_files++;
             
             // Print the first line from this file
-            printf("  Sample line: %s\n", line->source ? line->source : "(empty)");
+            vm_log(vm, "  Sample line: %s\n", line->source ? line->source : "(empty)");
         }
     }
     
-    printf("Found %d unique source files among %d source lines\n", 
+    vm_log(vm, "Found %d unique source files among %d source lines\n", 
            unique_files, vm->debug_info->source_line_count);
 }
 
 void debug_dump_source_mapping(VM *vm) {
     if (!vm || !vm->debug_info) {
-        printf("No debug information available\n");
+        vm_log(vm, "No debug information available\n");
         return;
     }
     
-    printf("\n=== SOURCE MAPPING DUMP ===\n");
+    vm_log(vm, "\n=== SOURCE MAPPING DUMP ===\n");
     
     // Count and display unique source files
-    printf("Source files in debug info:\n");
+    vm_log(vm, "Source files in debug info:\n");
     int unique_files = 0;
     char **file_list = malloc(sizeof(char*) * vm->debug_info->source_line_count);
     if (!file_list) {
-        printf("Memory allocation error\n");
+        vm_log(vm, "Memory allocation error\n");
         return;
     }
     
@@ -355,26 +372,26 @@ void debug_dump_source_mapping(VM *vm) {
         
         if (!found) {
             file_list[unique_files++] = line->source_file;
-            printf("  %d: %s\n", unique_files, line->source_file);
+            vm_log(vm, "  %d: %s\n", unique_files, line->source_file);
         }
     }
     
-    printf("Total unique source files: %d\n\n", unique_files);
+    vm_log(vm, "Total unique source files: %d\n\n", unique_files);
     free(file_list);
     
     // Show some sample address to source mappings
-    printf("Sample address mappings:\n");
+    vm_log(vm, "Sample address mappings:\n");
     for (uint32_t i = 0; i < vm->debug_info->source_line_count && i < 20; i++) {
         SourceLine *line = &vm->debug_info->source_lines[i];
-        printf("  0x%04X -> Line %4d in %-20s: %s\n", 
+        vm_log(vm, "  0x%04X -> Line %4d in %-20s: %s\n", 
                line->address, 
                line->line_num,
                line->source_file ? line->source_file : "(none)",
                line->source ? line->source : "(none)");
     }
     
-    printf("... %d more mappings ...\n", vm->debug_info->source_line_count - 20);
-    printf("=== END SOURCE MAPPING ===\n\n");
+    vm_log(vm, "... %d more mappings ...\n", vm->debug_info->source_line_count - 20);
+    vm_log(vm, "=== END SOURCE MAPPING ===\n\n");
 }
 
 // Function to find source line by address
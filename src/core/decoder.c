@@ -218,18 +218,23 @@ void vm_disassemble_instruction(VM *vm, Instruction *instr, char *buffer, size_t
             
         case IN_OP:
             // Reg, Port
-            snprintf(operands, sizeof(operands), "R%d, 0x%03X", 
-                     instr->reg1, instr->immediate);
+            if (instr->mode == REG_MODE) {
+                snprintf(operands, sizeof(operands), "R%d, R%d", 
+                         instr->reg1, instr->reg2);
+            } else {
+                snprintf(operands, sizeof(operands), "R%d, 0x%04X", 
+                         instr->reg1, instr->immediate);
+            }
             break;
             
         case OUT_OP:
-            // Port, Reg/Imm
-            if (instr->mode == IMM_MODE) {
-                snprintf(operands, sizeof(operands), "0x%03X, 0x%03X", 
-                         instr->reg1, instr->immediate);
+            // Port, Reg
+            if (instr->mode == REG_MODE) {
+                snprintf(operands, sizeof(operands), "R%d, R%d", 
+                         instr->reg2, instr->reg1);
             } else {
-                snprintf(operands, sizeof(operands), "0x%03X, R%d", 
-                         instr->reg1, instr->reg2);
+                snprintf(operands, sizeof(operands), "0x%04X, R%d", 
+                         instr->immediate, instr->reg1);
             }
             break;
             
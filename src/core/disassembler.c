@@ -137,16 +137,22 @@ void disassemble_instruction(uint32_t address, uint32_t instruction) {
         // I/O operations
         case IN_OP:
             print_register(reg1, 1);
-            printf(", 0x%04X", immediate);
+            if (mode == REG_MODE) {
+                printf(", ");
+                print_register(reg2, 1);
+            } else {
+                printf(", 0x%04X", immediate);
+            }
             break;
             
         case OUT_OP:
-            printf("0x%03X, ", reg1);
-            if (mode == IMM_MODE) {
-                printf("0x%04X", immediate);
-            } else {
+            if (mode == REG_MODE) {
                 print_register(reg2, 1);
+                printf(", ");
+            } else {
+                printf("0x%04X, ", immediate);
             }
+            print_register(reg1, 1);
             break;
             
         // Loop instruction
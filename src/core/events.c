@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "events.h"
+
+// A single scheduled event
+typedef struct {
+    uint32_t deadline;       // Instruction count at which the event fires
+    uint32_t sequence;       // Insertion order, keeps equal deadlines FIFO
+    EventCallback callback;  // Function to invoke
+    void *data;              // Callback argument
+} Event;
+
+// Binary min-heap of events ordered by deadline
+typedef struct {
+    Event *heap;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t next_sequence;
+} EventQueue;
+
+#define EVENTS_INITIAL_CAPACITY 16
+
+// Return non-zero if event a must run before event b
+static int event_before(const Event *a, const Event *b) {
+    int32_t diff = (int32_t)(a->deadline - b->deadline);
+    if (diff != 0) {
+        return diff < 0;
+    }
+    return (int32_t)(a->sequence - b->sequence) < 0;
+}
+
+static void heap_swap(Event *heap, uint32_t i, uint32_t j) {
+    Event tmp = heap[i];
+    heap[i] = heap[j];
+    heap[j] = tmp;
+}
+
+static void heap_sift_up(EventQueue *queue, uint32_t index) {
+    while (index > 0) {
+        uint32_t parent = (index - 1) / 2;
+        if (!event_before(&queue->heap[index], &queue->heap[parent])) {
+            break;
+        }
+        heap_swap(queue->heap, index, parent);
+        index = parent;
+    }
+}
+
+static void heap_sift_down(EventQueue *queue, uint32_t index) {
+    for (;;) {
+        uint32_t left = index * 2 + 1;
+        uint32_t right = left + 1;
+        uint32_t smallest = index;
+
+        if (left < queue->count && event_before(&queue->heap[left], &queue->heap[smallest])) {
+            smallest = left;
+        }
+        if (right < queue->count && event_before(&queue->heap[right], &queue->heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        heap_swap(queue->heap, index, smallest);
+        index = smallest;
+    }
+}
+
+// Remove the event at the given heap position
+static void heap_remove(EventQueue *queue, uint32_t index) {
+    queue->count--;
+    if (index == queue->count) {
+        return;
+    }
+    queue->heap[index] = queue->heap[queue->count];
+    heap_sift_down(queue, index);
+    heap_sift_up(queue, index);
+}
+
+// Recompute the cached earliest deadline checked by the run loop
+static void events_update_next(VM *vm, EventQueue *queue) {
+    if (queue->count > 0) {
+        vm->next_event = queue->heap[0].deadline;
+    } else {
+        vm->next_event = vm->instruction_count + EVENTS_IDLE_HORIZON;
+    }
+}
+
+// Initialize the event queue
+int events_init(VM *vm) {
+    if (!vm) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    EventQueue *queue = (EventQueue *)calloc(1, sizeof(EventQueue));
+    if (!queue) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate event queue");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    vm->event_queue = queue;
+    events_update_next(vm, queue);
+
+    return VM_ERROR_NONE;
+}
+
+// Free the event queue
+void events_cleanup(VM *vm) {
+    if (!vm || !vm->event_queue) {
+        return;
+    }
+
+    EventQueue *queue = (EventQueue *)vm->event_queue;
+    free(queue->heap);
+    free(queue);
+    vm->event_queue = NULL;
+}
+
+// Schedule a callback to run after 'delay' more instructions
+int events_schedule(VM *vm, uint32_t delay, EventCallback callback, void *data) {
+    if (!vm || !vm->event_queue || !callback) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    EventQueue *queue = (EventQueue *)vm->event_queue;
+
+    // Grow the heap if needed
+    if (queue->count >= queue->capacity) {
+        uint32_t new_capacity = queue->capacity ? queue->capacity * 2 : EVENTS_INITIAL_CAPACITY;
+        Event *new_heap = (Event *)realloc(queue->heap, new_capacity * sizeof(Event));
+        if (!new_heap) {
+            vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "Failed to grow event queue");
+            return VM_ERROR_MEMORY_ALLOCATION;
+        }
+        queue->heap = new_heap;
+        queue->capacity = new_capacity;
+    }
+
+    // Deadlines further out than the signed comparison window are clamped
+    if (delay >= 0x80000000) {
+        delay = 0x7FFFFFFF;
+    }
+
+    Event *event = &queue->heap[queue->count];
+    event->deadline = vm->instruction_count + delay;
+    event->sequence = queue->next_sequence++;
+    event->callback = callback;
+    event->data = data;
+    queue->count++;
+    heap_sift_up(queue, queue->count - 1);
+
+    events_update_next(vm, queue);
+    return VM_ERROR_NONE;
+}
+
+// Cancel all pending events with the given callback and data
+void events_cancel(VM *vm, EventCallback callback, void *data) {
+    if (!vm || !vm->event_queue) {
+        return;
+    }
+
+    EventQueue *queue = (EventQueue *)vm->event_queue;
+    uint32_t i = 0;
+    while (i < queue->count) {
+        if (queue->heap[i].callback == callback && queue->heap[i].data == data) {
+            heap_remove(queue, i);
+            // Re-examine the element moved into this slot
+            i = 0;
+            continue;
+        }
+        i++;
+    }
+
+    events_update_next(vm, queue);
+}
+
+// Instructions until the first pending event with the given callback and data
+int64_t events_remaining(VM *vm, EventCallback callback, void *data) {
+    if (!vm || !vm->event_queue) {
+        return -1;
+    }
+
+    EventQueue *queue = (EventQueue *)vm->event_queue;
+    const Event *first = NULL;
+    for (uint32_t i = 0; i < queue->count; i++) {
+        const Event *event = &queue->heap[i];
+        if (event->callback == callback && event->data == data &&
+            (!first || event_before(event, first))) {
+            first = event;
+        }
+    }
+
+    if (!first) {
+        return -1;
+    }
+    int32_t remaining = (int32_t)(first->deadline - vm->instruction_count);
+    return remaining > 0 ? remaining : 0;
+}
+
+// A uniform shift keeps the heap order, since deadlines compare by difference
+void events_shift(VM *vm, uint32_t delta) {
+    if (!vm || !vm->event_queue) {
+        return;
+    }
+
+    EventQueue *queue = (EventQueue *)vm->event_queue;
+    for (uint32_t i = 0; i < queue->count; i++) {
+        queue->heap[i].deadline += delta;
+    }
+    events_update_next(vm, queue);
+}
+
+// Run every event that is due; callbacks may schedule new events
+void events_dispatch(VM *vm) {
+    if (!vm || !vm->event_queue) {
+        return;
+    }
+
+    EventQueue *queue = (EventQueue *)vm->event_queue;
+    while (queue->count > 0 &&
+           (int32_t)(vm->instruction_count - queue->heap[0].deadline) >= 0) {
+        Event event = queue->heap[0];
+        heap_remove(queue, 0);
+        event.callback(vm, event.data);
+    }
+
+    events_update_next(vm, queue);
+}
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hooks.h"
+
+// Registered hook sets, in registration order
+typedef struct {
+    const VMHooks *hooks[HOOKS_MAX];
+    void *data[HOOKS_MAX];
+    int count;
+} HookTable;
+
+int hooks_add(VM *vm, const VMHooks *hooks, void *data) {
+    if (!vm || !hooks) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    HookTable *table = (HookTable *)vm->hooks;
+    if (!table) {
+        table = (HookTable *)calloc(1, sizeof(HookTable));
+        if (!table) {
+            vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "Failed to allocate hook table");
+            return VM_ERROR_MEMORY_ALLOCATION;
+        }
+        vm->hooks = table;
+    }
+
+    if (table->count >= HOOKS_MAX) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Too many hook sets (maximum %d)", HOOKS_MAX);
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    table->hooks[table->count] = hooks;
+    table->data[table->count] = data;
+    table->count++;
+    return VM_ERROR_NONE;
+}
+
+void hooks_remove(VM *vm, const VMHooks *hooks, void *data) {
+    HookTable *table = vm ? (HookTable *)vm->hooks : NULL;
+    if (!table) {
+        return;
+    }
+
+    // The table itself stays allocated: a hook may remove its own set
+    // while the engine is walking the table
+    for (int i = 0; i < table->count; i++) {
+        if (table->hooks[i] == hooks && table->data[i] == data) {
+            memmove(&table->hooks[i], &table->hooks[i + 1], (table->count - i - 1) * sizeof(table->hooks[0]));
+            memmove(&table->data[i], &table->data[i + 1], (table->count - i - 1) * sizeof(table->data[0]));
+            table->count--;
+            return;
+        }
+    }
+}
+
+int hooks_active(VM *vm) {
+    HookTable *table = vm ? (HookTable *)vm->hooks : NULL;
+    return table && table->count > 0;
+}
+
+void hooks_cleanup(VM *vm) {
+    if (vm && vm->hooks) {
+        free(vm->hooks);
+        vm->hooks = NULL;
+    }
+}
+
+// Call 'member' of every set that has it
+#define HOOKS_CALL(vm, member, ...)                                          \
+    do {                                                                     \
+        HookTable *table = (HookTable *)(vm)->hooks;                         \
+        for (int i = 0; table && i < table->count; i++) {                    \
+            if (table->hooks[i]->member) {                                   \
+                table->hooks[i]->member((vm), __VA_ARGS__, table->data[i]);  \
+            }                                                                \
+        }                                                                    \
+    } while (0)
+
+void hooks_instruction(VM *vm, uint16_t pc, const Instruction *instr) {
+    HOOKS_CALL(vm, instruction, pc, instr);
+}
+
+void hooks_memory_read(VM *vm, uint16_t address, uint16_t size) {
+    HOOKS_CALL(vm, memory_read, address, size);
+}
+
+void hooks_memory_write(VM *vm, uint16_t address, uint16_t size) {
+    HOOKS_CALL(vm, memory_write, address, size);
+}
+
+void hooks_branch(VM *vm, uint16_t from, uint16_t to) {
+    HOOKS_CALL(vm, branch, from, to);
+}
+
+void hooks_call(VM *vm, uint16_t from, uint16_t to) {
+    HOOKS_CALL(vm, call, from, to);
+}
+
+void hooks_ret(VM *vm, uint16_t from, uint16_t to) {
+    HOOKS_CALL(vm, ret, from, to);
+}
+
+void hooks_syscall(VM *vm, uint16_t number) {
+    HOOKS_CALL(vm, syscall, number);
+}
+
+void hooks_interrupt(VM *vm, uint8_t vector) {
+    HOOKS_CALL(vm, interrupt, vector);
+}
+
+void hooks_alloc(VM *vm, uint16_t address, uint16_t size) {
+    HOOKS_CALL(vm, alloc, address, size);
+}
+
+void hooks_free(VM *vm, uint16_t address) {
+    HOOKS_CALL(vm, free, address);
+}
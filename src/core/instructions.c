@@ -5,6 +5,23 @@
 #include "memory.h"
 #include "instruction_set.h"
 #include "vm_types.h"
+#include "io_manager.h"
+#include "pic.h"
+#include "console.h"
+#include "files.h"
+#include "syscalls.h"
+
+// This file is compiled twice. The plain build is the default engine; the
+// second build (instructions_hooked.c defines VM_HOOKED) is the instrumented
+// engine the run loop switches to while hooks are registered. HOOK() calls
+// exist only in the second build, so the default engine has no hook checks.
+#ifdef VM_HOOKED
+#include "hooks.h"
+#define HOOK(call) call
+#define cpu_execute_instruction_impl cpu_execute_instruction_hooked
+#else
+#define HOOK(call) ((void)0)
+#endif
 
 // Forward declarations of instruction handlers
 static int handle_nop(VM *vm, Instruction *instr);
@@ -18,6 +35,36 @@ static int handle_stack(VM *vm, Instruction *instr);
 static int handle_system(VM *vm, Instruction *instr);
 static int handle_memory(VM *vm, Instruction *instr);
 
+// Data accesses made by instructions, reported to the memory hooks
+#ifdef VM_HOOKED
+static uint32_t read_dword(VM *vm, uint16_t address) {
+    hooks_memory_read(vm, address, 4);
+    return memory_read_dword(vm, address);
+}
+
+static void write_dword(VM *vm, uint16_t address, uint32_t value) {
+    memory_write_dword(vm, address, value);
+    hooks_memory_write(vm, address, 4);
+}
+
+static void stack_push(VM *vm, uint32_t value) {
+    cpu_stack_push(vm, value);
+    if (vm->last_error == VM_ERROR_NONE) {
+        hooks_memory_write(vm, vm->registers[R2_SP], 4);
+    }
+}
+
+static uint32_t stack_pop(VM *vm) {
+    hooks_memory_read(vm, vm->registers[R2_SP], 4);
+    return cpu_stack_pop(vm);
+}
+#else
+#define read_dword  memory_read_dword
+#define write_dword memory_write_dword
+#define stack_push  cpu_stack_push
+#define stack_pop   cpu_stack_pop
+#endif
+
 // Helper function to get operand value based on addressing mode
 static uint32_t get_operand_value(VM *vm, Instruction *instr, int is_second_operand) {
     uint8_t mode = instr->mode;
@@ -33,23 +80,23 @@ static uint32_t get_operand_value(VM *vm, Instruction *instr, int is_second_oper
             return vm->registers[reg];
             
         case MEM_MODE:
-            return memory_read_dword(vm, imm);
+            return read_dword(vm, imm);
             
         case REGM_MODE:
             addr = vm->registers[reg];
-            return memory_read_dword(vm, addr);
+            return read_dword(vm, addr);
             
         case IDX_MODE:
             addr = vm->registers[reg] + imm;
-            return memory_read_dword(vm, addr);
+            return read_dword(vm, addr);
             
         case STK_MODE:
             addr = vm->registers[R2_SP] + imm;
-            return memory_read_dword(vm, addr);
+            return read_dword(vm, addr);
             
         case BAS_MODE:
             addr = vm->registers[R1_BP] + imm;
-            return memory_read_dword(vm, addr);
+            return read_dword(vm, addr);
             
         default:
             // Invalid addressing mode
@@ -190,6 +237,7 @@ static int handle_load(VM *vm, Instruction *instr) {
                 value = instr->immediate & 0xFF;
             } else {
                 uint16_t addr = get_store_address(vm, instr, 1);
+                HOOK(hooks_memory_read(vm, addr, 1));
                 value = memory_read_byte(vm, addr);
             }
             vm->registers[dest_reg] = value;
@@ -201,6 +249,7 @@ static int handle_load(VM *vm, Instruction *instr) {
                 value = instr->immediate & 0xFFFF;
             } else {
                 uint16_t addr = get_store_address(vm, instr, 0);
+                HOOK(hooks_memory_read(vm, addr, 2));
                 value = memory_read_word(vm, addr);
             }
             vm->registers[dest_reg] = value;
@@ -225,17 +274,19 @@ static int handle_store(VM *vm, Instruction *instr) {
     switch (opcode) {
         case STORE_OP:
             // Store 32-bit value from register to memory
-            memory_write_dword(vm, addr, value);
+            write_dword(vm, addr, value);
             break;
             
         case STOREB_OP:
             // Store low 8 bits from register to memory
             memory_write_byte(vm, addr, (uint8_t)(value & 0xFF));
+            HOOK(hooks_memory_write(vm, addr, 1));
             break;
             
         case STOREW_OP:
             // Store low 16 bits from register to memory
             memory_write_word(vm, addr, (uint16_t)(value & 0xFFFF));
+            HOOK(hooks_memory_write(vm, addr, 2));
             break;
     }
     
@@ -572,451 +623,6 @@ static int handle_logical(VM *vm, Instruction *instr) {
     return VM_ERROR_NONE;
 }
 
-/**
- * Handle system calls
- * 
- * Syscall conventions:
- * - Syscall number is in immediate field of instruction
- * - Parameters are passed in registers R0_ACC, R5, R6, R7
- * - Return value is placed in R0_ACC
- * - Error code is placed in R5 (0 = success)
- * 
- * Returns VM_ERROR_NONE on success or appropriate error code on failure
- */
-static int handle_syscall(VM *vm, uint16_t syscall_num) {
-    // Input parameters
-    uint32_t param1 = vm->registers[R0_ACC]; // First parameter
-    uint32_t param2 = vm->registers[R5];     // Second parameter
-    uint32_t param3 = vm->registers[R6];     // Third parameter
-    uint32_t param4 = vm->registers[R7];     // Fourth parameter
-
-    vm->registers[R5] = 0;  // Clear error code
-    
-    // Categorize syscalls by functional group
-    if (syscall_num < 10) {
-        // Group 0-9: Basic console I/O
-        switch (syscall_num) {
-            case 0:  // Print character
-                printf("%c", (char)param1);
-                fflush(stdout);
-                break;
-                
-            case 1:  // Print integer (decimal)
-                printf("%d", (int)param1);
-                fflush(stdout);
-                break;
-                
-            case 2:  // Print string
-                {
-                    uint16_t addr = param1;
-                    char c;
-                    
-                    while ((c = memory_read_byte(vm, addr)) != 0) {
-                        printf("%c", c);
-                        addr++;
-                    }
-                    fflush(stdout);
-                }
-                break;
-                
-            case 3:  // Read character
-                {
-                    int c = getchar();
-                    vm->registers[R0_ACC] = (c == EOF) ? 0 : c;
-                }
-                break;
-                
-            case 4:  // Read string (up to param2 chars)
-                {
-                    uint16_t addr = param1;
-                    uint16_t max_len = param2;
-                    uint16_t i = 0;
-                    int c;
-                    
-                    if (max_len == 0) {
-                        vm->registers[R0_ACC] = 0; // No characters read
-                        vm->registers[R5] = 1;
-                        break;
-                    }
-                    
-                    // Reserve space for null terminator
-                    max_len--;
-                    
-                    // Read input string
-                    while (i < max_len) {
-                        c = getchar();
-                        
-                        if (c == EOF || c == '\n') {
-                            break;
-                        }
-                        
-                        memory_write_byte(vm, addr + i, (uint8_t)c);
-                        i++;
-                    }
-                    
-                    // Add null terminator
-                    memory_write_byte(vm, addr + i, 0);
-                    
-                    // Return number of characters read
-                    vm->registers[R0_ACC] = i;
-                }
-                break;
-                
-            case 5:  // Print integer (hexadecimal)
-                printf("0x%x", (unsigned int)param1);
-                fflush(stdout);
-                break;
-                
-            case 6:  // Print formatted integer with base (param2 = base)
-                {
-                    unsigned int value = param1;
-                    unsigned int base = param2;
-                    
-                    // Validate base (2-36)
-                    if (base < 2 || base > 36) {
-                        base = 10;
-                    }
-                    
-                    // Simple base conversion (for a more complete implementation, 
-                    // you'd want to handle negative numbers specially)
-                    char buffer[33];  // Enough for 32-bit number in any base
-                    char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-                    int pos = 0;
-                    
-                    // Special case for 0
-                    if (value == 0) {
-                        printf("0");
-                        break;
-                    }
-                    
-                    // Convert number to string in specified base
-                    while (value > 0 && pos < 32) {
-                        buffer[pos++] = digits[value % base];
-                        value /= base;
-                    }
-                    
-                    // Print in reverse order
-                    while (pos > 0) {
-                        putchar(buffer[--pos]);
-                    }
-                    fflush(stdout);
-                }
-                break;
-                
-            case 7:  // Print floating point (emulated using fixed-point)
-                {
-                    // Interpret param1 as fixed-point (16.16 format)
-                    int32_t fixed_val = (int32_t)param1;
-                    int32_t integer_part = fixed_val >> 16;
-                    uint32_t frac_part = fixed_val & 0xFFFF;
-                    
-                    // Convert fraction to decimal
-                    // (multiply by 10000 and divide by 2^16)
-                    uint32_t decimal = (frac_part * 10000) >> 16;
-                    
-                    printf("%d.%04u", integer_part, decimal);
-                    fflush(stdout);
-                }
-                break;
-                
-            case 8:  // Control console - clear screen
-                printf("\033[2J\033[H"); // ANSI escape sequence to clear screen and move cursor to home
-                fflush(stdout);
-                break;
-                
-            case 9:  // Control console - set color
-                {
-                    uint8_t fg = param1 & 0xFF;
-                    uint8_t bg = (param1 >> 8) & 0xFF;
-                    
-                    // Make sure everything is flushed before changing colors
-                    fflush(stdout);
-                    
-                    if (fg == 0xFF) {
-                        // Special case for reset - force to default colors
-                        // Use the most complete reset sequence possible
-                        printf("\033[0;39;49m");  // Reset all attributes and explicitly set default colors
-                    } else if (fg < 8) {
-                        // ANSI color codes (0-7 standard colors)
-                        if (bg < 8) {
-                            // Set both foreground and background
-                            printf("\033[0;%d;%dm", 30 + fg, 40 + bg);
-                        } else {
-                            // Set only foreground
-                            printf("\033[0;%dm", 30 + fg);
-                        }
-                    }
-                    fflush(stdout);
-                }
-                break;
-                
-            default:
-                vm->registers[R5] = 1;  // Error - unimplemented
-                break;
-        }
-    }
-    else if (syscall_num < 20) {
-        // Group 10-19: File operations (simplified)
-        switch (syscall_num) {
-            case 10:  // File open (param1=filename addr, param2=mode)
-                {
-                    // Extract filename
-                    uint16_t addr = param1;
-                    uint8_t mode = param2 & 0xFF;
-                    char filename[256] = {0};
-                    int i = 0;
-                    char c;
-                    
-                    // Copy filename from VM memory
-                    while (i < 255 && (c = memory_read_byte(vm, addr + i)) != 0) {
-                        filename[i++] = c;
-                    }
-                    filename[i] = 0;
-                    
-                    // Map mode to file open mode
-                    char file_mode[4] = {0};
-                    switch (mode) {
-                        case 0: strcpy(file_mode, "r"); break;   // Read
-                        case 1: strcpy(file_mode, "w"); break;   // Write
-                        case 2: strcpy(file_mode, "a"); break;   // Append
-                        case 3: strcpy(file_mode, "r+"); break;  // Read/Write
-                        default: strcpy(file_mode, "r"); break;  // Default to read
-                    }
-                    
-                    // We would need to maintain a file table in the VM for real file I/O
-                    // For now, just simulate by returning a dummy file handle
-                    vm->registers[R0_ACC] = 1;  // Dummy file handle
-                    vm->registers[R5] = 0;      // Success
-                }
-                break;
-                
-            case 11:  // File close (param1=file handle)
-                {
-                    // Here we would free resources associated with the file handle
-                    // For this simplified implementation, just return success
-                    vm->registers[R0_ACC] = 0;  // Success
-                    vm->registers[R5] = 0;
-                }
-                break;
-                
-            case 12:  // File read (param1=file handle, param2=buffer addr, param3=count)
-                {
-                    // Simplified implementation - always return some dummy data
-                    uint16_t buffer_addr = param2;
-                    uint16_t count = param3;
-                    
-                    // Make sure we don't exceed memory bounds
-                    if (buffer_addr + count > vm->memory_size) {
-                        count = vm->memory_size - buffer_addr;
-                    }
-                    
-                    // Fill buffer with sequential values
-                    for (uint16_t i = 0; i < count; i++) {
-                        memory_write_byte(vm, buffer_addr + i, i & 0xFF);
-                    }
-                    
-                    // Return number of bytes read
-                    vm->registers[R0_ACC] = count;
-                    vm->registers[R5] = 0;  // Success
-                }
-                break;
-                
-            case 13:  // File write (param1=file handle, param2=buffer addr, param3=count)
-                {
-                    // Simplified implementation - just pretend we wrote the data
-                    uint16_t count = param3;
-                    
-                    // Return number of bytes written
-                    vm->registers[R0_ACC] = count;
-                    vm->registers[R5] = 0;  // Success
-                }
-                break;
-                
-            default:
-                vm->registers[R5] = 1;  // Error - unimplemented
-                break;
-        }
-    }
-    else if (syscall_num < 30) {
-        // Group 20-29: Memory operations
-        switch (syscall_num) {
-            case 20:  // Allocate memory (param1=size)
-                {
-                    uint16_t size = param1;
-                    uint16_t addr = memory_allocate(vm, size);
-
-                    if (vm->last_error != VM_ERROR_NONE)
-                    {
-                        return vm->last_error;
-                    }
-                    
-                    vm->registers[R0_ACC] = addr;  // Return address
-                    vm->registers[R5] = (addr == 0) ? 1 : 0;  // Error if allocation failed
-                }
-                break;
-                
-            case 21:  // Free memory (param1=address)
-                {
-                    uint16_t addr = param1;
-                    int result = memory_free(vm, addr);
-
-                    if (vm->last_error != VM_ERROR_NONE)
-                    {
-                        return vm->last_error;
-                    }
-                    
-                    vm->registers[R0_ACC] = result;
-                    vm->registers[R5] = (result == VM_ERROR_NONE) ? 0 : 1;
-                }
-                break;
-                
-            case 22:  // Copy memory (param1=dest, param2=src, param3=count)
-                {
-                    uint16_t dest = param1;
-                    uint16_t src = param2;
-                    uint16_t count = param3;
-                    
-                    int result = memory_copy(vm, dest, src, count);
-
-                    if (vm->last_error != VM_ERROR_NONE)
-                    {
-                        return vm->last_error;
-                    }
-                    
-                    vm->registers[R0_ACC] = count;  // Return bytes copied
-                    vm->registers[R5] = (result == VM_ERROR_NONE) ? 0 : 1;
-                }
-                break;
-                
-            case 23:  // Memory information
-                {
-                    // Return total memory size
-                    vm->registers[R0_ACC] = vm->memory_size;
-                    
-                    // Return segment boundaries and sizes
-                    vm->registers[R5] = (CODE_SEGMENT_BASE << 16) | CODE_SEGMENT_SIZE;
-                    vm->registers[R6] = (DATA_SEGMENT_BASE << 16) | DATA_SEGMENT_SIZE;
-                    vm->registers[R7] = (STACK_SEGMENT_BASE << 16) | STACK_SEGMENT_SIZE;
-                    
-                    vm->registers[R5] = 0;  // Success
-                }
-                break;
-                
-            default:
-                vm->registers[R5] = 1;  // Error - unimplemented
-                break;
-        }
-    }
-    else if (syscall_num < 40) {
-        // Group 30-39: Process control
-        switch (syscall_num) {
-            case 30:  // Exit program with return code (param1=code)
-                {
-                    // Set return code (for potential host program)
-                    vm->registers[R0_ACC] = param1;
-                    
-                    // Halt the VM
-                    vm->halted = 1;
-                }
-                break;
-                
-            case 31:  // Sleep (param1=milliseconds)
-                {
-                    // Use platform-specific sleep
-                    #ifdef _WIN32
-                    // Windows
-                    Sleep(param1);  // Windows Sleep takes milliseconds
-                    #else
-                    // Unix/Linux/macOS
-                    struct timespec ts;
-                    ts.tv_sec = param1 / 1000;
-                    ts.tv_nsec = (param1 % 1000) * 1000000;
-                    nanosleep(&ts, NULL);
-                    #endif
-                    
-                    // Still update instruction count for consistency
-                    uint32_t dummy_cycles = param1 / 10;
-                    if (dummy_cycles > 0) {
-                        vm->instruction_count += dummy_cycles;
-                    } else {
-                        vm->instruction_count++;
-                    }
-                }
-                break;
-                
-            case 32:  // Get system time (milliseconds since VM start)
-                {
-                    // Simulate a system time based on instruction count
-                    // In a real implementation, you'd use the host system's clock
-                    vm->registers[R0_ACC] = vm->instruction_count * 10;  // Rough estimate
-                    vm->registers[R5] = 0;  // Success
-                }
-                break;
-                
-            case 33:  // Get performance counter (high resolution)
-                {
-                    // Just return exact instruction count
-                    vm->registers[R0_ACC] = vm->instruction_count;
-                    vm->registers[R5] = 0;  // Success
-                }
-                break;
-                
-            default:
-                vm->registers[R5] = 1;  // Error - unimplemented
-                break;
-        }
-    }
-    else if (syscall_num < 50) {
-        // Group 40-49: Random number generation and misc
-        switch (syscall_num) {
-            case 40:  // Get random number (param1=max value)
-                {
-                    uint32_t max_val = param1;
-                    
-                    if (max_val == 0) {
-                        max_val = 0xFFFFFFFF;  // Full 32-bit range
-                    }
-                    
-                    // Simple pseudo-random number generation
-                    // In a real implementation, you'd use a better PRNG
-                    static uint32_t seed = 0x12345678;
-                    seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF;
-                    
-                    // Return random number in range [0, max_val]
-                    vm->registers[R0_ACC] = (uint32_t)((uint64_t)seed * max_val / 0x7FFFFFFF);
-                    vm->registers[R5] = 0;  // Success
-                }
-                break;
-                
-            case 41:  // Seed random number generator (param1=seed)
-                {
-                    // Set the seed for the PRNG
-                    uint32_t seed_val = param1;
-                    
-                    // In a real implementation, this would set the PRNG seed
-                    // For this simplified version, just store and return success
-                    static uint32_t seed = 0x12345678;
-                    seed = seed_val;
-                    
-                    vm->registers[R0_ACC] = 0;  // Success
-                    vm->registers[R5] = 0;
-                }
-                break;
-                
-            default:
-                vm->registers[R5] = 1;  // Error - unimplemented
-                break;
-        }
-    }
-    else {
-        // Unknown syscall group
-        vm->registers[R5] = 1;  // Error code
-        return VM_ERROR_INVALID_SYSCALL;
-    }
-    
-    return VM_ERROR_NONE;
-}
-
 // Handle jump and control flow instructions
 static int handle_jump(VM *vm, Instruction *instr) {
     uint8_t opcode = instr->opcode;
@@ -1037,6 +643,7 @@ static int handle_jump(VM *vm, Instruction *instr) {
         case JMP_OP:
             // Unconditional jump
             vm->registers[R3_PC] = target;
+            HOOK(hooks_branch(vm, vm->error_pc, target));
             break;
             
         case JZ_OP:
@@ -1044,6 +651,7 @@ static int handle_jump(VM *vm, Instruction *instr) {
             condition = cpu_get_flag(vm, ZERO_FLAG);
             if (condition) {
                 vm->registers[R3_PC] = target;
+                HOOK(hooks_branch(vm, vm->error_pc, target));
             }
             break;
             
@@ -1052,6 +660,7 @@ static int handle_jump(VM *vm, Instruction *instr) {
             condition = !cpu_get_flag(vm, ZERO_FLAG);
             if (condition) {
                 vm->registers[R3_PC] = target;
+                HOOK(hooks_branch(vm, vm->error_pc, target));
             }
             break;
             
@@ -1060,6 +669,7 @@ static int handle_jump(VM *vm, Instruction *instr) {
             condition = cpu_get_flag(vm, NEG_FLAG);
             if (condition) {
                 vm->registers[R3_PC] = target;
+                HOOK(hooks_branch(vm, vm->error_pc, target));
             }
             break;
             
@@ -1068,6 +678,7 @@ static int handle_jump(VM *vm, Instruction *instr) {
             condition = !cpu_get_flag(vm, NEG_FLAG) && !cpu_get_flag(vm, ZERO_FLAG);
             if (condition) {
                 vm->registers[R3_PC] = target;
+                HOOK(hooks_branch(vm, vm->error_pc, target));
             }
             break;
             
@@ -1076,6 +687,7 @@ static int handle_jump(VM *vm, Instruction *instr) {
             condition = cpu_get_flag(vm, OVER_FLAG);
             if (condition) {
                 vm->registers[R3_PC] = target;
+                HOOK(hooks_branch(vm, vm->error_pc, target));
             }
             break;
             
@@ -1084,6 +696,7 @@ static int handle_jump(VM *vm, Instruction *instr) {
             condition = cpu_get_flag(vm, CARRY_FLAG);
             if (condition) {
                 vm->registers[R3_PC] = target;
+                HOOK(hooks_branch(vm, vm->error_pc, target));
             }
             break;
             
@@ -1092,6 +705,7 @@ static int handle_jump(VM *vm, Instruction *instr) {
             condition = cpu_get_flag(vm, CARRY_FLAG) || cpu_get_flag(vm, ZERO_FLAG);
             if (condition) {
                 vm->registers[R3_PC] = target;
+                HOOK(hooks_branch(vm, vm->error_pc, target));
             }
             break;
             
@@ -1100,38 +714,40 @@ static int handle_jump(VM *vm, Instruction *instr) {
             condition = !cpu_get_flag(vm, CARRY_FLAG) && !cpu_get_flag(vm, ZERO_FLAG);
             if (condition) {
                 vm->registers[R3_PC] = target;
+                HOOK(hooks_branch(vm, vm->error_pc, target));
             }
             break;
             
         case CALL_OP:
             // Call subroutine
             // Push return address (current PC) onto stack
-            cpu_stack_push(vm, vm->registers[R3_PC]);
+            stack_push(vm, vm->registers[R3_PC]);
             // Jump to target
             vm->registers[R3_PC] = target;
+            HOOK(hooks_call(vm, vm->error_pc, target));
             break;
             
         case RET_OP:
             // Return from subroutine
             // Pop return address from stack
-            vm->registers[R3_PC] = cpu_stack_pop(vm);
+            vm->registers[R3_PC] = stack_pop(vm);
             
             // Optional: Adjust stack for parameters
             if (instr->immediate > 0) {
                 vm->registers[R2_SP] += instr->immediate;
             }
+            HOOK(hooks_ret(vm, vm->error_pc, vm->registers[R3_PC]));
             break;
             
         case SYSCALL_OP:
             // System call
             {
                 uint16_t syscall_num = instr->immediate;
-                int result = handle_syscall(vm, syscall_num);
-                         
+                HOOK(hooks_syscall(vm, syscall_num));
+                int result = syscalls_dispatch(vm, syscall_num);
+                
                 if (result != VM_ERROR_NONE) {
-                        vm->last_error = result;
-                    snprintf(vm->error_message, sizeof(vm->error_message),
-                        "Invalid system call: %d", syscall_num);
+                    vm->last_error = result;
                     return result;
                 }
             }
@@ -1144,6 +760,7 @@ static int handle_jump(VM *vm, Instruction *instr) {
             
             if (vm->registers[reg] != 0) {
                 vm->registers[R3_PC] = target;
+                HOOK(hooks_branch(vm, vm->error_pc, target));
             }
             break;
             
@@ -1174,33 +791,34 @@ static int handle_stack(VM *vm, Instruction *instr) {
                 value = vm->registers[instr->reg1];
             }
             
-            cpu_stack_push(vm, value);
+            stack_push(vm, value);
             break;
             
         case POP_OP:
             // Pop value from stack into register
-            value = cpu_stack_pop(vm);
+            value = stack_pop(vm);
             vm->registers[instr->reg1] = value;
             break;
             
         case PUSHF_OP:
             // Push flags onto stack
-            cpu_stack_push(vm, vm->registers[R4_SR]);
+            stack_push(vm, vm->registers[R4_SR]);
             break;
             
         case POPF_OP:
             // Pop flags from stack
-            vm->registers[R4_SR] = cpu_stack_pop(vm);
+            vm->registers[R4_SR] = stack_pop(vm);
+            pic_update(vm);
             break;
             
         case PUSHA_OP:
             // Push all registers onto stack
             for (int i = 0; i < 16; i++) {
                 if (i != R2_SP) {  // Don't push SP
-                    cpu_stack_push(vm, vm->registers[i]);
+                    stack_push(vm, vm->registers[i]);
                 } else {
                     // Push original SP value
-                    cpu_stack_push(vm, vm->registers[R2_SP] + 4 * 15);
+                    stack_push(vm, vm->registers[R2_SP] + 4 * 15);
                 }
             }
             break;
@@ -1212,7 +830,7 @@ static int handle_stack(VM *vm, Instruction *instr) {
                 
                 for (int i = 15; i >= 0; i--) {
                     if (i != R2_SP) {  // Don't pop into SP
-                        vm->registers[i] = cpu_stack_pop(vm);
+                        vm->registers[i] = stack_pop(vm);
                     } else {
                         // Skip SP
                         vm->registers[R2_SP] += 4;
@@ -1224,10 +842,12 @@ static int handle_stack(VM *vm, Instruction *instr) {
         case ENTER_OP:
             // Create stack frame
             cpu_enter_frame(vm, instr->immediate);
+            HOOK(hooks_memory_write(vm, vm->registers[R1_BP], 4));  // Saved BP
             break;
             
         case LEAVE_OP:
             // Destroy stack frame
+            HOOK(hooks_memory_read(vm, vm->registers[R1_BP], 4));
             cpu_leave_frame(vm);
             break;
             
@@ -1250,6 +870,7 @@ static int handle_system(VM *vm, Instruction *instr) {
         case HALT_OP:
             // Halt VM execution
             vm->halted = 1;
+            console_flush(vm);
             break;
             
         case INT_OP:
@@ -1276,37 +897,23 @@ static int handle_system(VM *vm, Instruction *instr) {
         case IN_OP:
             // Input from I/O port
             {
-                uint16_t port = instr->immediate;
-                int value = 0;
+                // Port is the immediate, or a register in REG mode
+                uint16_t port = (instr->mode == REG_MODE) ?
+                                vm->registers[instr->reg2] : instr->immediate;
                 
-                // Special handling for console input (port 0)
-                if (port == 0) {
-                    value = getchar();
-                    if (value == EOF) {
-                        value = 0;
-                    }
-                }
-                
-                vm->registers[instr->reg1] = value;
+                vm->registers[instr->reg1] = io_read(vm, port);
             }
             break;
             
         case OUT_OP:
             // Output to I/O port
             {
-                uint16_t port = instr->reg1;
-                uint32_t value;
-                
-                if (instr->mode == IMM_MODE) {
-                    value = instr->immediate;
-                } else {
-                    value = vm->registers[instr->reg2];
-                }
+                // Same operand layout as IN: value in reg1, port in the
+                // immediate or in reg2 for REG mode
+                uint16_t port = (instr->mode == REG_MODE) ?
+                                vm->registers[instr->reg2] : instr->immediate;
                 
-                // Special handling for console output (port 0)
-                if (port == 0) {
-                    putchar((int)(value & 0xFF));
-                }
+                io_write(vm, port, vm->registers[instr->reg1]);
             }
             break;
             
@@ -1417,6 +1024,9 @@ static int handle_system(VM *vm, Instruction *instr) {
         case RESET_OP:
             // Reset VM
             cpu_reset(vm);
+            
+            // Guest file handles do not survive a reset
+            files_close_all(vm);
             break;
             
         case DEBUG_OP:
@@ -1475,6 +1085,7 @@ static int handle_memory(VM *vm, Instruction *instr) {
             
             // Store allocated address in destination register
             vm->registers[dest_reg] = addr;
+            HOOK(hooks_alloc(vm, addr, size));
             break;
             
         case FREE_OP:
@@ -1488,6 +1099,7 @@ static int handle_memory(VM *vm, Instruction *instr) {
                 // Error is already set in memory_free
                 return result;
             }
+            HOOK(hooks_free(vm, addr));
             break;
             
         case MEMCPY_OP:
@@ -1515,10 +1127,12 @@ static int handle_memory(VM *vm, Instruction *instr) {
             }
             
             // Perform memory copy
+            HOOK(hooks_memory_read(vm, src, size));
             result = memory_copy(vm, dst, src, size);
             if (result != VM_ERROR_NONE) {
                 return result;
             }
+            HOOK(hooks_memory_write(vm, dst, size));
             break;
             
         case MEMSET_OP:
@@ -1543,6 +1157,7 @@ static int handle_memory(VM *vm, Instruction *instr) {
             if (result != VM_ERROR_NONE) {
                 return result;
             }
+            HOOK(hooks_memory_write(vm, dst, size));
             break;
             
         case PROTECT_OP:
@@ -0,0 +1,4 @@
+// The instrumented engine: the interpreter in instructions.c built again
+// with its hook calls compiled in (see hooks.h)
+#define VM_HOOKED
+#include "instructions.c"
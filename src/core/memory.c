@@ -1,8 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "memory.h"
 #include "vm.h"
+#include "mmio.h"
 
 // Memory block header structure - must be kept small
 typedef struct {
@@ -17,12 +21,8 @@ typedef struct {
 #define MEMBLOCK_HEADER_SIZE sizeof(MemBlock)
 #define MIN_ALLOC_SIZE 8
 
-// Protection flags (will be used when we implement PROTECT)
-#define PROT_NONE 0x00
-#define PROT_READ 0x01
-#define PROT_WRITE 0x02
-#define PROT_EXEC 0x04
-#define PROT_ALL (PROT_READ | PROT_WRITE | PROT_EXEC)
+// Protection of a new heap block; the flags are in memory.h
+#define VM_PROT_ALL (VM_PROT_READ | VM_PROT_WRITE | VM_PROT_EXEC)
 
 // Initialize memory for the VM
 int memory_init(VM *vm, uint32_t size) {
@@ -30,8 +30,8 @@ int memory_init(VM *vm, uint32_t size) {
         return VM_ERROR_INVALID_ADDRESS;
     }
     
-    // Allocate memory buffer
-    vm->memory = (uint8_t*)malloc(size);
+    // Allocate memory buffer, from the embedder's allocator if one is set
+    vm->memory = (uint8_t*)(vm->memory_alloc ? vm->memory_alloc(size, vm->allocator_data) : malloc(size));
     if (!vm->memory) {
         vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
         snprintf(vm->error_message, sizeof(vm->error_message), 
@@ -48,7 +48,7 @@ int memory_init(VM *vm, uint32_t size) {
     init_block->magic = MEMBLOCK_MAGIC;
     init_block->size = HEAP_SEGMENT_SIZE;
     init_block->is_free = 1;
-    init_block->protection = PROT_ALL;
+    init_block->protection = VM_PROT_ALL;
     init_block->next = 0;  // No next block
     
     return VM_ERROR_NONE;
@@ -57,10 +57,47 @@ int memory_init(VM *vm, uint32_t size) {
 // Clean up memory resources
 void memory_cleanup(VM *vm) {
     if (vm && vm->memory) {
-        free(vm->memory);
+        if (vm->memory_mapped) {
+            munmap(vm->memory, vm->memory_size);
+        } else if (vm->memory_free) {
+            vm->memory_free(vm->memory, vm->allocator_data);
+        } else {
+            free(vm->memory);
+        }
         vm->memory = NULL;
         vm->memory_size = 0;
+        vm->memory_mapped = 0;
+    }
+}
+
+int memory_map_image(VM *vm, int fd, uint64_t offset, uint32_t size) {
+    if (!vm || size == 0) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    // Pages past the end of the file would fault with SIGBUS on first touch
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 0 || (uint64_t)st.st_size < offset + size) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Memory image is truncated: %u bytes needed at offset %llu",
+                 size, (unsigned long long)offset);
+        return VM_ERROR_IO_ERROR;
+    }
+
+    void *image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)offset);
+    if (image == MAP_FAILED) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to map %u bytes of memory image: %s", size, strerror(errno));
+        return VM_ERROR_MEMORY_ALLOCATION;
     }
+
+    memory_cleanup(vm);
+    vm->memory = (uint8_t *)image;
+    vm->memory_size = size;
+    vm->memory_mapped = 1;
+    return VM_ERROR_NONE;
 }
 
 // Dump heap state for debugging
@@ -113,9 +150,17 @@ uint8_t* memory_get_ptr(VM *vm, uint16_t address) {
     return &vm->memory[address];
 }
 
+// The accessors below route addresses inside a mapped device region to its
+// callbacks; everything else costs one compare and takes the direct path.
+// Block operations (memory_copy, memory_set, DMA, file I/O) see plain RAM.
 uint8_t memory_read_byte(VM *vm, uint16_t address) {
+    uint32_t value;
+    if (MMIO_HIT(vm, address) && mmio_read(vm, address, 1, &value)) {
+        return (uint8_t)value;
+    }
+    
     // Check both address validity and read permission
-    if (memory_check_address_permissions(vm, address, 1, PROT_READ) != VM_ERROR_NONE) {
+    if (memory_check_address_permissions(vm, address, 1, VM_PROT_READ) != VM_ERROR_NONE) {
         return 0;
     }
     
@@ -124,8 +169,12 @@ uint8_t memory_read_byte(VM *vm, uint16_t address) {
 
 // Write a byte to memory with permission check
 void memory_write_byte(VM *vm, uint16_t address, uint8_t value) {
+    if (MMIO_HIT(vm, address) && mmio_write(vm, address, 1, value)) {
+        return;
+    }
+    
     // Check both address validity and write permission
-    if (memory_check_address_permissions(vm, address, 1, PROT_WRITE) != VM_ERROR_NONE) {
+    if (memory_check_address_permissions(vm, address, 1, VM_PROT_WRITE) != VM_ERROR_NONE) {
         return;
     }
     
@@ -134,8 +183,13 @@ void memory_write_byte(VM *vm, uint16_t address, uint8_t value) {
 
 // Read a 16-bit word from memory
 uint16_t memory_read_word(VM *vm, uint16_t address) {
+    uint32_t value;
+    if (MMIO_HIT(vm, address) && mmio_read(vm, address, 2, &value)) {
+        return (uint16_t)value;
+    }
+    
     // Check both address validity and read permission for 2 bytes
-    if (memory_check_address_permissions(vm, address, 2, PROT_READ) != VM_ERROR_NONE) {
+    if (memory_check_address_permissions(vm, address, 2, VM_PROT_READ) != VM_ERROR_NONE) {
         return 0;
     }
     
@@ -146,8 +200,12 @@ uint16_t memory_read_word(VM *vm, uint16_t address) {
 
 // Write a 16-bit word to memory with permission check
 void memory_write_word(VM *vm, uint16_t address, uint16_t value) {
+    if (MMIO_HIT(vm, address) && mmio_write(vm, address, 2, value)) {
+        return;
+    }
+    
     // Check both address validity and write permission for 2 bytes
-    if (memory_check_address_permissions(vm, address, 2, PROT_WRITE) != VM_ERROR_NONE) {
+    if (memory_check_address_permissions(vm, address, 2, VM_PROT_WRITE) != VM_ERROR_NONE) {
         return;
     }
     
@@ -158,8 +216,13 @@ void memory_write_word(VM *vm, uint16_t address, uint16_t value) {
 
 // Read a 32-bit dword from memory
 uint32_t memory_read_dword(VM *vm, uint16_t address) {
+    uint32_t value;
+    if (MMIO_HIT(vm, address) && mmio_read(vm, address, 4, &value)) {
+        return value;
+    }
+    
     // Check both address validity and read permission for 4 bytes
-    if (memory_check_address_permissions(vm, address, 4, PROT_READ) != VM_ERROR_NONE) {
+    if (memory_check_address_permissions(vm, address, 4, VM_PROT_READ) != VM_ERROR_NONE) {
         return 0;
     }
     
@@ -172,8 +235,12 @@ uint32_t memory_read_dword(VM *vm, uint16_t address) {
 
 // Write a 32-bit dword to memory with permission check
 void memory_write_dword(VM *vm, uint16_t address, uint32_t value) {
+    if (MMIO_HIT(vm, address) && mmio_write(vm, address, 4, value)) {
+        return;
+    }
+    
     // Check both address validity and write permission for 4 bytes
-    if (memory_check_address_permissions(vm, address, 4, PROT_WRITE) != VM_ERROR_NONE) {
+    if (memory_check_address_permissions(vm, address, 4, VM_PROT_WRITE) != VM_ERROR_NONE) {
         return;
     }
     
@@ -187,12 +254,12 @@ void memory_write_dword(VM *vm, uint16_t address, uint32_t value) {
 // Copy a block of memory
 int memory_copy(VM *vm, uint16_t dest, uint16_t src, uint16_t size) {
     // Check source has read permission
-    if (memory_check_address_permissions(vm, src, size, PROT_READ) != VM_ERROR_NONE) {
+    if (memory_check_address_permissions(vm, src, size, VM_PROT_READ) != VM_ERROR_NONE) {
         return vm->last_error;
     }
     
     // Check destination has write permission
-    if (memory_check_address_permissions(vm, dest, size, PROT_WRITE) != VM_ERROR_NONE) {
+    if (memory_check_address_permissions(vm, dest, size, VM_PROT_WRITE) != VM_ERROR_NONE) {
         return vm->last_error;
     }
     
@@ -204,7 +271,7 @@ int memory_copy(VM *vm, uint16_t dest, uint16_t src, uint16_t size) {
 // Set a block of memory to a specific value with permission check
 int memory_set(VM *vm, uint16_t address, uint8_t value, uint16_t size) {
     // Check destination has write permission
-    if (memory_check_address_permissions(vm, address, size, PROT_WRITE) != VM_ERROR_NONE) {
+    if (memory_check_address_permissions(vm, address, size, VM_PROT_WRITE) != VM_ERROR_NONE) {
         return vm->last_error;
     }
     
@@ -257,7 +324,7 @@ uint16_t memory_allocate(VM *vm, uint16_t size) {
                 new_block->magic = MEMBLOCK_MAGIC;
                 new_block->size = block->size - total_size;
                 new_block->is_free = 1;
-                new_block->protection = PROT_ALL;
+                new_block->protection = VM_PROT_ALL;
                 new_block->next = block->next == 0 ? 0 : block->next - total_size;
                 
                 // Update current block
@@ -381,13 +448,19 @@ int memory_check_address_permissions(VM *vm, uint16_t address, uint16_t size, ui
         return VM_ERROR_SEGMENTATION_FAULT;
     }
     
-    // For heap memory, check if it's allocated and has appropriate permissions
-    if (address >= HEAP_SEGMENT_BASE && 
+    // For heap memory, check if it's allocated and has appropriate permissions.
+    // This covers the part of any range that reaches the heap, including ranges
+    // that start below it, so a block copy can't run into the block headers.
+    uint32_t end = (uint32_t)address + size;
+    if (size > 0 && end > HEAP_SEGMENT_BASE &&
         address < HEAP_SEGMENT_BASE + HEAP_SEGMENT_SIZE) {
+        uint32_t heap_start = address < HEAP_SEGMENT_BASE ? HEAP_SEGMENT_BASE : address;
+        uint32_t heap_end = end < HEAP_SEGMENT_BASE + HEAP_SEGMENT_SIZE ?
+                            end : HEAP_SEGMENT_BASE + HEAP_SEGMENT_SIZE;
         
         // Check both the start and end addresses
-        MemBlock* start_block = find_block_containing(vm, address);
-        MemBlock* end_block = find_block_containing(vm, address + size - 1);
+        MemBlock* start_block = find_block_containing(vm, (uint16_t)heap_start);
+        MemBlock* end_block = find_block_containing(vm, (uint16_t)(heap_end - 1));
         
         // If not found, it's not in an allocated block
         if (!start_block || !end_block) {
@@ -426,6 +499,26 @@ int memory_check_address_permissions(VM *vm, uint16_t address, uint16_t size, ui
     return VM_ERROR_NONE;
 }
 
+uint32_t memory_accessible_span(VM *vm, uint16_t address) {
+    if (!vm || !vm->memory || address >= vm->memory_size) {
+        return 0;
+    }
+    
+    if (address < HEAP_SEGMENT_BASE) {
+        uint32_t limit = vm->memory_size < HEAP_SEGMENT_BASE ? vm->memory_size : HEAP_SEGMENT_BASE;
+        return limit - address;
+    }
+    if (address >= HEAP_SEGMENT_BASE + HEAP_SEGMENT_SIZE) {
+        return vm->memory_size - address;
+    }
+    
+    MemBlock* block = find_block_containing(vm, address);
+    if (!block || block->is_free) {
+        return 0;
+    }
+    return (uint32_t)((uint8_t *)block - vm->memory) + block->size - address;
+}
+
 // Free allocated memory
 int memory_free(VM *vm, uint16_t address) {
     if (!vm || !vm->memory) {
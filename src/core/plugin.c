@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include "vm_types.h"
+#include "plugin.h"
+
+// Loaded plugin handles
+typedef struct {
+    void *handles[PLUGIN_MAX];
+    int count;
+} PluginTable;
+
+int plugins_load(VM *vm, const char *path) {
+    if (!vm || !path) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    if (!vm->plugins) {
+        vm->plugins = calloc(1, sizeof(PluginTable));
+        if (!vm->plugins) {
+            vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "Failed to allocate plugin table");
+            return VM_ERROR_MEMORY_ALLOCATION;
+        }
+    }
+
+    PluginTable *plugins = (PluginTable *)vm->plugins;
+    if (plugins->count >= PLUGIN_MAX) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Too many plugins (maximum %d)", PLUGIN_MAX);
+        return VM_ERROR_IO_ERROR;
+    }
+
+    // Resolve everything now so a missing symbol fails at startup, not mid-run
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Cannot load plugin: %s", dlerror());
+        return VM_ERROR_IO_ERROR;
+    }
+
+    PluginInitFn init;
+    *(void **)&init = dlsym(handle, PLUGIN_INIT_SYMBOL);
+    if (!init) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Plugin %s has no %s function", path, PLUGIN_INIT_SYMBOL);
+        dlclose(handle);
+        return VM_ERROR_IO_ERROR;
+    }
+
+    int result = init(vm);
+    if (result != VM_ERROR_NONE) {
+        if (vm->last_error == VM_ERROR_NONE) {
+            vm->last_error = result;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "Plugin %s failed to initialize", path);
+        }
+        dlclose(handle);
+        return result;
+    }
+
+    plugins->handles[plugins->count++] = handle;
+    return VM_ERROR_NONE;
+}
+
+void plugins_unload(VM *vm) {
+    if (!vm || !vm->plugins) {
+        return;
+    }
+
+    PluginTable *plugins = (PluginTable *)vm->plugins;
+    while (plugins->count > 0) {
+        dlclose(plugins->handles[--plugins->count]);
+    }
+
+    free(plugins);
+    vm->plugins = NULL;
+}
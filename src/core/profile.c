@@ -0,0 +1,435 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "vm.h"
+#include "profile.h"
+#include "hooks.h"
+#include "events.h"
+#include "debug.h"
+
+#define PROFILE_ADDRESSES     65536
+#define PROFILE_INITIAL_SLOTS 256       // Distinct stacks before the first growth
+#define PROFILE_NO_RETURN     0xFFFFFFFF  // Interrupt frames leave by IRET, not RET
+
+// Shadow call stack entry
+typedef struct {
+    uint16_t function;           // Entry address
+    uint8_t  interrupt_depth;    // vm->interrupt_depth when entered
+    uint32_t return_address;     // Where its RET goes back to
+} ProfileFrame;
+
+// A distinct call stack and its samples, root first
+typedef struct {
+    uint64_t samples;
+    uint32_t hash;
+    uint16_t depth;              // 0 marks a free slot
+    uint16_t frames[PROFILE_STACK_MAX];
+} ProfileStack;
+
+typedef struct {
+    uint32_t interval;
+    uint32_t jitter;             // xorshift32 state for the sample spacing
+    ProfileFrame frames[PROFILE_STACK_MAX];
+    int depth;
+    uint32_t lost;               // Calls deeper than PROFILE_STACK_MAX
+    uint64_t samples;
+
+    // Open-addressed table of distinct stacks
+    ProfileStack *stacks;
+    uint32_t slots;              // Power of two
+    uint32_t stack_count;
+
+    uint32_t *pc_samples;        // Samples per guest address
+} Profile;
+
+// A row of the report tables
+typedef struct {
+    uint32_t key;                // Function address or source line index
+    uint64_t self;
+    uint64_t total;
+} ProfileRow;
+
+static void profile_sample(VM *vm, void *data);
+
+// Next sample in interval/2 .. interval*3/2 instructions
+static uint32_t profile_next_delay(Profile *profile) {
+    uint32_t x = profile->jitter;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    profile->jitter = x;
+
+    uint32_t delay = profile->interval / 2 + x % profile->interval;
+    return delay > 0 ? delay : 1;
+}
+
+// Drop frames of interrupt handlers that have returned (IRET is not hooked)
+static void profile_prune(VM *vm, Profile *profile) {
+    while (profile->depth > 1 &&
+           profile->frames[profile->depth - 1].interrupt_depth > vm->interrupt_depth) {
+        profile->depth--;
+    }
+}
+
+static void profile_push(Profile *profile, uint16_t function, uint8_t interrupt_depth,
+                         uint32_t return_address) {
+    if (profile->depth >= PROFILE_STACK_MAX) {
+        profile->lost++;
+        return;
+    }
+    ProfileFrame *frame = &profile->frames[profile->depth++];
+    frame->function = function;
+    frame->interrupt_depth = interrupt_depth;
+    frame->return_address = return_address;
+}
+
+static void profile_on_call(VM *vm, uint16_t from, uint16_t to, void *data) {
+    Profile *profile = (Profile *)data;
+    profile_prune(vm, profile);
+    profile_push(profile, to, vm->interrupt_depth, (uint16_t)(from + 4));
+}
+
+static void profile_on_ret(VM *vm, uint16_t from, uint16_t to, void *data) {
+    Profile *profile = (Profile *)data;
+    profile_prune(vm, profile);
+
+    if (profile->lost > 0) {
+        profile->lost--;
+        return;
+    }
+
+    // Unwind to the frame this RET returns from; code that returns past
+    // several frames (or without a matching CALL) pops just one
+    for (int i = profile->depth - 1; i > 0; i--) {
+        if (profile->frames[i].return_address == to) {
+            profile->depth = i;
+            return;
+        }
+    }
+    if (profile->depth > 1) {
+        profile->depth--;
+    }
+}
+
+static void profile_on_interrupt(VM *vm, uint8_t vector, void *data) {
+    Profile *profile = (Profile *)data;
+    profile_prune(vm, profile);
+    profile_push(profile, (uint16_t)vm->registers[R3_PC], vm->interrupt_depth, PROFILE_NO_RETURN);
+}
+
+static const VMHooks profile_hooks = {
+    .call = profile_on_call,
+    .ret = profile_on_ret,
+    .interrupt = profile_on_interrupt
+};
+
+static int profile_grow(Profile *profile) {
+    uint32_t slots = profile->slots ? profile->slots * 2 : PROFILE_INITIAL_SLOTS;
+    ProfileStack *stacks = (ProfileStack *)calloc(slots, sizeof(ProfileStack));
+    if (!stacks) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < profile->slots; i++) {
+        ProfileStack *stack = &profile->stacks[i];
+        if (stack->depth) {
+            uint32_t slot = stack->hash & (slots - 1);
+            while (stacks[slot].depth) {
+                slot = (slot + 1) & (slots - 1);
+            }
+            stacks[slot] = *stack;
+        }
+    }
+
+    free(profile->stacks);
+    profile->stacks = stacks;
+    profile->slots = slots;
+    return 1;
+}
+
+// Charge one sample to the current shadow stack
+static void profile_count_stack(Profile *profile) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < profile->depth; i++) {
+        hash = (hash ^ profile->frames[i].function) * 16777619u;
+    }
+
+    // Keep the table at most 3/4 full
+    if ((profile->stack_count + 1) * 4 > profile->slots * 3 && !profile_grow(profile)) {
+        return;
+    }
+
+    uint32_t slot = hash & (profile->slots - 1);
+    for (;;) {
+        ProfileStack *stack = &profile->stacks[slot];
+        if (!stack->depth) {
+            stack->hash = hash;
+            stack->depth = (uint16_t)profile->depth;
+            for (int i = 0; i < profile->depth; i++) {
+                stack->frames[i] = profile->frames[i].function;
+            }
+            stack->samples = 1;
+            profile->stack_count++;
+            return;
+        }
+        if (stack->hash == hash && stack->depth == profile->depth) {
+            int i = 0;
+            while (i < profile->depth && stack->frames[i] == profile->frames[i].function) {
+                i++;
+            }
+            if (i == profile->depth) {
+                stack->samples++;
+                return;
+            }
+        }
+        slot = (slot + 1) & (profile->slots - 1);
+    }
+}
+
+// Virtual-time sampling event
+static void profile_sample(VM *vm, void *data) {
+    Profile *profile = (Profile *)data;
+
+    profile_prune(vm, profile);
+    profile->pc_samples[(uint16_t)vm->registers[R3_PC]]++;
+    profile->samples++;
+    profile_count_stack(profile);
+
+    events_schedule(vm, profile_next_delay(profile), profile_sample, profile);
+}
+
+int profile_start(VM *vm, uint32_t interval) {
+    if (!vm) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    profile_stop(vm);
+
+    Profile *profile = (Profile *)calloc(1, sizeof(Profile));
+    uint32_t *pc_samples = (uint32_t *)calloc(PROFILE_ADDRESSES, sizeof(uint32_t));
+    if (!profile || !pc_samples || !profile_grow(profile)) {
+        free(profile ? profile->stacks : NULL);
+        free(profile);
+        free(pc_samples);
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate profiler");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    profile->interval = interval ? interval : PROFILE_DEFAULT_INTERVAL;
+    profile->jitter = 0x9E3779B9;
+    profile->pc_samples = pc_samples;
+
+    // The root frame is where the program starts
+    profile_push(profile, (uint16_t)vm->registers[R3_PC], vm->interrupt_depth, PROFILE_NO_RETURN);
+
+    int result = hooks_add(vm, &profile_hooks, profile);
+    if (result == VM_ERROR_NONE) {
+        result = events_schedule(vm, profile_next_delay(profile), profile_sample, profile);
+        if (result != VM_ERROR_NONE) {
+            hooks_remove(vm, &profile_hooks, profile);
+        }
+    }
+    if (result != VM_ERROR_NONE) {
+        free(profile->stacks);
+        free(profile->pc_samples);
+        free(profile);
+        return result;
+    }
+
+    vm->profile = profile;
+    return VM_ERROR_NONE;
+}
+
+// Frame name: the symbol at the address, or its offset from the one before
+static void profile_frame_name(VM *vm, uint16_t address, char *name, size_t size) {
+    Symbol *symbol = find_symbol_by_address(vm, address);
+    if (symbol && symbol->address == address) {
+        snprintf(name, size, "%s", symbol->name);
+    } else if (symbol) {
+        snprintf(name, size, "%s+0x%X", symbol->name, address - symbol->address);
+    } else {
+        snprintf(name, size, "0x%04X", address);
+    }
+}
+
+int profile_write_folded(VM *vm, const char *path) {
+    Profile *profile = vm ? (Profile *)vm->profile : NULL;
+    if (!profile || !path) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Cannot open profile '%s': %s", path, strerror(errno));
+        return VM_ERROR_IO_ERROR;
+    }
+
+    char name[128];
+    for (uint32_t i = 0; i < profile->slots; i++) {
+        ProfileStack *stack = &profile->stacks[i];
+        if (!stack->depth) {
+            continue;
+        }
+        for (int f = 0; f < stack->depth; f++) {
+            profile_frame_name(vm, stack->frames[f], name, sizeof(name));
+            fprintf(file, f ? ";%s" : "%s", name);
+        }
+        fprintf(file, " %llu\n", (unsigned long long)stack->samples);
+    }
+
+    if (fclose(file) != 0) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Cannot write profile '%s': %s", path, strerror(errno));
+        return VM_ERROR_IO_ERROR;
+    }
+    return VM_ERROR_NONE;
+}
+
+// Most samples first, then by address or line for a stable order
+static int profile_row_compare(const void *a, const void *b) {
+    const ProfileRow *x = (const ProfileRow *)a;
+    const ProfileRow *y = (const ProfileRow *)b;
+    if (x->self != y->self) {
+        return x->self < y->self ? 1 : -1;
+    }
+    return x->key < y->key ? -1 : x->key > y->key;
+}
+
+// Self and total samples per function, from the stack table
+static ProfileRow *profile_function_rows(Profile *profile, uint32_t *count) {
+    ProfileRow *rows = (ProfileRow *)calloc(PROFILE_ADDRESSES, sizeof(ProfileRow));
+    if (!rows) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < profile->slots; i++) {
+        ProfileStack *stack = &profile->stacks[i];
+        if (!stack->depth) {
+            continue;
+        }
+        rows[stack->frames[stack->depth - 1]].self += stack->samples;
+
+        // Recursive functions count once per sample in their total
+        for (int f = 0; f < stack->depth; f++) {
+            int seen = 0;
+            for (int g = 0; g < f && !seen; g++) {
+                seen = stack->frames[g] == stack->frames[f];
+            }
+            if (!seen) {
+                rows[stack->frames[f]].total += stack->samples;
+            }
+        }
+    }
+
+    uint32_t n = 0;
+    for (uint32_t address = 0; address < PROFILE_ADDRESSES; address++) {
+        if (rows[address].total) {
+            rows[n] = rows[address];
+            rows[n].key = address;
+            n++;
+        }
+    }
+    *count = n;
+    return rows;
+}
+
+// Self samples per source line; key is the index in the line table
+static ProfileRow *profile_line_rows(VM *vm, Profile *profile, uint32_t *count) {
+    DebugInfo *info = vm->debug_info;
+    ProfileRow *rows = (ProfileRow *)calloc(info->source_line_count, sizeof(ProfileRow));
+    if (!rows) {
+        return NULL;
+    }
+
+    for (uint32_t address = 0; address < PROFILE_ADDRESSES; address++) {
+        if (profile->pc_samples[address]) {
+            SourceLine *line = find_source_line_by_address(vm, address);
+            if (line) {
+                rows[line - info->source_lines].self += profile->pc_samples[address];
+            }
+        }
+    }
+
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < info->source_line_count; i++) {
+        if (rows[i].self) {
+            rows[n] = rows[i];
+            rows[n].key = i;
+            n++;
+        }
+    }
+    *count = n;
+    return rows;
+}
+
+void profile_report(VM *vm, int top) {
+    Profile *profile = vm ? (Profile *)vm->profile : NULL;
+    if (!profile) {
+        return;
+    }
+
+    double scale = profile->samples ? 100.0 / profile->samples : 0.0;
+    uint32_t count;
+    char name[128];
+
+    vm_log(vm, "Profile: %llu samples, one per %u instructions on average\n",
+           (unsigned long long)profile->samples, profile->interval);
+    if (!profile->samples) {
+        return;
+    }
+
+    ProfileRow *rows = profile_function_rows(profile, &count);
+    if (rows) {
+        qsort(rows, count, sizeof(ProfileRow), profile_row_compare);
+        vm_log(vm, "  %10s %7s %7s  %s\n", "Self", "Self%", "Total%", "Function");
+        for (uint32_t i = 0; i < count && (int)i < top; i++) {
+            profile_frame_name(vm, (uint16_t)rows[i].key, name, sizeof(name));
+            vm_log(vm, "  %10llu %6.2f%% %6.2f%%  %s\n", (unsigned long long)rows[i].self,
+                   rows[i].self * scale, rows[i].total * scale, name);
+        }
+        free(rows);
+    }
+
+    if (!vm->debug_info || !vm->debug_info->source_line_count) {
+        vm_log(vm, "  (no source lines: the program has no debug information)\n");
+        return;
+    }
+
+    rows = profile_line_rows(vm, profile, &count);
+    if (rows) {
+        qsort(rows, count, sizeof(ProfileRow), profile_row_compare);
+        vm_log(vm, "  %10s %7s  %s\n", "Self", "Self%", "Line");
+        for (uint32_t i = 0; i < count && (int)i < top; i++) {
+            SourceLine *line = &vm->debug_info->source_lines[rows[i].key];
+            const char *source = line->source ? line->source : "";
+            while (*source == ' ' || *source == '\t') {
+                source++;
+            }
+            snprintf(name, sizeof(name), "%s:%u", line->source_file ? line->source_file : "?",
+                     line->line_num);
+            vm_log(vm, "  %10llu %6.2f%%  %-24s %s\n", (unsigned long long)rows[i].self,
+                   rows[i].self * scale, name, source);
+        }
+        free(rows);
+    }
+}
+
+void profile_stop(VM *vm) {
+    Profile *profile = vm ? (Profile *)vm->profile : NULL;
+    if (!profile) {
+        return;
+    }
+
+    hooks_remove(vm, &profile_hooks, profile);
+    events_cancel(vm, profile_sample, profile);
+    free(profile->stacks);
+    free(profile->pc_samples);
+    free(profile);
+    vm->profile = NULL;
+}
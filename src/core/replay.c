@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "vm.h"
+#include "replay.h"
+#include "clock.h"
+#include "random.h"
+
+// Open log and the state needed to encode or decode it
+typedef struct {
+    FILE *file;
+    char *buffer;                         // stdio buffer for the log
+    uint32_t last_count;                  // Instruction count of the previous record
+    int64_t last_value[REPLAY_KINDS];     // Values are logged as changes per kind
+    uint32_t skipped[REPLAY_KINDS];       // Event calls since the last record of the kind
+    uint64_t records;
+
+    // Playback: header of the next record, read ahead
+    int has_next;
+    uint8_t next_kind;
+    uint32_t next_count;
+    uint32_t next_skip;
+    uint64_t next_raw;                    // Value change, or data length
+} Replay;
+
+static void replay_write_varint(FILE *file, uint64_t value) {
+    while (value >= 0x80) {
+        putc((int)(value & 0x7F) | 0x80, file);
+        value >>= 7;
+    }
+    putc((int)value, file);
+}
+
+// Returns 1 on success, 0 at a clean end of file, -1 if the log is cut off
+static int replay_read_varint(FILE *file, uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = getc(file);
+        if (c == EOF) {
+            return shift == 0 ? 0 : -1;
+        }
+        *value |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)) {
+            return 1;
+        }
+    }
+    return -1;
+}
+
+static uint64_t replay_zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t replay_unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// Stop the run: the program has left the recorded path
+static void replay_fail(VM *vm, const char *reason, uint8_t kind) {
+    Replay *replay = (Replay *)vm->replay;
+    if (vm->last_error != VM_ERROR_NONE) {
+        return;  // Keep the first error
+    }
+
+    vm->last_error = VM_ERROR_REPLAY;
+    if (replay->has_next) {
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Replay diverged at instruction %u: %s (wanted kind 0x%02X, "
+                 "log has 0x%02X at instruction %u)", vm->instruction_count, reason,
+                 kind, replay->next_kind, replay->next_count);
+    } else {
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Replay diverged at instruction %u: %s (wanted kind 0x%02X)",
+                 vm->instruction_count, reason, kind);
+    }
+}
+
+// Read the next record header; the payload of data records stays in the file
+static void replay_read_ahead(VM *vm, Replay *replay) {
+    uint64_t delta = 0;
+    int kind = getc(replay->file);
+
+    replay->has_next = 0;
+    if (kind == EOF) {
+        return;
+    }
+
+    int ok = replay_read_varint(replay->file, &delta) > 0;
+    replay->next_skip = 0;
+    if (ok && (kind & REPLAY_EVENT)) {
+        uint64_t skip;
+        ok = replay_read_varint(replay->file, &skip) > 0;
+        replay->next_skip = (uint32_t)skip;
+    }
+    ok = ok && replay_read_varint(replay->file, &replay->next_raw) > 0;
+    if (!ok) {
+        replay_fail(vm, "log is cut off", (uint8_t)kind);
+        return;
+    }
+
+    replay->has_next = 1;
+    replay->next_kind = (uint8_t)kind;
+    replay->next_count = replay->last_count + (uint32_t)delta;
+}
+
+// Append a record header
+static void replay_write_header(VM *vm, Replay *replay, uint8_t kind, uint64_t raw) {
+    putc(kind, replay->file);
+    replay_write_varint(replay->file, vm->instruction_count - replay->last_count);
+    if (kind & REPLAY_EVENT) {
+        replay_write_varint(replay->file, replay->skipped[kind & REPLAY_KIND_MASK]);
+        replay->skipped[kind & REPLAY_KIND_MASK] = 0;
+    }
+    replay_write_varint(replay->file, raw);
+    replay->last_count = vm->instruction_count;
+    replay->records++;
+}
+
+// Playback: consume the next record if it was taken here, by this call.
+// Returns 1 if consumed, 0 for an event call that was not logged.
+static int replay_take(VM *vm, Replay *replay, uint8_t kind) {
+    int here = replay->has_next && replay->next_kind == kind &&
+               replay->next_count == vm->instruction_count;
+
+    // A record from an earlier instruction was never asked for
+    if (replay->has_next && (int32_t)(replay->next_count - vm->instruction_count) < 0) {
+        replay_fail(vm, "input not taken", kind);
+        return 0;
+    }
+
+    if (kind & REPLAY_EVENT) {
+        uint32_t *skipped = &replay->skipped[kind & REPLAY_KIND_MASK];
+        if (!here || replay->next_skip != *skipped) {
+            // Not this call; it must be a later one
+            if (here && replay->next_skip < *skipped) {
+                replay_fail(vm, "event missed", kind);
+            }
+            (*skipped)++;
+            return 0;
+        }
+        *skipped = 0;
+    } else if (!here) {
+        replay_fail(vm, replay->has_next ? "unexpected input" : "log ended", kind);
+        return 0;
+    }
+
+    replay->last_count = replay->next_count;
+    replay->records++;
+    return 1;
+}
+
+int64_t replay_value(VM *vm, uint8_t kind, int64_t value) {
+    Replay *replay = (Replay *)vm->replay;
+    int64_t *last = &replay->last_value[kind & REPLAY_KIND_MASK];
+
+    if (vm->replay_mode == REPLAY_RECORD) {
+        if ((kind & REPLAY_EVENT) && value == 0) {
+            replay->skipped[kind & REPLAY_KIND_MASK]++;
+        } else {
+            replay_write_header(vm, replay, kind, replay_zigzag(value - *last));
+            *last = value;
+        }
+        return value;
+    }
+
+    if (!replay_take(vm, replay, kind)) {
+        return 0;
+    }
+    *last += replay_unzigzag(replay->next_raw);
+    value = *last;
+    replay_read_ahead(vm, replay);
+    return value;
+}
+
+void replay_data(VM *vm, uint8_t kind, void *data, uint32_t len) {
+    Replay *replay = (Replay *)vm->replay;
+
+    if (vm->replay_mode == REPLAY_RECORD) {
+        replay_write_header(vm, replay, kind, len);
+        fwrite(data, 1, len, replay->file);
+        return;
+    }
+
+    if (!replay_take(vm, replay, kind)) {
+        return;
+    }
+    if (replay->next_raw != len || fread(data, 1, len, replay->file) != len) {
+        replay->has_next = 0;
+        replay_fail(vm, "data length differs", kind);
+        return;
+    }
+    replay_read_ahead(vm, replay);
+}
+
+int replay_start(VM *vm, const char *path, int mode) {
+    if (!vm || !path || (mode != REPLAY_RECORD && mode != REPLAY_PLAYBACK)) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    replay_stop(vm);
+
+    Replay *replay = (Replay *)calloc(1, sizeof(Replay));
+    char *buffer = (char *)malloc(REPLAY_BUFFER_SIZE);
+    if (!replay || !buffer) {
+        free(replay);
+        free(buffer);
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate replay log");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    replay->file = fopen(path, mode == REPLAY_RECORD ? "wb" : "rb");
+    if (!replay->file) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Cannot open replay log '%s': %s", path, strerror(errno));
+        free(buffer);
+        free(replay);
+        return VM_ERROR_IO_ERROR;
+    }
+    replay->buffer = buffer;
+    setvbuf(replay->file, buffer, _IOFBF, REPLAY_BUFFER_SIZE);
+    replay->last_count = vm->instruction_count;
+
+    // Header: everything else the run depends on that is fixed at the start
+    uint8_t header[4 + 2 + RANDOM_STATE_WORDS * 8];
+    memcpy(header, REPLAY_MAGIC, 4);
+    header[4] = REPLAY_VERSION;
+    header[5] = vm->clock_mode;
+    if (mode == REPLAY_RECORD) {
+        for (int i = 0; i < RANDOM_STATE_WORDS; i++) {
+            for (int b = 0; b < 8; b++) {
+                header[6 + i * 8 + b] = (uint8_t)(vm->random_state[i] >> (b * 8));
+            }
+        }
+        fwrite(header, 1, sizeof(header), replay->file);
+    } else {
+        uint8_t expected[5];
+        memcpy(expected, header, sizeof(expected));
+        if (fread(header, 1, sizeof(header), replay->file) != sizeof(header) ||
+            memcmp(header, expected, sizeof(expected)) != 0) {
+            vm->last_error = VM_ERROR_REPLAY;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "'%s' is not a replay log of this version", path);
+            fclose(replay->file);
+            free(buffer);
+            free(replay);
+            return VM_ERROR_REPLAY;
+        }
+
+        for (int i = 0; i < RANDOM_STATE_WORDS; i++) {
+            vm->random_state[i] = 0;
+            for (int b = 0; b < 8; b++) {
+                vm->random_state[i] |= (uint64_t)header[6 + i * 8 + b] << (b * 8);
+            }
+        }
+        if (header[5] != vm->clock_mode) {
+            clock_init(vm, header[5]);
+        }
+    }
+
+    vm->replay = replay;
+    vm->replay_mode = (uint8_t)mode;
+    if (mode == REPLAY_PLAYBACK) {
+        replay_read_ahead(vm, replay);
+    }
+    return VM_ERROR_NONE;
+}
+
+void replay_stop(VM *vm) {
+    if (!vm || !vm->replay) {
+        return;
+    }
+
+    Replay *replay = (Replay *)vm->replay;
+    if (vm->replay_mode == REPLAY_RECORD) {
+        if (fflush(replay->file) != 0 || ferror(replay->file)) {
+            fprintf(stderr, "Warning: replay log is incomplete: %s\n", strerror(errno));
+        }
+    } else if (replay->has_next && vm->last_error == VM_ERROR_NONE) {
+        fprintf(stderr, "Warning: replay stopped at instruction %u with records left "
+                "(next at instruction %u)\n", vm->instruction_count, replay->next_count);
+    }
+
+    vm_log(vm, "Replay: %llu records %s\n", (unsigned long long)replay->records,
+           vm->replay_mode == REPLAY_RECORD ? "recorded" : "replayed");
+
+    fclose(replay->file);
+    free(replay->buffer);
+    free(replay);
+    vm->replay = NULL;
+    vm->replay_mode = REPLAY_OFF;
+}
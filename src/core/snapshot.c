@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "vm.h"
+#include "snapshot.h"
+#include "memory.h"
+#include "io_manager.h"
+#include "events.h"
+#include "console.h"
+#include "files.h"
+#include "clock.h"
+
+typedef struct {
+    char     magic[4];
+    uint32_t version;
+    uint32_t memory_size;
+    uint32_t core_size;       // sizeof(SnapshotCore), guards against other builds
+    uint64_t memory_offset;   // Start of the memory image
+} SnapshotHeader;
+
+// CPU and VM-wide state
+typedef struct {
+    uint32_t registers[16];
+    uint32_t shadow_registers[SHADOW_BANK_DEPTH][16];
+    uint32_t instruction_count;
+    uint32_t interrupt_vector;
+    uint64_t random_state[4];
+    uint64_t clock_ns;        // Guest clock reading when saved
+    uint8_t  clock_mode;
+    uint8_t  halted;
+    uint8_t  interrupt_enabled;
+    uint8_t  fast_interrupts;
+    uint8_t  interrupt_depth;
+    uint8_t  shadow_depth;
+} SnapshotCore;
+
+static int snapshot_fail(VM *vm, const char *path, const char *what) {
+    vm->last_error = VM_ERROR_IO_ERROR;
+    snprintf(vm->error_message, sizeof(vm->error_message),
+             "Snapshot '%s': %s", path, what);
+    return VM_ERROR_IO_ERROR;
+}
+
+static int snapshot_page_is_zero(const uint8_t *page, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (page[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int snapshot_save(VM *vm, const char *path) {
+    if (!vm || !vm->memory || !path) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    console_flush(vm);
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return snapshot_fail(vm, path, strerror(errno));
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.memory_size = vm->memory_size;
+    header.core_size = sizeof(SnapshotCore);
+
+    SnapshotCore core;
+    memset(&core, 0, sizeof(core));
+    memcpy(core.registers, vm->registers, sizeof(core.registers));
+    memcpy(core.shadow_registers, vm->shadow_registers, sizeof(core.shadow_registers));
+    memcpy(core.random_state, vm->random_state, sizeof(core.random_state));
+    core.instruction_count = vm->instruction_count;
+    core.interrupt_vector = vm->interrupt_vector;
+    core.clock_ns = clock_now_ns(vm);
+    core.clock_mode = vm->clock_mode;
+    core.halted = vm->halted;
+    core.interrupt_enabled = vm->interrupt_enabled;
+    core.fast_interrupts = vm->fast_interrupts;
+    core.interrupt_depth = vm->interrupt_depth;
+    core.shadow_depth = vm->shadow_depth;
+
+    // The header goes in last, once the memory offset is known
+    int ok = fseek(file, sizeof(header), SEEK_SET) == 0 &&
+             fwrite(&core, sizeof(core), 1, file) == 1 &&
+             io_save_state(vm, file) == VM_ERROR_NONE;
+
+    if (ok) {
+        long end = ftell(file);
+        header.memory_offset = ((uint64_t)end + SNAPSHOT_ALIGN - 1) & ~(uint64_t)(SNAPSHOT_ALIGN - 1);
+
+        // Write only pages with data; the skipped ones read back as zeros
+        for (uint32_t offset = 0; ok && offset < vm->memory_size; offset += SNAPSHOT_PAGE) {
+            size_t len = vm->memory_size - offset < SNAPSHOT_PAGE ? vm->memory_size - offset : SNAPSHOT_PAGE;
+            if (!snapshot_page_is_zero(vm->memory + offset, len)) {
+                ok = fseek(file, (long)(header.memory_offset + offset), SEEK_SET) == 0 &&
+                     fwrite(vm->memory + offset, 1, len, file) == len;
+            }
+        }
+
+        ok = ok && fflush(file) == 0 &&
+             ftruncate(fileno(file), (off_t)(header.memory_offset + vm->memory_size)) == 0 &&
+             fseek(file, 0, SEEK_SET) == 0 &&
+             fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    if (fclose(file) != 0 || !ok) {
+        if (vm->last_error == VM_ERROR_NONE) {
+            snapshot_fail(vm, path, "write failed");
+        }
+        return vm->last_error;
+    }
+    return VM_ERROR_NONE;
+}
+
+int snapshot_restore(VM *vm, const char *path) {
+    if (!vm || !path) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return snapshot_fail(vm, path, strerror(errno));
+    }
+
+    SnapshotHeader header;
+    SnapshotCore core;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION || header.core_size != sizeof(SnapshotCore) ||
+        header.memory_size == 0 || header.memory_offset % SNAPSHOT_ALIGN != 0 ||
+        fread(&core, sizeof(core), 1, file) != 1) {
+        fclose(file);
+        return snapshot_fail(vm, path, "not a snapshot from this version");
+    }
+
+    // The image replaces memory of the size this VM was set up with
+    if (header.memory_size != vm->memory_size) {
+        char what[96];
+        snprintf(what, sizeof(what), "saved with %u KB of memory, this VM has %u KB (see -m)",
+                 header.memory_size / 1024, vm->memory_size / 1024);
+        fclose(file);
+        return snapshot_fail(vm, path, what);
+    }
+
+    int result = memory_map_image(vm, fileno(file), header.memory_offset, header.memory_size);
+    if (result != VM_ERROR_NONE) {
+        fclose(file);
+        return result;
+    }
+
+    // Events already scheduled (by devices attached before the restore) keep
+    // their distance from the current instruction
+    events_shift(vm, core.instruction_count - vm->instruction_count);
+    vm->instruction_count = core.instruction_count;
+
+    memcpy(vm->registers, core.registers, sizeof(core.registers));
+    memcpy(vm->shadow_registers, core.shadow_registers, sizeof(core.shadow_registers));
+    memcpy(vm->random_state, core.random_state, sizeof(core.random_state));
+    vm->interrupt_vector = core.interrupt_vector;
+    vm->halted = core.halted;
+    vm->interrupt_enabled = core.interrupt_enabled;
+    vm->fast_interrupts = core.fast_interrupts;
+    vm->interrupt_depth = core.interrupt_depth;
+    vm->shadow_depth = core.shadow_depth;
+    clock_restore(vm, core.clock_mode, core.clock_ns);
+
+    // Host file descriptors can't be carried over
+    files_close_all(vm);
+
+    result = io_restore_state(vm, file);
+    fclose(file);
+    return result;
+}
@@ -0,0 +1,407 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "vm.h"
+#include "stats.h"
+#include "hooks.h"
+#include "decoder.h"
+#include "syscalls.h"
+#include "instruction_set.h"
+
+#define STATS_OPCODES  256
+#define STATS_MODES    16
+#define STATS_SEGMENTS 4     // code, data, stack, heap: 16 KB each
+#define STATS_CALIBRATION_ROUNDS 1000
+
+// Executions and sampled host time of one opcode or mode
+typedef struct {
+    uint64_t count;
+    uint64_t timed;          // Executions that were timed
+    uint64_t timed_ns;       // Host time of the timed executions
+} StatsCounter;
+
+typedef struct {
+    uint64_t reads;
+    uint64_t read_bytes;
+    uint64_t writes;
+    uint64_t write_bytes;
+} StatsSegment;
+
+typedef struct {
+    StatsCounter opcodes[STATS_OPCODES];
+    StatsCounter modes[STATS_MODES];
+    uint64_t taken[STATS_OPCODES];           // Branches taken, by opcode
+    StatsSegment segments[STATS_SEGMENTS];
+    uint64_t syscalls[SYSCALL_TABLE_SIZE];
+    uint8_t last_opcode;
+
+    // Timing of the sampled instruction
+    uint32_t countdown;      // Instructions until the next one is timed
+    uint32_t jitter;         // xorshift32 state for the countdown
+    uint64_t overhead_ns;    // Cost of the clock reads themselves
+    uint8_t timing;          // An instruction is being timed
+    uint8_t timed_opcode;
+    uint8_t timed_mode;
+    uint64_t timing_start;
+} Stats;
+
+static const char *stats_segment_names[STATS_SEGMENTS] = { "code", "data", "stack", "heap" };
+
+static uint64_t stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Smallest time between two clock reads
+static uint64_t stats_clock_overhead(void) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < STATS_CALIBRATION_ROUNDS; i++) {
+        uint64_t start = stats_now_ns();
+        uint64_t elapsed = stats_now_ns() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+// Time the next instruction in 1 .. 2*STATS_TIMING_INTERVAL-1, so loops of
+// any length get each of their instructions timed
+static uint32_t stats_next_countdown(Stats *stats) {
+    uint32_t x = stats->jitter;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    stats->jitter = x;
+    return 1 + x % (2 * STATS_TIMING_INTERVAL - 1);
+}
+
+// Estimated host time of all executions
+static uint64_t stats_total_ns(const StatsCounter *counter) {
+    if (counter->timed == 0) {
+        return 0;
+    }
+    return (uint64_t)((double)counter->timed_ns * counter->count / counter->timed);
+}
+
+static const char *stats_mode_name(uint8_t mode) {
+    switch (mode) {
+        case IMM_MODE:  return "IMM";
+        case REG_MODE:  return "REG";
+        case MEM_MODE:  return "MEM";
+        case REGM_MODE: return "REGM";
+        case IDX_MODE:  return "IDX";
+        case STK_MODE:  return "STK";
+        case BAS_MODE:  return "BAS";
+        default:        return "UNKNOWN";
+    }
+}
+
+// Opcodes that can branch, for the taken/not-taken table
+static int stats_is_branch(uint8_t opcode) {
+    return (opcode >= JMP_OP && opcode <= JA_OP) || opcode == LOOP_OP;
+}
+
+static void stats_on_instruction(VM *vm, uint16_t pc, const Instruction *instr, void *data) {
+    Stats *stats = (Stats *)data;
+
+    // Close the timing of the previous instruction
+    if (stats->timing) {
+        uint64_t elapsed = stats_now_ns() - stats->timing_start;
+        elapsed = elapsed > stats->overhead_ns ? elapsed - stats->overhead_ns : 0;
+        stats->opcodes[stats->timed_opcode].timed++;
+        stats->opcodes[stats->timed_opcode].timed_ns += elapsed;
+        stats->modes[stats->timed_mode].timed++;
+        stats->modes[stats->timed_mode].timed_ns += elapsed;
+        stats->timing = 0;
+    }
+
+    uint8_t mode = instr->mode & (STATS_MODES - 1);
+    stats->opcodes[instr->opcode].count++;
+    stats->modes[mode].count++;
+    stats->last_opcode = instr->opcode;
+
+    if (--stats->countdown == 0) {
+        stats->countdown = stats_next_countdown(stats);
+        stats->timing = 1;
+        stats->timed_opcode = instr->opcode;
+        stats->timed_mode = mode;
+        stats->timing_start = stats_now_ns();  // Last, so this hook isn't charged
+    }
+}
+
+static void stats_on_branch(VM *vm, uint16_t from, uint16_t to, void *data) {
+    Stats *stats = (Stats *)data;
+    stats->taken[stats->last_opcode]++;
+}
+
+static void stats_on_memory_read(VM *vm, uint16_t address, uint16_t size, void *data) {
+    StatsSegment *segment = &((Stats *)data)->segments[address >> 14];
+    segment->reads++;
+    segment->read_bytes += size;
+}
+
+static void stats_on_memory_write(VM *vm, uint16_t address, uint16_t size, void *data) {
+    StatsSegment *segment = &((Stats *)data)->segments[address >> 14];
+    segment->writes++;
+    segment->write_bytes += size;
+}
+
+static void stats_on_syscall(VM *vm, uint16_t number, void *data) {
+    Stats *stats = (Stats *)data;
+    if (number < SYSCALL_TABLE_SIZE) {
+        stats->syscalls[number]++;
+    }
+}
+
+static const VMHooks stats_hooks = {
+    .instruction = stats_on_instruction,
+    .branch = stats_on_branch,
+    .memory_read = stats_on_memory_read,
+    .memory_write = stats_on_memory_write,
+    .syscall = stats_on_syscall
+};
+
+int stats_start(VM *vm) {
+    if (!vm) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    stats_stop(vm);
+
+    Stats *stats = (Stats *)calloc(1, sizeof(Stats));
+    if (!stats) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate statistics");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    stats->jitter = 0x9E3779B9;
+    stats->countdown = stats_next_countdown(stats);
+    stats->overhead_ns = stats_clock_overhead();
+
+    int result = hooks_add(vm, &stats_hooks, stats);
+    if (result != VM_ERROR_NONE) {
+        free(stats);
+        return result;
+    }
+
+    vm->stats = stats;
+    return VM_ERROR_NONE;
+}
+
+// Sort key of an executed opcode
+typedef struct {
+    uint8_t opcode;
+    uint64_t ns;
+    uint64_t count;
+} StatsOrder;
+
+// Estimated host time first, then count
+static int stats_order_compare(const void *a, const void *b) {
+    const StatsOrder *x = (const StatsOrder *)a;
+    const StatsOrder *y = (const StatsOrder *)b;
+    if (x->ns != y->ns) {
+        return x->ns < y->ns ? 1 : -1;
+    }
+    if (x->count != y->count) {
+        return x->count < y->count ? 1 : -1;
+    }
+    return x->opcode - y->opcode;
+}
+
+// Executed opcodes, hottest first; returns how many
+static int stats_sorted_opcodes(Stats *stats, uint8_t *order) {
+    StatsOrder keys[STATS_OPCODES];
+    int n = 0;
+    for (int op = 0; op < STATS_OPCODES; op++) {
+        if (stats->opcodes[op].count) {
+            keys[n].opcode = (uint8_t)op;
+            keys[n].ns = stats_total_ns(&stats->opcodes[op]);
+            keys[n].count = stats->opcodes[op].count;
+            n++;
+        }
+    }
+    qsort(keys, n, sizeof(keys[0]), stats_order_compare);
+    for (int i = 0; i < n; i++) {
+        order[i] = keys[i].opcode;
+    }
+    return n;
+}
+
+void stats_report(VM *vm) {
+    Stats *stats = vm ? (Stats *)vm->stats : NULL;
+    if (!stats) {
+        return;
+    }
+
+    uint64_t total = 0;
+    uint64_t total_ns = 0;
+    for (int op = 0; op < STATS_OPCODES; op++) {
+        total += stats->opcodes[op].count;
+        total_ns += stats_total_ns(&stats->opcodes[op]);
+    }
+    double scale = total ? 100.0 / total : 0.0;
+    double ns_scale = total_ns ? 100.0 / total_ns : 0.0;
+
+    vm_log(vm, "Statistics: %llu instructions, about %.1f ms host time "
+           "(clock overhead %llu ns subtracted)\n", (unsigned long long)total,
+           total_ns / 1e6, (unsigned long long)stats->overhead_ns);
+
+    uint8_t order[STATS_OPCODES];
+    int n = stats_sorted_opcodes(stats, order);
+    vm_log(vm, "  %-8s %14s %7s %12s %7s %8s\n", "Opcode", "Count", "Count%", "Time (us)", "Time%", "ns/exec");
+    for (int i = 0; i < n; i++) {
+        const StatsCounter *counter = &stats->opcodes[order[i]];
+        uint64_t ns = stats_total_ns(counter);
+        vm_log(vm, "  %-8s %14llu %6.2f%% %12.1f %6.2f%% %8.1f\n", vm_opcode_to_mnemonic(order[i]),
+               (unsigned long long)counter->count, counter->count * scale, ns / 1000.0,
+               ns * ns_scale, counter->timed ? (double)counter->timed_ns / counter->timed : 0.0);
+    }
+
+    vm_log(vm, "  %-8s %14s %7s %12s %7s %8s\n", "Mode", "Count", "Count%", "Time (us)", "Time%", "ns/exec");
+    for (int mode = 0; mode < STATS_MODES; mode++) {
+        const StatsCounter *counter = &stats->modes[mode];
+        if (!counter->count) {
+            continue;
+        }
+        uint64_t ns = stats_total_ns(counter);
+        vm_log(vm, "  %-8s %14llu %6.2f%% %12.1f %6.2f%% %8.1f\n", stats_mode_name((uint8_t)mode),
+               (unsigned long long)counter->count, counter->count * scale, ns / 1000.0,
+               ns * ns_scale, counter->timed ? (double)counter->timed_ns / counter->timed : 0.0);
+    }
+
+    vm_log(vm, "  %-8s %14s %14s %14s %7s\n", "Branch", "Executed", "Taken", "Not taken", "Taken%");
+    for (int op = 0; op < STATS_OPCODES; op++) {
+        uint64_t count = stats->opcodes[op].count;
+        if (!count || !stats_is_branch((uint8_t)op)) {
+            continue;
+        }
+        vm_log(vm, "  %-8s %14llu %14llu %14llu %6.2f%%\n", vm_opcode_to_mnemonic((uint8_t)op),
+               (unsigned long long)count, (unsigned long long)stats->taken[op],
+               (unsigned long long)(count - stats->taken[op]), 100.0 * stats->taken[op] / count);
+    }
+
+    vm_log(vm, "  %-8s %14s %14s %14s %14s\n", "Segment", "Reads", "Read bytes", "Writes", "Write bytes");
+    for (int s = 0; s < STATS_SEGMENTS; s++) {
+        const StatsSegment *segment = &stats->segments[s];
+        vm_log(vm, "  %-8s %14llu %14llu %14llu %14llu\n", stats_segment_names[s],
+               (unsigned long long)segment->reads, (unsigned long long)segment->read_bytes,
+               (unsigned long long)segment->writes, (unsigned long long)segment->write_bytes);
+    }
+
+    int header = 0;
+    for (int number = 0; number < SYSCALL_TABLE_SIZE; number++) {
+        if (!stats->syscalls[number]) {
+            continue;
+        }
+        if (!header) {
+            vm_log(vm, "  %-8s %-16s %14s %12s\n", "Syscall", "Name", "Calls", "Time (us)");
+            header = 1;
+        }
+        const SyscallEntry *entry = syscalls_lookup(vm, (uint16_t)number);
+        vm_log(vm, "  %-8d %-16s %14llu %12.1f\n", number, entry ? entry->name : "?",
+               (unsigned long long)stats->syscalls[number], syscalls_total_ns(entry) / 1000.0);
+    }
+}
+
+static void stats_write_counter(FILE *file, const char *key, const char *name,
+                                const StatsCounter *counter) {
+    fprintf(file, "{\"%s\": \"%s\", \"count\": %llu, \"timed\": %llu, \"ns\": %llu}",
+            key, name, (unsigned long long)counter->count, (unsigned long long)counter->timed,
+            (unsigned long long)stats_total_ns(counter));
+}
+
+int stats_write_json(VM *vm, const char *path) {
+    Stats *stats = vm ? (Stats *)vm->stats : NULL;
+    if (!stats || !path) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Cannot open statistics file '%s': %s", path, strerror(errno));
+        return VM_ERROR_IO_ERROR;
+    }
+
+    uint8_t order[STATS_OPCODES];
+    int n = stats_sorted_opcodes(stats, order);
+    const char *separator = "";
+
+    fprintf(file, "{\n  \"instructions\": %u,\n  \"clock_overhead_ns\": %llu,\n  \"opcodes\": [",
+            vm->instruction_count, (unsigned long long)stats->overhead_ns);
+    for (int i = 0; i < n; i++) {
+        fprintf(file, "%s\n    ", i ? "," : "");
+        stats_write_counter(file, "opcode", vm_opcode_to_mnemonic(order[i]), &stats->opcodes[order[i]]);
+    }
+
+    fprintf(file, "\n  ],\n  \"modes\": [");
+    for (int mode = 0; mode < STATS_MODES; mode++) {
+        if (stats->modes[mode].count) {
+            fprintf(file, "%s\n    ", separator);
+            stats_write_counter(file, "mode", stats_mode_name((uint8_t)mode), &stats->modes[mode]);
+            separator = ",";
+        }
+    }
+
+    fprintf(file, "\n  ],\n  \"branches\": [");
+    separator = "";
+    for (int op = 0; op < STATS_OPCODES; op++) {
+        uint64_t count = stats->opcodes[op].count;
+        if (count && stats_is_branch((uint8_t)op)) {
+            fprintf(file, "%s\n    {\"opcode\": \"%s\", \"executed\": %llu, \"taken\": %llu, "
+                    "\"not_taken\": %llu}", separator, vm_opcode_to_mnemonic((uint8_t)op),
+                    (unsigned long long)count, (unsigned long long)stats->taken[op],
+                    (unsigned long long)(count - stats->taken[op]));
+            separator = ",";
+        }
+    }
+
+    fprintf(file, "\n  ],\n  \"memory\": [");
+    for (int s = 0; s < STATS_SEGMENTS; s++) {
+        const StatsSegment *segment = &stats->segments[s];
+        fprintf(file, "%s\n    {\"segment\": \"%s\", \"reads\": %llu, \"read_bytes\": %llu, "
+                "\"writes\": %llu, \"write_bytes\": %llu}", s ? "," : "", stats_segment_names[s],
+                (unsigned long long)segment->reads, (unsigned long long)segment->read_bytes,
+                (unsigned long long)segment->writes, (unsigned long long)segment->write_bytes);
+    }
+
+    fprintf(file, "\n  ],\n  \"syscalls\": [");
+    separator = "";
+    for (int number = 0; number < SYSCALL_TABLE_SIZE; number++) {
+        if (stats->syscalls[number]) {
+            const SyscallEntry *entry = syscalls_lookup(vm, (uint16_t)number);
+            fprintf(file, "%s\n    {\"number\": %d, \"name\": \"%s\", \"calls\": %llu, \"ns\": %llu}",
+                    separator, number, entry ? entry->name : "",
+                    (unsigned long long)stats->syscalls[number],
+                    (unsigned long long)syscalls_total_ns(entry));
+            separator = ",";
+        }
+    }
+    fprintf(file, "\n  ]\n}\n");
+
+    if (fclose(file) != 0) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Cannot write statistics file '%s': %s", path, strerror(errno));
+        return VM_ERROR_IO_ERROR;
+    }
+    return VM_ERROR_NONE;
+}
+
+void stats_stop(VM *vm) {
+    Stats *stats = vm ? (Stats *)vm->stats : NULL;
+    if (!stats) {
+        return;
+    }
+
+    hooks_remove(vm, &stats_hooks, stats);
+    free(stats);
+    vm->stats = NULL;
+}
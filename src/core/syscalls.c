@@ -0,0 +1,653 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "vm_types.h"
+#include "memory.h"
+#include "syscalls.h"
+#include "console.h"
+#include "files.h"
+#include "clock.h"
+#include "random.h"
+#include "channel.h"
+
+// Host monotonic time in nanoseconds, for per-syscall latency
+static uint64_t syscalls_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Group 0-9: Basic console I/O
+
+static int sys_print_char(VM *vm, const uint32_t *args) {
+    console_putc(vm, (char)args[0]);
+    return VM_ERROR_NONE;
+}
+
+static int sys_print_int(VM *vm, const uint32_t *args) {
+    console_printf(vm, "%d", (int)args[0]);
+    return VM_ERROR_NONE;
+}
+
+static int sys_print_string(VM *vm, const uint32_t *args) {
+    uint16_t addr = args[0];
+    char c;
+    
+    while ((c = memory_read_byte(vm, addr)) != 0) {
+        console_putc(vm, c);
+        addr++;
+    }
+    return VM_ERROR_NONE;
+}
+
+static int sys_read_char(VM *vm, const uint32_t *args) {
+    int c = console_getc(vm);
+    vm->registers[R0_ACC] = (c == EOF) ? 0 : c;
+    return VM_ERROR_NONE;
+}
+
+// Read string (up to args[1] chars including the terminator)
+static int sys_read_string(VM *vm, const uint32_t *args) {
+    uint16_t addr = args[0];
+    uint16_t max_len = args[1];
+    uint16_t i = 0;
+    int c;
+    
+    if (max_len == 0) {
+        vm->registers[R0_ACC] = 0; // No characters read
+        vm->registers[R5] = 1;
+        return VM_ERROR_NONE;
+    }
+    
+    // Reserve space for null terminator
+    max_len--;
+    
+    // Make any prompt visible before blocking
+    console_flush(vm);
+    
+    // Read through the console input buffer, shared with syscalls 3 and 52
+    while (i < max_len) {
+        c = console_getc(vm);
+        
+        if (c == EOF || c == '\n') {
+            break;
+        }
+        
+        memory_write_byte(vm, addr + i, (uint8_t)c);
+        i++;
+    }
+    
+    // Add null terminator
+    memory_write_byte(vm, addr + i, 0);
+    
+    // Return number of characters read
+    vm->registers[R0_ACC] = i;
+    return VM_ERROR_NONE;
+}
+
+static int sys_print_hex(VM *vm, const uint32_t *args) {
+    console_printf(vm, "0x%x", (unsigned int)args[0]);
+    return VM_ERROR_NONE;
+}
+
+// Print integer in base args[1]
+static int sys_print_base(VM *vm, const uint32_t *args) {
+    unsigned int value = args[0];
+    unsigned int base = args[1];
+    
+    // Validate base (2-36)
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+    
+    // Simple base conversion (for a more complete implementation, 
+    // you'd want to handle negative numbers specially)
+    char buffer[33];  // Enough for 32-bit number in any base
+    char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    int pos = 0;
+    
+    // Special case for 0
+    if (value == 0) {
+        console_putc(vm, '0');
+        return VM_ERROR_NONE;
+    }
+    
+    // Convert number to string in specified base
+    while (value > 0 && pos < 32) {
+        buffer[pos++] = digits[value % base];
+        value /= base;
+    }
+    
+    // Print in reverse order
+    while (pos > 0) {
+        console_putc(vm, buffer[--pos]);
+    }
+    return VM_ERROR_NONE;
+}
+
+// Print floating point (emulated using fixed-point)
+static int sys_print_fixed(VM *vm, const uint32_t *args) {
+    // Interpret the parameter as fixed-point (16.16 format)
+    int32_t fixed_val = (int32_t)args[0];
+    int32_t integer_part = fixed_val >> 16;
+    uint32_t frac_part = fixed_val & 0xFFFF;
+    
+    // Convert fraction to decimal
+    // (multiply by 10000 and divide by 2^16)
+    uint32_t decimal = (frac_part * 10000) >> 16;
+    
+    console_printf(vm, "%d.%04u", integer_part, decimal);
+    return VM_ERROR_NONE;
+}
+
+static int sys_clear_screen(VM *vm, const uint32_t *args) {
+    console_printf(vm, "\033[2J\033[H"); // ANSI escape sequence to clear screen and move cursor to home
+    return VM_ERROR_NONE;
+}
+
+static int sys_set_color(VM *vm, const uint32_t *args) {
+    uint8_t fg = args[0] & 0xFF;
+    uint8_t bg = (args[0] >> 8) & 0xFF;
+    
+    if (fg == 0xFF) {
+        // Special case for reset - force to default colors
+        // Use the most complete reset sequence possible
+        console_printf(vm, "\033[0;39;49m");  // Reset all attributes and explicitly set default colors
+    } else if (fg < 8) {
+        // ANSI color codes (0-7 standard colors)
+        if (bg < 8) {
+            // Set both foreground and background
+            console_printf(vm, "\033[0;%d;%dm", 30 + fg, 40 + bg);
+        } else {
+            // Set only foreground
+            console_printf(vm, "\033[0;%dm", 30 + fg);
+        }
+    }
+    return VM_ERROR_NONE;
+}
+
+// Group 10-19: File operations
+
+static int sys_file_open(VM *vm, const uint32_t *args) {
+    int32_t handle = files_open(vm, args[0], args[1] & 0xFF);
+    if (vm->last_error != VM_ERROR_NONE) {
+        return vm->last_error;
+    }
+    
+    vm->registers[R0_ACC] = (handle < 0) ? 0 : handle;  // Return file handle
+    vm->registers[R5] = (handle < 0) ? 1 : 0;
+    return VM_ERROR_NONE;
+}
+
+static int sys_file_close(VM *vm, const uint32_t *args) {
+    int32_t result = files_close(vm, args[0]);
+    vm->registers[R0_ACC] = (result < 0) ? 1 : 0;
+    vm->registers[R5] = (result < 0) ? 1 : 0;
+    return VM_ERROR_NONE;
+}
+
+static int sys_file_read(VM *vm, const uint32_t *args) {
+    int32_t count = files_read(vm, args[0], args[1], args[2]);
+    if (vm->last_error != VM_ERROR_NONE) {
+        return vm->last_error;
+    }
+    
+    // Return number of bytes read (0 at end of file)
+    vm->registers[R0_ACC] = (count < 0) ? 0 : count;
+    vm->registers[R5] = (count < 0) ? 1 : 0;
+    return VM_ERROR_NONE;
+}
+
+static int sys_file_write(VM *vm, const uint32_t *args) {
+    int32_t count = files_write(vm, args[0], args[1], args[2]);
+    if (vm->last_error != VM_ERROR_NONE) {
+        return vm->last_error;
+    }
+    
+    // Return number of bytes written
+    vm->registers[R0_ACC] = (count < 0) ? 0 : count;
+    vm->registers[R5] = (count < 0) ? 1 : 0;
+    return VM_ERROR_NONE;
+}
+
+static int sys_file_seek(VM *vm, const uint32_t *args) {
+    int32_t position = files_seek(vm, args[0], (int32_t)args[1], args[2]);
+    
+    // Return the new position
+    vm->registers[R0_ACC] = (position < 0) ? 0 : position;
+    vm->registers[R5] = (position < 0) ? 1 : 0;
+    return VM_ERROR_NONE;
+}
+
+static int sys_file_stat(VM *vm, const uint32_t *args) {
+    int32_t result = files_stat(vm, args[0], args[1]);
+    if (vm->last_error != VM_ERROR_NONE) {
+        return vm->last_error;
+    }
+    
+    vm->registers[R0_ACC] = (result < 0) ? 1 : 0;
+    vm->registers[R5] = (result < 0) ? 1 : 0;
+    return VM_ERROR_NONE;
+}
+
+// Group 20-29: Memory operations
+
+static int sys_mem_alloc(VM *vm, const uint32_t *args) {
+    uint16_t size = args[0];
+    uint16_t addr = memory_allocate(vm, size);
+    
+    if (vm->last_error != VM_ERROR_NONE) {
+        return vm->last_error;
+    }
+    
+    vm->registers[R0_ACC] = addr;  // Return address
+    vm->registers[R5] = (addr == 0) ? 1 : 0;  // Error if allocation failed
+    return VM_ERROR_NONE;
+}
+
+static int sys_mem_free(VM *vm, const uint32_t *args) {
+    uint16_t addr = args[0];
+    int result = memory_free(vm, addr);
+    
+    if (vm->last_error != VM_ERROR_NONE) {
+        return vm->last_error;
+    }
+    
+    vm->registers[R0_ACC] = result;
+    vm->registers[R5] = (result == VM_ERROR_NONE) ? 0 : 1;
+    return VM_ERROR_NONE;
+}
+
+static int sys_mem_copy(VM *vm, const uint32_t *args) {
+    uint16_t dest = args[0];
+    uint16_t src = args[1];
+    uint16_t count = args[2];
+    
+    int result = memory_copy(vm, dest, src, count);
+    
+    if (vm->last_error != VM_ERROR_NONE) {
+        return vm->last_error;
+    }
+    
+    vm->registers[R0_ACC] = count;  // Return bytes copied
+    vm->registers[R5] = (result == VM_ERROR_NONE) ? 0 : 1;
+    return VM_ERROR_NONE;
+}
+
+static int sys_mem_info(VM *vm, const uint32_t *args) {
+    // Return total memory size
+    vm->registers[R0_ACC] = vm->memory_size;
+    
+    // Return segment boundaries and sizes
+    vm->registers[R5] = (CODE_SEGMENT_BASE << 16) | CODE_SEGMENT_SIZE;
+    vm->registers[R6] = (DATA_SEGMENT_BASE << 16) | DATA_SEGMENT_SIZE;
+    vm->registers[R7] = (STACK_SEGMENT_BASE << 16) | STACK_SEGMENT_SIZE;
+    
+    vm->registers[R5] = 0;  // Success
+    return VM_ERROR_NONE;
+}
+
+// Group 30-39: Process control
+
+static int sys_exit(VM *vm, const uint32_t *args) {
+    // Set return code (for potential host program)
+    vm->registers[R0_ACC] = args[0];
+    
+    // Make all guest output visible before exiting
+    console_flush(vm);
+    
+    // Halt the VM
+    vm->halted = 1;
+    return VM_ERROR_NONE;
+}
+
+// Sleep; in virtual time mode this only advances the clock
+static int sys_sleep(VM *vm, const uint32_t *args) {
+    uint64_t ns = (uint64_t)args[0] * 1000000ULL;
+    
+    // With the console input interrupt enabled, input ends a host sleep early
+    if (vm->clock_mode == CLOCK_MODE_VIRTUAL || console_wait_input(vm, ns) < 0) {
+        clock_sleep_ns(vm, ns);
+    }
+    return VM_ERROR_NONE;
+}
+
+// Milliseconds since VM start
+static int sys_get_time(VM *vm, const uint32_t *args) {
+    vm->registers[R0_ACC] = (uint32_t)(clock_now_ns(vm) / 1000000ULL);
+    vm->registers[R5] = 0;  // Success
+    return VM_ERROR_NONE;
+}
+
+// Microseconds since VM start (low 32 bits)
+static int sys_perf_counter(VM *vm, const uint32_t *args) {
+    vm->registers[R0_ACC] = (uint32_t)(clock_now_ns(vm) / 1000ULL);
+    vm->registers[R5] = 0;  // Success
+    return VM_ERROR_NONE;
+}
+
+// Group 40-49: Random number generation and misc
+
+// Random number in [0, args[0]]; 0 means the full 32-bit range
+static int sys_random(VM *vm, const uint32_t *args) {
+    uint32_t max_val = args[0];
+    if (max_val == 0 || max_val == 0xFFFFFFFF) {
+        vm->registers[R0_ACC] = (uint32_t)(random_next(vm->random_state) >> 32);
+    } else {
+        vm->registers[R0_ACC] = random_below(vm->random_state, max_val + 1);
+    }
+    vm->registers[R5] = 0;  // Success
+    return VM_ERROR_NONE;
+}
+
+static int sys_seed_random(VM *vm, const uint32_t *args) {
+    random_seed(vm->random_state, args[0]);
+    
+    vm->registers[R0_ACC] = 0;  // Success
+    vm->registers[R5] = 0;
+    return VM_ERROR_NONE;
+}
+
+// Fill a guest buffer with random bytes (args[0]=address, args[1]=length)
+static int sys_random_fill(VM *vm, const uint32_t *args) {
+    uint16_t addr = args[0];
+    uint16_t len = args[1];
+    
+    if (len > 0) {
+        if (memory_check_address_permissions(vm, addr, len, VM_PROT_WRITE) != VM_ERROR_NONE) {
+            return vm->last_error;
+        }
+        random_fill(vm->random_state, &vm->memory[addr], len);
+    }
+    vm->registers[R0_ACC] = len;
+    return VM_ERROR_NONE;
+}
+
+// Group 50-59: Bulk console I/O, one range check and one host call each
+
+static int sys_write_buffer(VM *vm, const uint32_t *args) {
+    uint16_t addr = args[0];
+    uint16_t len = args[1];
+    
+    if (len > 0) {
+        if (memory_check_address_permissions(vm, addr, len, VM_PROT_READ) != VM_ERROR_NONE) {
+            return vm->last_error;
+        }
+        console_write(vm, (const char *)&vm->memory[addr], len);
+    }
+    vm->registers[R0_ACC] = len;
+    return VM_ERROR_NONE;
+}
+
+// Print string, checked as one range
+static int sys_write_string(VM *vm, const uint32_t *args) {
+    uint16_t addr = args[0];
+    
+    // Find the terminator without leaving the segment or heap block the
+    // string starts in, then check exactly the bytes printed
+    uint32_t span = memory_accessible_span(vm, addr);
+    if (span == 0) {
+        memory_check_address_permissions(vm, addr, 1, VM_PROT_READ);
+        return vm->last_error;
+    }
+    const uint8_t *start = &vm->memory[addr];
+    const uint8_t *end = memchr(start, 0, span);
+    if (!end || end - start > 0xFFFF) {
+        vm->last_error = VM_ERROR_SEGMENTATION_FAULT;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Unterminated string at address 0x%04X", addr);
+        return vm->last_error;
+    }
+    
+    uint16_t len = (uint16_t)(end - start);
+    if (len > 0) {
+        if (memory_check_address_permissions(vm, addr, len, VM_PROT_READ) != VM_ERROR_NONE) {
+            return vm->last_error;
+        }
+        console_write(vm, (const char *)start, len);
+    }
+    vm->registers[R0_ACC] = len;
+    return VM_ERROR_NONE;
+}
+
+static int sys_read_line(VM *vm, const uint32_t *args) {
+    uint16_t addr = args[0];
+    uint16_t size = args[1];
+    
+    if (size == 0) {
+        vm->registers[R0_ACC] = 0;
+        vm->registers[R5] = 1;
+        return VM_ERROR_NONE;
+    }
+    if (memory_check_address_permissions(vm, addr, size, VM_PROT_WRITE) != VM_ERROR_NONE) {
+        return vm->last_error;
+    }
+    
+    // Read straight into guest memory
+    int len = console_read_line(vm, (char *)&vm->memory[addr], size);
+    if (len < 0) {
+        vm->registers[R0_ACC] = 0;
+        vm->registers[R5] = 1;  // End of input
+    } else {
+        vm->registers[R0_ACC] = (uint32_t)len;
+    }
+    return VM_ERROR_NONE;
+}
+
+// Group 60-69: Channels to other VMs (see channel.h)
+
+// Write a whole buffer to the output channel, waiting while it is full
+static int sys_channel_write(VM *vm, const uint32_t *args) {
+    uint16_t addr = args[0];
+    uint16_t len = args[1];
+    
+    if (len > 0 && memory_check_address_permissions(vm, addr, len, VM_PROT_READ) != VM_ERROR_NONE) {
+        return vm->last_error;
+    }
+    
+    uint32_t written = channel_write(vm, &vm->memory[addr], len);
+    vm->registers[R0_ACC] = written;
+    if (written < len || (channel_status(vm) & (CHANNEL_STATUS_OUTPUT | CHANNEL_STATUS_BROKEN))
+                         != CHANNEL_STATUS_OUTPUT) {
+        vm->registers[R5] = 1;  // No output, or the reader has gone
+    }
+    return VM_ERROR_NONE;
+}
+
+// Read what is available from the input channel, waiting for at least one byte
+static int sys_channel_read(VM *vm, const uint32_t *args) {
+    uint16_t addr = args[0];
+    uint16_t size = args[1];
+    
+    if (size == 0) {
+        vm->registers[R0_ACC] = 0;
+        vm->registers[R5] = 1;
+        return VM_ERROR_NONE;
+    }
+    if (memory_check_address_permissions(vm, addr, size, VM_PROT_WRITE) != VM_ERROR_NONE) {
+        return vm->last_error;
+    }
+    
+    uint32_t len = channel_read(vm, &vm->memory[addr], size);
+    vm->registers[R0_ACC] = len;
+    if (len == 0) {
+        vm->registers[R5] = 1;  // End of stream, or no input
+    }
+    return VM_ERROR_NONE;
+}
+
+static int sys_channel_close(VM *vm, const uint32_t *args) {
+    channel_close(vm);
+    vm->registers[R0_ACC] = 0;
+    return VM_ERROR_NONE;
+}
+
+// Built-in syscalls installed in every VM
+static const struct {
+    uint16_t number;
+    const char *name;
+    uint8_t arg_count;
+    uint8_t may_block;
+    SyscallHandler handler;
+} builtin_syscalls[] = {
+    { 0,  "print_char",    1, 0, sys_print_char },
+    { 1,  "print_int",     1, 0, sys_print_int },
+    { 2,  "print_string",  1, 0, sys_print_string },
+    { 3,  "read_char",     0, 1, sys_read_char },
+    { 4,  "read_string",   2, 1, sys_read_string },
+    { 5,  "print_hex",     1, 0, sys_print_hex },
+    { 6,  "print_base",    2, 0, sys_print_base },
+    { 7,  "print_fixed",   1, 0, sys_print_fixed },
+    { 8,  "clear_screen",  0, 0, sys_clear_screen },
+    { 9,  "set_color",     1, 0, sys_set_color },
+    { 10, "file_open",     2, 0, sys_file_open },
+    { 11, "file_close",    1, 0, sys_file_close },
+    { 12, "file_read",     3, 0, sys_file_read },
+    { 13, "file_write",    3, 0, sys_file_write },
+    { 14, "file_seek",     3, 0, sys_file_seek },
+    { 15, "file_stat",     2, 0, sys_file_stat },
+    { 20, "mem_alloc",     1, 0, sys_mem_alloc },
+    { 21, "mem_free",      1, 0, sys_mem_free },
+    { 22, "mem_copy",      3, 0, sys_mem_copy },
+    { 23, "mem_info",      0, 0, sys_mem_info },
+    { 30, "exit",          1, 0, sys_exit },
+    { 31, "sleep",         1, 1, sys_sleep },
+    { 32, "get_time",      0, 0, sys_get_time },
+    { 33, "perf_counter",  0, 0, sys_perf_counter },
+    { 40, "random",        1, 0, sys_random },
+    { 41, "seed_random",   1, 0, sys_seed_random },
+    { 42, "random_fill",   2, 0, sys_random_fill },
+    { 50, "write_buffer",  2, 0, sys_write_buffer },
+    { 51, "write_string",  1, 0, sys_write_string },
+    { 52, "read_line",     2, 1, sys_read_line },
+    { 60, "channel_write", 2, 1, sys_channel_write },
+    { 61, "channel_read",  2, 1, sys_channel_read },
+    { 62, "channel_close", 0, 0, sys_channel_close },
+};
+
+int syscalls_init(VM *vm) {
+    vm->syscalls = calloc(SYSCALL_TABLE_SIZE, sizeof(SyscallEntry));
+    if (!vm->syscalls) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate syscall table");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    for (size_t i = 0; i < sizeof(builtin_syscalls) / sizeof(builtin_syscalls[0]); i++) {
+        syscalls_register(vm, builtin_syscalls[i].number, builtin_syscalls[i].name,
+                          builtin_syscalls[i].arg_count, builtin_syscalls[i].may_block,
+                          builtin_syscalls[i].handler);
+    }
+    return VM_ERROR_NONE;
+}
+
+void syscalls_cleanup(VM *vm) {
+    if (!vm) {
+        return;
+    }
+
+    free(vm->syscalls);
+    vm->syscalls = NULL;
+}
+
+// Install or replace a syscall; a NULL handler removes it. Statistics restart.
+int syscalls_register(VM *vm, uint16_t number, const char *name, uint8_t arg_count,
+                      uint8_t may_block, SyscallHandler handler) {
+    if (!vm || !vm->syscalls || number >= SYSCALL_TABLE_SIZE || arg_count > 4) {
+        return VM_ERROR_INVALID_SYSCALL;
+    }
+
+    SyscallEntry *entry = &((SyscallEntry *)vm->syscalls)[number];
+    memset(entry, 0, sizeof(SyscallEntry));
+    if (!handler) {
+        return VM_ERROR_NONE;
+    }
+
+    entry->handler = handler;
+    snprintf(entry->name, sizeof(entry->name), "%s", name ? name : "");
+    entry->arg_count = arg_count;
+    entry->may_block = may_block;
+    return VM_ERROR_NONE;
+}
+
+const SyscallEntry *syscalls_lookup(VM *vm, uint16_t number) {
+    if (!vm || !vm->syscalls || number >= SYSCALL_TABLE_SIZE) {
+        return NULL;
+    }
+
+    SyscallEntry *entry = &((SyscallEntry *)vm->syscalls)[number];
+    return entry->handler ? entry : NULL;
+}
+
+int syscalls_dispatch(VM *vm, uint16_t number) {
+    SyscallEntry *entry = (number < SYSCALL_TABLE_SIZE && vm->syscalls)
+                        ? &((SyscallEntry *)vm->syscalls)[number] : NULL;
+
+    if (!entry || !entry->handler) {
+        vm->registers[R5] = 1;  // Error - unimplemented
+
+        // Unused numbers inside the built-in groups only report the error
+        if (number < SYSCALL_BUILTIN_LIMIT) {
+            return VM_ERROR_NONE;
+        }
+
+        vm->last_error = VM_ERROR_INVALID_SYSCALL;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Invalid system call: %d", number);
+        return VM_ERROR_INVALID_SYSCALL;
+    }
+
+    uint32_t args[4] = {
+        vm->registers[R0_ACC],
+        vm->registers[R5],
+        vm->registers[R6],
+        vm->registers[R7]
+    };
+    vm->registers[R5] = 0;  // Clear error code
+
+    // Make any prompt visible before blocking
+    if (entry->may_block) {
+        console_flush(vm);
+    }
+
+    if (!entry->may_block && entry->calls++ % SYSCALL_TIMING_INTERVAL != 0) {
+        return entry->handler(vm, args);
+    }
+    if (entry->may_block) {
+        entry->calls++;
+    }
+
+    uint64_t start = syscalls_now_ns();
+    int result = entry->handler(vm, args);
+    entry->timed_ns += syscalls_now_ns() - start;
+    entry->timed_calls++;
+
+    return result;
+}
+
+uint64_t syscalls_total_ns(const SyscallEntry *entry) {
+    if (!entry || entry->timed_calls == 0) {
+        return 0;
+    }
+    return (uint64_t)((double)entry->timed_ns * entry->calls / entry->timed_calls);
+}
+
+void syscalls_print_stats(VM *vm, FILE *out) {
+    if (!vm || !vm->syscalls) {
+        return;
+    }
+
+    fprintf(out, "%-4s %-16s %12s %14s %12s\n", "Num", "Name", "Calls", "Total (us)", "Avg (ns)");
+    for (int i = 0; i < SYSCALL_TABLE_SIZE; i++) {
+        SyscallEntry *entry = &((SyscallEntry *)vm->syscalls)[i];
+        if (!entry->handler || entry->calls == 0) {
+            continue;
+        }
+
+        fprintf(out, "%-4d %-16s %12llu %14.1f %12llu\n", i, entry->name,
+                (unsigned long long)entry->calls, syscalls_total_ns(entry) / 1000.0,
+                (unsigned long long)(entry->timed_ns / entry->timed_calls));
+    }
+}
@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "vm_types.h"
+#include "io_manager.h"
+#include "channel.h"
+#include "ring.h"
+#include "replay.h"
+
+// Stream shared by the writing and the reading VM. The ring is lock-free;
+// the lock and condition variable are only used by a side that has to sleep.
+typedef struct {
+    Ring ring;
+    _Atomic int writer_closed;
+    _Atomic int reader_closed;
+    _Atomic int refs;             // Connected ends; the last one to drop frees the channel
+    _Atomic int sleepers;         // Sides waiting on the condition variable
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} Channel;
+
+// Channel device state (one per VM)
+typedef struct {
+    Channel *input;
+    Channel *output;
+} ChannelState;
+
+static Channel *channel_create(uint32_t capacity) {
+    Channel *channel = (Channel *)calloc(1, sizeof(Channel));
+    if (!channel) {
+        return NULL;
+    }
+
+    if (ring_init(&channel->ring, capacity) != VM_ERROR_NONE) {
+        free(channel);
+        return NULL;
+    }
+
+    atomic_init(&channel->writer_closed, 0);
+    atomic_init(&channel->reader_closed, 0);
+    atomic_init(&channel->refs, 2);
+    atomic_init(&channel->sleepers, 0);
+    pthread_mutex_init(&channel->lock, NULL);
+    pthread_cond_init(&channel->wake, NULL);
+    return channel;
+}
+
+static void channel_release(Channel *channel) {
+    if (atomic_fetch_sub(&channel->refs, 1) != 1) {
+        return;
+    }
+
+    pthread_cond_destroy(&channel->wake);
+    pthread_mutex_destroy(&channel->lock);
+    ring_free(&channel->ring);
+    free(channel);
+}
+
+// Conditions a blocked side waits for: progress is possible or the peer has gone
+static int channel_writable(Channel *channel) {
+    return ring_used(&channel->ring) < channel->ring.capacity ||
+           atomic_load(&channel->reader_closed);
+}
+
+static int channel_readable(Channel *channel) {
+    return ring_used(&channel->ring) > 0 || atomic_load(&channel->writer_closed);
+}
+
+// Wait until ready() holds. The peer usually runs on another core and will
+// move the ring shortly, so yield for a while before going to sleep.
+static void channel_wait(Channel *channel, int (*ready)(Channel *)) {
+    for (int i = 0; i < CHANNEL_SPIN_YIELDS; i++) {
+        if (ready(channel)) {
+            return;
+        }
+        sched_yield();
+    }
+
+    pthread_mutex_lock(&channel->lock);
+    // Announce the sleeper before checking, so the peer can't miss us
+    atomic_fetch_add(&channel->sleepers, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    while (!ready(channel)) {
+        pthread_cond_wait(&channel->wake, &channel->lock);
+    }
+    atomic_fetch_sub(&channel->sleepers, 1);
+    pthread_mutex_unlock(&channel->lock);
+}
+
+// Wake a sleeping peer after moving data or closing; pairs with channel_wait
+static void channel_notify(Channel *channel) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&channel->sleepers) > 0) {
+        pthread_mutex_lock(&channel->lock);
+        pthread_cond_broadcast(&channel->wake);
+        pthread_mutex_unlock(&channel->lock);
+    }
+}
+
+int channel_connect(VM *writer, VM *reader, uint32_t capacity) {
+    ChannelState *out = (ChannelState *)writer->channel;
+    ChannelState *in = reader ? (ChannelState *)reader->channel : NULL;
+
+    if (!out || !in || out->output || in->input) {
+        writer->last_error = VM_ERROR_IO_ERROR;
+        snprintf(writer->error_message, sizeof(writer->error_message),
+                 "Channel device missing or already connected");
+        return VM_ERROR_IO_ERROR;
+    }
+
+    Channel *channel = channel_create(capacity ? capacity : CHANNEL_DEFAULT_SIZE);
+    if (!channel) {
+        writer->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(writer->error_message, sizeof(writer->error_message),
+                 "Failed to allocate channel of %u bytes", capacity);
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    out->output = channel;
+    in->input = channel;
+    return VM_ERROR_NONE;
+}
+
+static uint32_t channel_write_host(VM *vm, const uint8_t *data, uint32_t len) {
+    ChannelState *state = (ChannelState *)vm->channel;
+    Channel *channel = state ? state->output : NULL;
+    if (!channel) {
+        return 0;
+    }
+
+    // Copy in as much as fits (at most two memcpys), then wait for room
+    uint32_t written = 0;
+    while (written < len && !atomic_load(&channel->reader_closed)) {
+        uint32_t stored = ring_write(&channel->ring, data + written, len - written);
+        if (stored == 0) {
+            channel_wait(channel, channel_writable);
+            continue;
+        }
+        written += stored;
+        channel_notify(channel);
+    }
+    return written;
+}
+
+// The peer's progress decides how much moves, so both directions go through the replay log
+uint32_t channel_write(VM *vm, const uint8_t *data, uint32_t len) {
+    if (!vm) {
+        return 0;
+    }
+    return (uint32_t)REPLAY_VALUE(vm, REPLAY_CHANNEL, channel_write_host(vm, data, len));
+}
+
+static uint32_t channel_read_host(VM *vm, uint8_t *data, uint32_t size) {
+    ChannelState *state = (ChannelState *)vm->channel;
+    Channel *channel = state ? state->input : NULL;
+    if (!channel) {
+        return 0;
+    }
+
+    channel_wait(channel, channel_readable);
+
+    // Take whatever is there, one memcpy per contiguous ring segment
+    const uint8_t *span;
+    uint32_t len;
+    uint32_t total = 0;
+    while (total < size && (len = ring_peek(&channel->ring, &span)) > 0) {
+        if (len > size - total) {
+            len = size - total;
+        }
+        memcpy(data + total, span, len);
+        ring_consume(&channel->ring, len);
+        total += len;
+    }
+
+    if (total > 0) {
+        channel_notify(channel);
+    }
+    return total;
+}
+
+uint32_t channel_read(VM *vm, uint8_t *data, uint32_t size) {
+    if (!vm || size == 0) {
+        return 0;
+    }
+
+    uint32_t len = (uint32_t)REPLAY_VALUE(vm, REPLAY_CHANNEL, channel_read_host(vm, data, size));
+    if (vm->replay_mode) {
+        if (len > size) {
+            len = size;  // Only from a damaged log; replay_data reports it
+        }
+        replay_data(vm, REPLAY_CHANNEL_DATA, data, len);
+    }
+    return len;
+}
+
+void channel_close(VM *vm) {
+    ChannelState *state = vm ? (ChannelState *)vm->channel : NULL;
+    if (!state || !state->output) {
+        return;
+    }
+
+    Channel *channel = state->output;
+    state->output = NULL;
+    atomic_store(&channel->writer_closed, 1);
+    channel_notify(channel);
+    channel_release(channel);
+}
+
+// Stop reading; a writer blocked on a full ring gives up
+static void channel_close_input(ChannelState *state) {
+    if (!state->input) {
+        return;
+    }
+
+    Channel *channel = state->input;
+    state->input = NULL;
+    atomic_store(&channel->reader_closed, 1);
+    channel_notify(channel);
+    channel_release(channel);
+}
+
+static uint32_t channel_status_host(VM *vm) {
+    ChannelState *state = (ChannelState *)vm->channel;
+    uint32_t status = 0;
+    if (!state) {
+        return 0;
+    }
+
+    if (state->input) {
+        status |= CHANNEL_STATUS_INPUT;
+        // Check the close flag first, so bytes written just before it aren't missed
+        if (atomic_load(&state->input->writer_closed) && ring_used(&state->input->ring) == 0) {
+            status |= CHANNEL_STATUS_EOF;
+        }
+    }
+    if (state->output) {
+        status |= CHANNEL_STATUS_OUTPUT;
+        if (atomic_load(&state->output->reader_closed)) {
+            status |= CHANNEL_STATUS_BROKEN;
+        }
+    }
+    return status;
+}
+
+uint32_t channel_status(VM *vm) {
+    if (!vm) {
+        return 0;
+    }
+    return (uint32_t)REPLAY_VALUE(vm, REPLAY_CHANNEL, channel_status_host(vm));
+}
+
+// Channel device operations
+static int channel_init(VM *vm, void *device_data) {
+    if (!device_data) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    vm->channel = device_data;
+    return VM_ERROR_NONE;
+}
+
+static void channel_cleanup(VM *vm, void *device_data) {
+    ChannelState *state = (ChannelState *)device_data;
+
+    // Neighbours see end of stream or a broken pipe once this VM is gone
+    if (vm->channel == device_data) {
+        channel_close(vm);
+        vm->channel = NULL;
+    }
+    channel_close_input(state);
+    free(state);
+}
+
+static uint32_t channel_port_value(VM *vm, ChannelState *state, uint16_t port) {
+    switch (port) {
+        case CHANNEL_PORT_AVAIL:
+            return state->input ? ring_used(&state->input->ring) : 0;
+
+        case CHANNEL_PORT_SPACE:
+            if (!state->output || atomic_load(&state->output->reader_closed)) {
+                return 0;
+            }
+            return state->output->ring.capacity - ring_used(&state->output->ring);
+
+        case CHANNEL_PORT_STATUS:
+            return channel_status_host(vm);
+
+        default:
+            return 0;
+    }
+}
+
+static uint32_t channel_port_read(VM *vm, void *device_data, uint16_t port) {
+    ChannelState *state = (ChannelState *)device_data;
+    return (uint32_t)REPLAY_VALUE(vm, REPLAY_CHANNEL, channel_port_value(vm, state, port));
+}
+
+static void channel_port_write(VM *vm, void *device_data, uint16_t port, uint32_t value) {
+    switch (port) {
+        case CHANNEL_PORT_CONTROL:
+            if (value == CHANNEL_CMD_CLOSE) {
+                channel_close(vm);
+            }
+            break;
+
+        default:
+            // Ignore other ports
+            break;
+    }
+}
+
+// Attach the channel device at the given base port
+int io_attach_channel(VM *vm, uint16_t base_port) {
+    ChannelState *state = (ChannelState *)calloc(1, sizeof(ChannelState));
+    if (!state) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate channel device");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    IODevice channel_device = {
+        .type = IO_DEVICE_CHANNEL,
+        .base_port = base_port,
+        .port_range = CHANNEL_PORT_COUNT,
+        .device_data = state,
+        .init = channel_init,
+        .cleanup = channel_cleanup,
+        .read = channel_port_read,
+        .write = channel_port_write
+    };
+
+    int result = io_add_device(vm, &channel_device);
+    if (result != VM_ERROR_NONE) {
+        free(state);
+    }
+    return result;
+}
@@ -0,0 +1,952 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include "vm_types.h"
+#include "io_manager.h"
+#include "console.h"
+#include "events.h"
+#include "pic.h"
+#include "mmio.h"
+#include "ring.h"
+#include "replay.h"
+
+// Input interrupt checks, as logged for replay
+#define CONSOLE_EVENT_ARRIVED 0x01  // The poller stored new input
+#define CONSOLE_EVENT_ENDED   0x02  // Input ended and was reported; stop checking
+
+// Console device state
+typedef struct {
+    Ring ring;                  // Guest output waiting for the writer
+    int fd;                     // Host output descriptor
+    int sink;                   // CONSOLE_SINK_*
+    char *capture;              // Buffer sink contents, NUL-terminated
+    size_t capture_len;
+    size_t capture_size;        // Bytes allocated for capture
+    ConsoleSinkFn callback;     // Callback sink
+    void *callback_data;
+    int async;                  // Writer thread is running
+    int failed;                 // Async output could not be started
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        // Signalled when output or a flush is pending
+    pthread_cond_t drained;     // Signalled when a flush has completed
+    _Atomic int idle;           // Writer is waiting for output
+    int flush_requested;
+    int stopping;
+
+    // Input, read from input_fd by the poller thread
+    Ring input;                 // Bytes read but not yet taken by the guest
+    int input_fd;               // Host input descriptor (CONSOLE_NO_INPUT = none)
+    int input_started;          // Poller thread is running or has finished
+    int input_failed;           // Poller could not be started, read synchronously
+    int input_stopping;
+    int stop_pipe[2];           // Written to wake the poller for shutdown
+    pthread_t poller;
+    pthread_mutex_t input_lock;
+    pthread_cond_t input_ready; // Signalled when input arrives or ends
+    pthread_cond_t input_room;  // Signalled when the guest frees room in a full buffer
+    _Atomic int input_eof;      // Poller reached end of input
+    _Atomic int input_arrived;  // New input since the last interrupt check
+    _Atomic int poller_full;    // Poller is waiting for room
+    uint8_t input_vector;       // Raised when input arrives (0 = none)
+} ConsoleState;
+
+static void console_input_poll(VM *vm, void *data);
+
+// Write a whole span to the host descriptor
+static void console_write_fd(int fd, const uint8_t *data, uint32_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;  // Output is gone (e.g. closed pipe), drop it
+        }
+        data += written;
+        len -= (uint32_t)written;
+    }
+}
+
+// Drain everything currently in the ring with as few writes as possible
+static void console_drain(ConsoleState *console) {
+    const uint8_t *data;
+    uint32_t len;
+
+    while ((len = ring_peek(&console->ring, &data)) > 0) {
+        console_write_fd(console->fd, data, len);
+        ring_consume(&console->ring, len);
+    }
+}
+
+// Deadline CONSOLE_LINGER_US from now for pthread_cond_timedwait
+static struct timespec console_linger_deadline(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += CONSOLE_LINGER_US * 1000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+// Host writer thread
+static void *console_writer(void *arg) {
+    ConsoleState *console = (ConsoleState *)arg;
+
+    pthread_mutex_lock(&console->lock);
+    for (;;) {
+        // Announce idleness before checking, so the producer can't miss us
+        atomic_store(&console->idle, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (ring_used(&console->ring) == 0 && !console->flush_requested) {
+            if (console->stopping) {
+                break;
+            }
+            pthread_cond_wait(&console->wake, &console->lock);
+            atomic_store(&console->idle, 0);
+            continue;
+        }
+        atomic_store(&console->idle, 0);
+
+        // Give a small burst of output the chance to grow into one write
+        if (ring_used(&console->ring) < CONSOLE_WAKE_THRESHOLD &&
+            !console->flush_requested && !console->stopping) {
+            struct timespec deadline = console_linger_deadline();
+            pthread_cond_timedwait(&console->wake, &console->lock, &deadline);
+        }
+
+        pthread_mutex_unlock(&console->lock);
+        console_drain(console);
+        pthread_mutex_lock(&console->lock);
+
+        // The producer is blocked while flushing, so the ring stays empty
+        if (console->flush_requested && ring_used(&console->ring) == 0) {
+            console->flush_requested = 0;
+            pthread_cond_broadcast(&console->drained);
+        }
+    }
+    pthread_mutex_unlock(&console->lock);
+
+    return NULL;
+}
+
+// Start asynchronous output on first use
+static int console_start(ConsoleState *console) {
+    if (ring_init(&console->ring, CONSOLE_RING_SIZE) != VM_ERROR_NONE) {
+        return 0;
+    }
+
+    pthread_mutex_init(&console->lock, NULL);
+    pthread_cond_init(&console->wake, NULL);
+    pthread_cond_init(&console->drained, NULL);
+    atomic_init(&console->idle, 0);
+
+    // Host messages printed so far must come out before guest output
+    fflush(stdout);
+
+    if (pthread_create(&console->writer, NULL, console_writer, console) != 0) {
+        pthread_cond_destroy(&console->drained);
+        pthread_cond_destroy(&console->wake);
+        pthread_mutex_destroy(&console->lock);
+        ring_free(&console->ring);
+        return 0;
+    }
+
+    console->async = 1;
+    return 1;
+}
+
+// Stop the writer thread after it has drained the ring
+static void console_stop(ConsoleState *console) {
+    if (!console->async) {
+        return;
+    }
+
+    pthread_mutex_lock(&console->lock);
+    console->stopping = 1;
+    pthread_cond_signal(&console->wake);
+    pthread_mutex_unlock(&console->lock);
+    pthread_join(console->writer, NULL);
+
+    pthread_cond_destroy(&console->drained);
+    pthread_cond_destroy(&console->wake);
+    pthread_mutex_destroy(&console->lock);
+    ring_free(&console->ring);
+    console->async = 0;
+}
+
+void console_flush(VM *vm) {
+    if (!vm || !vm->console) {
+        fflush(stdout);
+        return;
+    }
+
+    ConsoleState *console = (ConsoleState *)vm->console;
+    if (!console->async) {
+        fflush(stdout);
+        return;
+    }
+
+    pthread_mutex_lock(&console->lock);
+    if (ring_used(&console->ring) > 0) {
+        console->flush_requested = 1;
+        pthread_cond_signal(&console->wake);
+        while (console->flush_requested) {
+            pthread_cond_wait(&console->drained, &console->lock);
+        }
+    }
+    pthread_mutex_unlock(&console->lock);
+}
+
+// Append to the buffer sink, growing it geometrically
+static void console_capture(ConsoleState *console, const char *data, size_t len) {
+    size_t needed = console->capture_len + len + 1;
+
+    if (needed > console->capture_size) {
+        size_t size = console->capture_size ? console->capture_size : CONSOLE_CAPTURE_INITIAL;
+        while (size < needed) {
+            size *= 2;
+        }
+
+        char *grown = (char *)realloc(console->capture, size);
+        if (!grown) {
+            return;  // Out of host memory, drop the output
+        }
+        console->capture = grown;
+        console->capture_size = size;
+    }
+
+    memcpy(console->capture + console->capture_len, data, len);
+    console->capture_len += len;
+    console->capture[console->capture_len] = '\0';
+}
+
+void console_write(VM *vm, const char *data, size_t len) {
+    ConsoleState *console = vm ? (ConsoleState *)vm->console : NULL;
+
+    // In-process sinks take the output directly
+    if (console && console->sink == CONSOLE_SINK_BUFFER) {
+        console_capture(console, data, len);
+        return;
+    }
+    if (console && console->sink == CONSOLE_SINK_CALLBACK) {
+        console->callback(vm, data, len, console->callback_data);
+        return;
+    }
+
+    // Start the writer thread on first output
+    if (console && !console->async && !console->failed && !vm->debug_mode) {
+        if (!console_start(console)) {
+            console->failed = 1;
+        }
+    }
+
+    // The debugger interleaves its own output, so keep the console synchronous
+    if (!console || !console->async || vm->debug_mode) {
+        console_flush(vm);
+        if (!console || console->fd == STDOUT_FILENO) {
+            fwrite(data, 1, len, stdout);
+            fflush(stdout);
+        } else {
+            console_write_fd(console->fd, (const uint8_t *)data, len);
+        }
+        return;
+    }
+
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (len > 0) {
+        uint32_t chunk = len > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)len;
+        uint32_t stored = ring_write(&console->ring, bytes, chunk);
+        bytes += stored;
+        len -= stored;
+
+        // Ring full: wait for the writer to catch up
+        if (len > 0) {
+            console_flush(vm);
+            continue;
+        }
+
+        // Pairs with the fence in console_writer so a sleeping writer is always woken
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load(&console->idle) ||
+            ring_used(&console->ring) >= CONSOLE_WAKE_THRESHOLD) {
+            pthread_mutex_lock(&console->lock);
+            pthread_cond_signal(&console->wake);
+            pthread_mutex_unlock(&console->lock);
+        }
+    }
+}
+
+void console_putc(VM *vm, char c) {
+    console_write(vm, &c, 1);
+}
+
+void console_printf(VM *vm, const char *format, ...) {
+    char buffer[256];
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    if (len < 0) {
+        return;
+    }
+    if ((size_t)len >= sizeof(buffer)) {
+        len = sizeof(buffer) - 1;
+    }
+    console_write(vm, buffer, (size_t)len);
+}
+
+// Send pending output to the current sink before switching
+static ConsoleState *console_switch_sink(VM *vm) {
+    ConsoleState *console = vm ? (ConsoleState *)vm->console : NULL;
+    if (!console) {
+        if (vm) {
+            vm->last_error = VM_ERROR_IO_ERROR;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "No console device");
+        }
+        return NULL;
+    }
+
+    console_flush(vm);
+    return console;
+}
+
+int console_set_output_fd(VM *vm, int fd) {
+    ConsoleState *console = console_switch_sink(vm);
+    if (!console) {
+        return VM_ERROR_IO_ERROR;
+    }
+    if (fd < 0) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Invalid output descriptor %d", fd);
+        return VM_ERROR_IO_ERROR;
+    }
+
+    // The writer reads the descriptor after taking the lock
+    if (console->async) {
+        pthread_mutex_lock(&console->lock);
+    }
+    console->fd = fd;
+    console->sink = CONSOLE_SINK_FD;
+    if (console->async) {
+        pthread_mutex_unlock(&console->lock);
+    }
+    return VM_ERROR_NONE;
+}
+
+int console_set_output_buffer(VM *vm) {
+    ConsoleState *console = console_switch_sink(vm);
+    if (!console) {
+        return VM_ERROR_IO_ERROR;
+    }
+
+    console->sink = CONSOLE_SINK_BUFFER;
+    return VM_ERROR_NONE;
+}
+
+int console_set_output_callback(VM *vm, ConsoleSinkFn callback, void *user_data) {
+    ConsoleState *console = console_switch_sink(vm);
+    if (!console) {
+        return VM_ERROR_IO_ERROR;
+    }
+    if (!callback) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Missing output callback");
+        return VM_ERROR_IO_ERROR;
+    }
+
+    console->callback = callback;
+    console->callback_data = user_data;
+    console->sink = CONSOLE_SINK_CALLBACK;
+    return VM_ERROR_NONE;
+}
+
+const char *console_output(VM *vm, size_t *len) {
+    ConsoleState *console = vm ? (ConsoleState *)vm->console : NULL;
+    if (!console || console->sink != CONSOLE_SINK_BUFFER) {
+        if (len) {
+            *len = 0;
+        }
+        return NULL;
+    }
+
+    if (len) {
+        *len = console->capture_len;
+    }
+    return console->capture ? console->capture : "";
+}
+
+void console_clear_output(VM *vm) {
+    ConsoleState *console = vm ? (ConsoleState *)vm->console : NULL;
+    if (console && console->capture) {
+        console->capture_len = 0;
+        console->capture[0] = '\0';
+    }
+}
+
+// Tell waiting readers (and the interrupt check) that input arrived or ended
+static void console_input_signal(ConsoleState *console) {
+    atomic_store(&console->input_arrived, 1);
+    pthread_mutex_lock(&console->input_lock);
+    pthread_cond_broadcast(&console->input_ready);
+    pthread_mutex_unlock(&console->input_lock);
+}
+
+// Host input thread: move input into the input ring as it becomes readable
+static void *console_poller(void *arg) {
+    ConsoleState *console = (ConsoleState *)arg;
+    struct pollfd fds[2] = {
+        { .fd = console->input_fd, .events = POLLIN },
+        { .fd = console->stop_pipe[0], .events = POLLIN }
+    };
+    uint8_t chunk[CONSOLE_INPUT_SIZE];
+
+    // Without an input descriptor the input has ended before it began
+    while (console->input_fd != CONSOLE_NO_INPUT) {
+        uint32_t room = console->input.capacity - ring_used(&console->input);
+
+        // Buffer full: leave input in stdin until the guest has read half of it
+        if (room == 0) {
+            int stopping;
+            pthread_mutex_lock(&console->input_lock);
+            atomic_store(&console->poller_full, 1);
+            atomic_thread_fence(memory_order_seq_cst);
+            while (ring_used(&console->input) > console->input.capacity / 2 &&
+                   !console->input_stopping) {
+                pthread_cond_wait(&console->input_room, &console->input_lock);
+            }
+            atomic_store(&console->poller_full, 0);
+            stopping = console->input_stopping;
+            pthread_mutex_unlock(&console->input_lock);
+            if (stopping) {
+                break;
+            }
+            continue;
+        }
+
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents) {
+            break;  // Shutting down
+        }
+        if (fds[0].revents & POLLNVAL) {
+            break;  // No input descriptor
+        }
+        if (!fds[0].revents) {
+            continue;
+        }
+
+        ssize_t len = read(console->input_fd, chunk, room);
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            break;
+        }
+        if (len == 0) {
+            break;  // End of input
+        }
+
+        ring_write(&console->input, chunk, (uint32_t)len);
+        console_input_signal(console);
+    }
+
+    atomic_store(&console->input_eof, 1);
+    console_input_signal(console);
+    return NULL;
+}
+
+// Start the poller on first use of input; returns 0 to read synchronously
+static int console_input_start(ConsoleState *console) {
+    if (console->input_started) {
+        return 1;
+    }
+    if (console->input_failed) {
+        return 0;
+    }
+
+    if (ring_init(&console->input, CONSOLE_INPUT_SIZE) != VM_ERROR_NONE) {
+        console->input_failed = 1;
+        return 0;
+    }
+    if (pipe(console->stop_pipe) != 0) {
+        ring_free(&console->input);
+        console->input_failed = 1;
+        return 0;
+    }
+
+    pthread_mutex_init(&console->input_lock, NULL);
+    pthread_cond_init(&console->input_ready, NULL);
+    pthread_cond_init(&console->input_room, NULL);
+    atomic_init(&console->input_eof, 0);
+    atomic_init(&console->input_arrived, 0);
+    atomic_init(&console->poller_full, 0);
+    console->input_stopping = 0;
+
+    if (pthread_create(&console->poller, NULL, console_poller, console) != 0) {
+        pthread_cond_destroy(&console->input_room);
+        pthread_cond_destroy(&console->input_ready);
+        pthread_mutex_destroy(&console->input_lock);
+        close(console->stop_pipe[0]);
+        close(console->stop_pipe[1]);
+        ring_free(&console->input);
+        console->input_failed = 1;
+        return 0;
+    }
+
+    console->input_started = 1;
+    return 1;
+}
+
+static void console_input_stop(ConsoleState *console) {
+    if (!console->input_started) {
+        return;
+    }
+
+    pthread_mutex_lock(&console->input_lock);
+    console->input_stopping = 1;
+    pthread_cond_signal(&console->input_room);
+    pthread_mutex_unlock(&console->input_lock);
+
+    char wake = 0;
+    while (write(console->stop_pipe[1], &wake, 1) < 0 && errno == EINTR) {
+        // Retry
+    }
+    pthread_join(console->poller, NULL);
+
+    pthread_cond_destroy(&console->input_room);
+    pthread_cond_destroy(&console->input_ready);
+    pthread_mutex_destroy(&console->input_lock);
+    close(console->stop_pipe[0]);
+    close(console->stop_pipe[1]);
+    ring_free(&console->input);
+    console->input_started = 0;
+}
+
+// Take one buffered byte, waiting for input; EOF at end of input. Output is
+// flushed only before waiting, so a prompt is visible while buffered input
+// is read at full speed.
+static int console_input_getc(VM *vm, ConsoleState *console) {
+    const uint8_t *data;
+
+    while (ring_peek(&console->input, &data) == 0) {
+        if (atomic_load(&console->input_eof)) {
+            // The poller stores its last chunk before flagging the end
+            if (ring_peek(&console->input, &data) == 0) {
+                return EOF;
+            }
+            break;
+        }
+
+        console_flush(vm);
+        pthread_mutex_lock(&console->input_lock);
+        while (ring_used(&console->input) == 0 && !atomic_load(&console->input_eof)) {
+            pthread_cond_wait(&console->input_ready, &console->input_lock);
+        }
+        pthread_mutex_unlock(&console->input_lock);
+    }
+
+    int c = data[0];
+    ring_consume(&console->input, 1);
+
+    // The poller only waits while more than half is buffered. Below that, the
+    // fence pairs with the one in console_poller so a waiting poller is woken.
+    if (ring_used(&console->input) > console->input.capacity / 2) {
+        return c;
+    }
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&console->poller_full)) {
+        pthread_mutex_lock(&console->input_lock);
+        pthread_cond_signal(&console->input_room);
+        pthread_mutex_unlock(&console->input_lock);
+    }
+    return c;
+}
+
+// Input goes through the poller unless the debugger is sharing stdin
+static ConsoleState *console_async_input(VM *vm) {
+    ConsoleState *console = vm ? (ConsoleState *)vm->console : NULL;
+    if (!console || vm->debug_mode || !console_input_start(console)) {
+        return NULL;
+    }
+    return console;
+}
+
+// The descriptor synchronous reads use (stdin without a console)
+static int console_sync_fd(VM *vm) {
+    ConsoleState *console = vm ? (ConsoleState *)vm->console : NULL;
+    return console ? console->input_fd : STDIN_FILENO;
+}
+
+// Synchronous read of one byte, through stdio for stdin so the debugger's
+// own reads share its buffer
+static int console_sync_getc(VM *vm) {
+    int fd = console_sync_fd(vm);
+    if (fd == CONSOLE_NO_INPUT) {
+        return EOF;
+    }
+
+    console_flush(vm);
+    if (fd == STDIN_FILENO) {
+        return getchar();
+    }
+
+    uint8_t c;
+    ssize_t len;
+    while ((len = read(fd, &c, 1)) < 0 && errno == EINTR) {
+        // Retry
+    }
+    return len == 1 ? c : EOF;
+}
+
+static int console_getc_host(VM *vm) {
+    ConsoleState *console = console_async_input(vm);
+    if (!console) {
+        return console_sync_getc(vm);
+    }
+    return console_input_getc(vm, console);
+}
+
+int console_getc(VM *vm) {
+    return (int)REPLAY_VALUE(vm, REPLAY_CONSOLE_CHAR, console_getc_host(vm));
+}
+
+// Built on the same buffer as console_getc, so line and byte reads can be mixed
+static int console_read_line_host(VM *vm, char *buffer, size_t size) {
+    ConsoleState *console = console_async_input(vm);
+
+    // Like fgets: stop after a newline or when the buffer is full
+    size_t len = 0;
+    int c = EOF;
+    while (len + 1 < size &&
+           (c = console ? console_input_getc(vm, console) : console_sync_getc(vm)) != EOF &&
+           c != '\n') {
+        buffer[len++] = (char)c;
+    }
+    buffer[len] = '\0';
+
+    if (c == EOF && len == 0) {
+        return -1;
+    }
+    return (int)len;
+}
+
+int console_read_line(VM *vm, char *buffer, size_t size) {
+    if (size == 0) {
+        return -1;
+    }
+
+    int len = (int)REPLAY_VALUE(vm, REPLAY_CONSOLE_LINE, console_read_line_host(vm, buffer, size));
+    if (vm->replay_mode) {
+        if (len < 0 || (size_t)len >= size) {
+            buffer[0] = '\0';
+            return -1;
+        }
+        replay_data(vm, REPLAY_LINE_DATA, buffer, (uint32_t)len);
+        buffer[len] = '\0';
+    }
+    return len;
+}
+
+static uint32_t console_input_available_host(VM *vm) {
+    ConsoleState *console = console_async_input(vm);
+    if (!console) {
+        // Synchronous input: a read always completes
+        return console_sync_fd(vm) == CONSOLE_NO_INPUT ? 0 : 1;
+    }
+    return ring_used(&console->input);
+}
+
+uint32_t console_input_available(VM *vm) {
+    return (uint32_t)REPLAY_VALUE(vm, REPLAY_CONSOLE_STATUS, console_input_available_host(vm));
+}
+
+// Input flags for the guest (CONSOLE_INPUT_*)
+static uint32_t console_input_flags_host(VM *vm) {
+    ConsoleState *console = console_async_input(vm);
+    if (!console) {
+        return console_sync_fd(vm) == CONSOLE_NO_INPUT ? CONSOLE_INPUT_EOF : CONSOLE_INPUT_READY;
+    }
+
+    // Check the end flag first, so a last chunk stored before it isn't missed
+    int eof = atomic_load(&console->input_eof);
+    if (ring_used(&console->input) > 0) {
+        return CONSOLE_INPUT_READY;
+    }
+    return eof ? CONSOLE_INPUT_EOF : 0;
+}
+
+static uint32_t console_input_flags(VM *vm) {
+    return (uint32_t)REPLAY_VALUE(vm, REPLAY_CONSOLE_STATUS, console_input_flags_host(vm));
+}
+
+// What the poller has reported since the last check (CONSOLE_EVENT_*)
+static uint32_t console_input_events(ConsoleState *console) {
+    uint32_t events = 0;
+
+    if (atomic_exchange(&console->input_arrived, 0)) {
+        events |= CONSOLE_EVENT_ARRIVED;
+    }
+
+    // Nothing more can arrive once input has ended and been reported
+    if (atomic_load(&console->input_eof) && !atomic_load(&console->input_arrived)) {
+        events |= CONSOLE_EVENT_ENDED;
+    }
+    return events;
+}
+
+// Raise the input interrupt when the poller has stored new input
+static void console_input_poll(VM *vm, void *data) {
+    ConsoleState *console = (ConsoleState *)data;
+    uint32_t events = (uint32_t)REPLAY_VALUE(vm, REPLAY_CONSOLE_EVENT, console_input_events(console));
+
+    if (events & CONSOLE_EVENT_ARRIVED) {
+        pic_raise(vm, console->input_vector);
+    }
+    if (!(events & CONSOLE_EVENT_ENDED)) {
+        events_schedule(vm, CONSOLE_INPUT_POLL_INTERVAL, console_input_poll, console);
+    }
+}
+
+// Wait for the poller to report input: 1 if it did, 0 on timeout
+static int console_wait_input_host(ConsoleState *console, uint64_t ns) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += ns / 1000000000ULL;
+    deadline.tv_nsec += ns % 1000000000ULL;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&console->input_lock);
+    while (!atomic_load(&console->input_arrived)) {
+        if (pthread_cond_timedwait(&console->input_ready, &console->input_lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&console->input_lock);
+
+    return atomic_exchange(&console->input_arrived, 0) ? 1 : 0;
+}
+
+int console_wait_input(VM *vm, uint64_t ns) {
+    ConsoleState *console = vm ? (ConsoleState *)vm->console : NULL;
+    if (!console || console->input_vector == 0 ||
+        !REPLAY_VALUE(vm, REPLAY_CONSOLE_STATUS, console_async_input(vm) != NULL)) {
+        return -1;
+    }
+
+    int arrived = (int)REPLAY_VALUE(vm, REPLAY_SLEEP, console_wait_input_host(console, ns));
+    if (arrived) {
+        pic_raise(vm, console->input_vector);
+    }
+    return arrived;
+}
+
+static void console_set_input_vector(VM *vm, ConsoleState *console, uint8_t vector) {
+    console->input_vector = vector;
+    events_cancel(vm, console_input_poll, console);
+
+    if (vector != 0 && REPLAY_VALUE(vm, REPLAY_CONSOLE_STATUS, console_async_input(vm) != NULL)) {
+        events_schedule(vm, CONSOLE_INPUT_POLL_INTERVAL, console_input_poll, console);
+    }
+}
+
+int console_set_input_fd(VM *vm, int fd) {
+    ConsoleState *console = vm ? (ConsoleState *)vm->console : NULL;
+    if (!console) {
+        return VM_ERROR_IO_ERROR;
+    }
+    if (fd < 0 && fd != CONSOLE_NO_INPUT) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Invalid input descriptor %d", fd);
+        return VM_ERROR_IO_ERROR;
+    }
+
+    // The poller is restarted on the new descriptor when input is next used
+    console_input_stop(console);
+    console->input_fd = fd;
+    if (console->input_vector != 0) {
+        console_set_input_vector(vm, console, console->input_vector);
+    }
+    return VM_ERROR_NONE;
+}
+
+// Snapshot state: the input vector and when the input poll is next due
+typedef struct {
+    int64_t poll_in;
+    uint8_t input_vector;
+} ConsoleSnapshot;
+
+static size_t console_save(VM *vm, void *device_data, uint8_t *buffer, size_t size) {
+    ConsoleState *console = (ConsoleState *)device_data;
+    ConsoleSnapshot snapshot;
+
+    if (size < sizeof(snapshot)) {
+        return 0;
+    }
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.poll_in = events_remaining(vm, console_input_poll, console);
+    snapshot.input_vector = console->input_vector;
+    memcpy(buffer, &snapshot, sizeof(snapshot));
+    return sizeof(snapshot);
+}
+
+static int console_restore(VM *vm, void *device_data, const uint8_t *buffer, size_t len) {
+    ConsoleState *console = (ConsoleState *)device_data;
+    ConsoleSnapshot snapshot;
+
+    if (len != sizeof(snapshot)) {
+        return VM_ERROR_IO_ERROR;
+    }
+    memcpy(&snapshot, buffer, sizeof(snapshot));
+
+    // Input is read fresh from this host; only the poll schedule carries over
+    console->input_vector = snapshot.input_vector;
+    events_cancel(vm, console_input_poll, console);
+    if (snapshot.poll_in >= 0 &&
+        REPLAY_VALUE(vm, REPLAY_CONSOLE_STATUS, console_async_input(vm) != NULL)) {
+        events_schedule(vm, (uint32_t)snapshot.poll_in, console_input_poll, console);
+    }
+    return VM_ERROR_NONE;
+}
+
+// Console device operations
+static int console_init(VM *vm, void *device_data) {
+    if (!device_data) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    vm->console = device_data;
+    return VM_ERROR_NONE;
+}
+
+static void console_cleanup(VM *vm, void *device_data) {
+    ConsoleState *console = (ConsoleState *)device_data;
+    if (!console) {
+        return;
+    }
+
+    events_cancel(vm, console_input_poll, console);
+    console_input_stop(console);
+    console_stop(console);
+    if (vm->console == console) {
+        vm->console = NULL;
+    }
+    free(console->capture);
+    free(console);
+}
+
+static uint32_t console_read(VM *vm, void *device_data, uint16_t port) {
+    switch (port) {
+        case CONSOLE_PORT_DATA:  // Standard input, 0 at end of file
+            {
+                int c = console_getc(vm);
+                return (c == EOF) ? 0 : (uint32_t)c;
+            }
+            
+        case CONSOLE_PORT_STATUS:  // Input bytes that can be read without waiting
+            return console_input_available(vm);
+            
+        case CONSOLE_PORT_VECTOR:
+            return ((ConsoleState *)device_data)->input_vector;
+            
+        case CONSOLE_PORT_INPUT:
+            return console_input_flags(vm);
+            
+        default:
+            return 0;
+    }
+}
+
+static void console_port_write(VM *vm, void *device_data, uint16_t port, uint32_t value) {
+    switch (port) {
+        case CONSOLE_PORT_DATA:  // Standard output
+            console_putc(vm, (char)(value & 0xFF));
+            break;
+            
+        case CONSOLE_PORT_STATUS:  // Standard error, kept in order with stdout
+            console_flush(vm);
+            fprintf(stderr, "%c", (char)(value & 0xFF));
+            fflush(stderr);
+            break;
+            
+        case CONSOLE_PORT_VECTOR:  // Input interrupt, starts the poller
+            console_set_input_vector(vm, (ConsoleState *)device_data, value & 0xFF);
+            break;
+            
+        default:
+            // Ignore other ports
+            break;
+    }
+}
+
+// Memory-mapped window onto the same ports
+static uint32_t console_mmio_read(VM *vm, void *data, uint16_t offset, uint8_t size) {
+    return (offset & 3) ? 0 : console_read(vm, data, offset / 4);
+}
+
+static void console_mmio_write(VM *vm, void *data, uint16_t offset, uint8_t size, uint32_t value) {
+    if (!(offset & 3)) {
+        console_port_write(vm, data, offset / 4, value);
+    }
+}
+
+int console_map_mmio(VM *vm, uint16_t base) {
+    if (!vm || !vm->console) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+    return mmio_map(vm, base, CONSOLE_MMIO_SIZE, console_mmio_read, console_mmio_write, vm->console);
+}
+
+// Attach the console at the given base port
+int io_attach_console(VM *vm, uint16_t base_port) {
+    ConsoleState *console = (ConsoleState *)calloc(1, sizeof(ConsoleState));
+    if (!console) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate console device");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    console->fd = STDOUT_FILENO;
+    console->input_fd = CONSOLE_NO_INPUT;
+
+    IODevice console_device = {
+        .type = IO_DEVICE_CONSOLE,
+        .base_port = base_port,
+        .port_range = CONSOLE_PORT_COUNT,
+        .device_data = console,
+        .init = console_init,
+        .cleanup = console_cleanup,
+        .read = console_read,
+        .write = console_port_write,
+        .save = console_save,
+        .restore = console_restore
+    };
+
+    int result = io_add_device(vm, &console_device);
+    if (result != VM_ERROR_NONE) {
+        free(console);
+    }
+    return result;
+}
@@ -0,0 +1,329 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vm_types.h"
+#include "memory.h"
+#include "io_manager.h"
+#include "disk.h"
+#include "pic.h"
+
+// Disk device state
+typedef struct {
+    uint8_t *image;           // Mapped image file
+    size_t   image_size;      // Mapped bytes (whole sectors only)
+    uint32_t sector_count;
+    int      fd;
+    int      writable;        // Image was opened read/write
+
+    // Registers
+    uint32_t sector;
+    uint16_t buffer;
+    uint16_t count;
+    uint8_t  status;
+    uint8_t  vector;
+    uint8_t  mode;
+
+    // Range written since the last sync (write-back mode)
+    size_t   dirty_start;
+    size_t   dirty_end;
+
+    // Statistics
+    DiskStats stats;
+    struct timespec attached;
+} DiskState;
+
+// Sync [start, end) of the image to the file; msync needs a page-aligned start
+static int disk_sync(DiskState *disk, size_t start, size_t end) {
+    if (start >= end) {
+        return 0;
+    }
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t aligned = start - (start % page);
+    return msync(disk->image + aligned, end - aligned, MS_SYNC);
+}
+
+// Execute a transfer or flush command
+static void disk_command(VM *vm, DiskState *disk, uint32_t command) {
+    disk->status = DISK_STATUS_ERROR;
+
+    if (command == DISK_CMD_FLUSH) {
+        if (disk_sync(disk, disk->dirty_start, disk->dirty_end) == 0) {
+            disk->dirty_start = disk->dirty_end = 0;
+            disk->status = DISK_STATUS_OK;
+        }
+        disk->stats.flushes++;
+    } else if (command == DISK_CMD_READ || command == DISK_CMD_WRITE) {
+        // Validate the sector range against the image
+        if (disk->count == 0 || disk->count > DISK_MAX_TRANSFER ||
+            disk->sector >= disk->sector_count ||
+            disk->count > disk->sector_count - disk->sector) {
+            goto complete;
+        }
+        if (command == DISK_CMD_WRITE && !disk->writable) {
+            goto complete;
+        }
+
+        size_t offset = (size_t)disk->sector * DISK_SECTOR_SIZE;
+        uint16_t bytes = disk->count * DISK_SECTOR_SIZE;
+        uint8_t perm = (command == DISK_CMD_READ) ? VM_PROT_WRITE : VM_PROT_READ;
+
+        // One range check, then one copy; a bad guest buffer faults like any access
+        if (memory_check_address_permissions(vm, disk->buffer, bytes, perm) != VM_ERROR_NONE) {
+            goto complete;
+        }
+
+        if (command == DISK_CMD_READ) {
+            memcpy(&vm->memory[disk->buffer], disk->image + offset, bytes);
+            disk->stats.sectors_read += disk->count;
+        } else {
+            memcpy(disk->image + offset, &vm->memory[disk->buffer], bytes);
+            disk->stats.sectors_written += disk->count;
+
+            if (disk->mode & DISK_MODE_WRITEBACK) {
+                // Remember what to sync on the next flush
+                if (disk->dirty_start == disk->dirty_end) {
+                    disk->dirty_start = offset;
+                    disk->dirty_end = offset + bytes;
+                } else {
+                    if (offset < disk->dirty_start) {
+                        disk->dirty_start = offset;
+                    }
+                    if (offset + bytes > disk->dirty_end) {
+                        disk->dirty_end = offset + bytes;
+                    }
+                }
+            } else if (disk_sync(disk, offset, offset + bytes) != 0) {
+                goto complete;
+            }
+        }
+        disk->status = DISK_STATUS_OK;
+    }
+
+complete:
+    if (disk->vector != 0) {
+        pic_raise(vm, disk->vector);
+    }
+}
+
+// Disk device operations
+static int disk_init(VM *vm, void *device_data) {
+    if (!device_data) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    vm->disk = device_data;
+    return VM_ERROR_NONE;
+}
+
+static void disk_cleanup(VM *vm, void *device_data) {
+    DiskState *disk = (DiskState *)device_data;
+    if (!disk) {
+        return;
+    }
+
+    // Unflushed write-back data still reaches the file through the shared mapping
+    disk_sync(disk, disk->dirty_start, disk->dirty_end);
+    munmap(disk->image, disk->image_size);
+    close(disk->fd);
+    if (vm->disk == disk) {
+        vm->disk = NULL;
+    }
+    free(disk);
+}
+
+// Snapshot state: the guest-set registers. The image itself is the disk
+// file, and the mode comes from the command line of the restoring run.
+typedef struct {
+    uint32_t sector;
+    uint16_t buffer;
+    uint16_t count;
+    uint8_t  status;
+    uint8_t  vector;
+} DiskSnapshot;
+
+static size_t disk_save(VM *vm, void *device_data, uint8_t *buffer, size_t size) {
+    DiskState *disk = (DiskState *)device_data;
+    DiskSnapshot snapshot;
+
+    if (size < sizeof(snapshot)) {
+        return 0;
+    }
+
+    // The snapshot refers to the file, so it has to be current
+    if (disk_sync(disk, disk->dirty_start, disk->dirty_end) == 0) {
+        disk->dirty_start = disk->dirty_end = 0;
+    }
+
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.sector = disk->sector;
+    snapshot.buffer = disk->buffer;
+    snapshot.count = disk->count;
+    snapshot.status = disk->status;
+    snapshot.vector = disk->vector;
+    memcpy(buffer, &snapshot, sizeof(snapshot));
+    return sizeof(snapshot);
+}
+
+static int disk_restore(VM *vm, void *device_data, const uint8_t *buffer, size_t len) {
+    DiskState *disk = (DiskState *)device_data;
+    DiskSnapshot snapshot;
+
+    if (len != sizeof(snapshot)) {
+        return VM_ERROR_IO_ERROR;
+    }
+    memcpy(&snapshot, buffer, sizeof(snapshot));
+
+    disk->sector = snapshot.sector;
+    disk->buffer = snapshot.buffer;
+    disk->count = snapshot.count;
+    disk->status = snapshot.status;
+    disk->vector = snapshot.vector;
+    return VM_ERROR_NONE;
+}
+
+static uint32_t disk_read(VM *vm, void *device_data, uint16_t port) {
+    DiskState *disk = (DiskState *)device_data;
+
+    switch (port) {
+        case DISK_PORT_SECTOR:    return disk->sector;
+        case DISK_PORT_BUFFER:    return disk->buffer;
+        case DISK_PORT_NSECTORS:  return disk->count;
+        case DISK_PORT_STATUS:    return disk->status;
+        case DISK_PORT_VECTOR:    return disk->vector;
+        case DISK_PORT_MODE:      return disk->mode;
+        case DISK_PORT_CAPACITY:  return disk->sector_count;
+        default:                  return 0;
+    }
+}
+
+static void disk_write(VM *vm, void *device_data, uint16_t port, uint32_t value) {
+    DiskState *disk = (DiskState *)device_data;
+
+    switch (port) {
+        case DISK_PORT_SECTOR:
+            disk->sector = value;
+            break;
+
+        case DISK_PORT_BUFFER:
+            disk->buffer = value & 0xFFFF;
+            break;
+
+        case DISK_PORT_NSECTORS:
+            disk->count = value & 0xFFFF;
+            break;
+
+        case DISK_PORT_COMMAND:
+            disk_command(vm, disk, value);
+            break;
+
+        case DISK_PORT_VECTOR:
+            disk->vector = value & 0xFF;
+            break;
+
+        case DISK_PORT_MODE:
+            disk->mode = value & DISK_MODE_WRITEBACK;
+            break;
+
+        default:
+            // Ignore other ports
+            break;
+    }
+}
+
+int disk_get_stats(VM *vm, DiskStats *stats) {
+    if (!vm || !vm->disk || !stats) {
+        return 0;
+    }
+
+    DiskState *disk = (DiskState *)vm->disk;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    *stats = disk->stats;
+    stats->elapsed_seconds = (double)(now.tv_sec - disk->attached.tv_sec) +
+                             (double)(now.tv_nsec - disk->attached.tv_nsec) / 1e9;
+    return 1;
+}
+
+// Attach a disk backed by a host image file at the given base port
+int io_attach_disk(VM *vm, uint16_t base_port, const char *image_path) {
+    DiskState *disk = (DiskState *)calloc(1, sizeof(DiskState));
+    if (!disk) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate disk device");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    // Fall back to a read-only image if it can't be opened for writing
+    disk->writable = 1;
+    disk->fd = open(image_path, O_RDWR | O_CLOEXEC);
+    if (disk->fd < 0 && (errno == EACCES || errno == EROFS)) {
+        disk->writable = 0;
+        disk->fd = open(image_path, O_RDONLY | O_CLOEXEC);
+    }
+
+    struct stat st;
+    if (disk->fd < 0 || fstat(disk->fd, &st) != 0) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Cannot open disk image '%s': %s", image_path, strerror(errno));
+        if (disk->fd >= 0) {
+            close(disk->fd);
+        }
+        free(disk);
+        return VM_ERROR_IO_ERROR;
+    }
+
+    disk->sector_count = (uint32_t)(st.st_size / DISK_SECTOR_SIZE);
+    disk->image_size = (size_t)disk->sector_count * DISK_SECTOR_SIZE;
+    if (disk->sector_count == 0) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Disk image '%s' is smaller than one sector", image_path);
+        close(disk->fd);
+        free(disk);
+        return VM_ERROR_IO_ERROR;
+    }
+
+    int prot = PROT_READ | (disk->writable ? PROT_WRITE : 0);
+    disk->image = mmap(NULL, disk->image_size, prot, MAP_SHARED, disk->fd, 0);
+    if (disk->image == MAP_FAILED) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Cannot map disk image '%s': %s", image_path, strerror(errno));
+        close(disk->fd);
+        free(disk);
+        return VM_ERROR_IO_ERROR;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &disk->attached);
+
+    IODevice disk_device = {
+        .type = IO_DEVICE_DISK,
+        .base_port = base_port,
+        .port_range = DISK_PORT_COUNT,
+        .device_data = disk,
+        .init = disk_init,
+        .cleanup = disk_cleanup,
+        .read = disk_read,
+        .write = disk_write,
+        .save = disk_save,
+        .restore = disk_restore
+    };
+
+    int result = io_add_device(vm, &disk_device);
+    if (result != VM_ERROR_NONE) {
+        munmap(disk->image, disk->image_size);
+        close(disk->fd);
+        free(disk);
+    }
+    return result;
+}
@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vm_types.h"
+#include "memory.h"
+#include "io_manager.h"
+#include "events.h"
+#include "dma.h"
+#include "pic.h"
+
+// A single DMA channel
+typedef struct {
+    uint32_t source;
+    uint32_t dest;
+    uint32_t length;
+    uint32_t stride;
+    uint32_t position;        // Bytes transferred so far
+    uint8_t  control;
+    uint8_t  vector;
+    uint8_t  status;
+} DmaChannel;
+
+// DMA controller state
+typedef struct {
+    DmaChannel channels[DMA_CHANNELS];
+} DmaState;
+
+static void dma_run_chunk(VM *vm, void *data);
+
+// Effective stride of one side; 0 and 1 both mean contiguous
+static uint32_t dma_stride(uint32_t stride) {
+    return stride ? stride : 1;
+}
+
+// Finish a transfer and signal the guest
+static void dma_complete(VM *vm, DmaChannel *channel, uint8_t status) {
+    channel->status = status;
+    channel->control &= ~DMA_CTRL_START;
+    if (channel->vector != 0) {
+        pic_raise(vm, channel->vector);
+    }
+}
+
+// Check that the span touched by 'count' elements starting at element 'first' is accessible
+static int dma_check_span(VM *vm, uint32_t base, uint32_t stride, uint32_t first,
+                          uint32_t count, uint8_t perm) {
+    uint64_t start = (uint64_t)base + (uint64_t)first * stride;
+    uint64_t span = (uint64_t)(count - 1) * stride + 1;
+
+    // The permission check takes a 16-bit size
+    if (start + span > vm->memory_size || span > 0xFFFF) {
+        return 0;
+    }
+
+    // Transfers run between instructions, so a bad range is reported through
+    // the channel status rather than as a fault of the current instruction
+    int saved_error = vm->last_error;
+    int ok = memory_check_address_permissions(vm, (uint16_t)start, (uint16_t)span, perm) == VM_ERROR_NONE;
+    vm->last_error = saved_error;
+    return ok;
+}
+
+// Move the next chunk of a transfer; reschedules itself until done
+static void dma_run_chunk(VM *vm, void *data) {
+    DmaChannel *channel = (DmaChannel *)data;
+    uint32_t count = channel->length - channel->position;
+    if (count > DMA_CHUNK_SIZE) {
+        count = DMA_CHUNK_SIZE;
+    }
+
+    int src_port = channel->control & DMA_CTRL_SRC_PORT;
+    int dst_port = channel->control & DMA_CTRL_DST_PORT;
+    uint32_t src_stride = dma_stride(channel->stride & 0xFFFF);
+    uint32_t dst_stride = dma_stride(channel->stride >> 16);
+    int contiguous = !src_port && !dst_port && src_stride == 1 && dst_stride == 1;
+
+    // A contiguous copy onto a later, overlapping destination runs its chunks
+    // from the end, so together they act as one memmove of the whole range
+    uint32_t first = channel->position;
+    if (contiguous && channel->dest > channel->source &&
+        channel->dest < channel->source + channel->length) {
+        first = channel->length - channel->position - count;
+    }
+
+    // Validate the memory sides once per chunk
+    if ((!src_port && !dma_check_span(vm, channel->source, src_stride, first, count, VM_PROT_READ)) ||
+        (!dst_port && !dma_check_span(vm, channel->dest, dst_stride, first, count, VM_PROT_WRITE))) {
+        dma_complete(vm, channel, DMA_STATUS_ERROR);
+        return;
+    }
+
+    if (contiguous) {
+        memmove(&vm->memory[channel->dest + first], &vm->memory[channel->source + first], count);
+    } else {
+        // Strided or port transfers go element by element
+        uint32_t src = channel->source + channel->position * src_stride;
+        uint32_t dst = channel->dest + channel->position * dst_stride;
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint8_t value = src_port ? (uint8_t)io_read(vm, (uint16_t)channel->source)
+                                     : vm->memory[src + i * src_stride];
+            if (dst_port) {
+                io_write(vm, (uint16_t)channel->dest, value);
+            } else {
+                vm->memory[dst + i * dst_stride] = value;
+            }
+        }
+    }
+
+    channel->position += count;
+    if (channel->position >= channel->length) {
+        dma_complete(vm, channel, DMA_STATUS_DONE);
+    } else {
+        events_schedule(vm, DMA_CHUNK_INTERVAL, dma_run_chunk, channel);
+    }
+}
+
+// Start or abort a channel
+static void dma_control(VM *vm, DmaChannel *channel, uint32_t value) {
+    // Any control write cancels the transfer in progress
+    events_cancel(vm, dma_run_chunk, channel);
+    channel->control = value & (DMA_CTRL_START | DMA_CTRL_SRC_PORT | DMA_CTRL_DST_PORT);
+
+    if (!(channel->control & DMA_CTRL_START)) {
+        channel->status = DMA_STATUS_IDLE;
+        return;
+    }
+
+    channel->position = 0;
+    if (channel->length == 0) {
+        dma_complete(vm, channel, DMA_STATUS_DONE);
+        return;
+    }
+
+    // The first chunk runs at the next instruction boundary
+    channel->status = DMA_STATUS_BUSY;
+    events_schedule(vm, 0, dma_run_chunk, channel);
+}
+
+// DMA device operations
+static int dma_init(VM *vm, void *device_data) {
+    return device_data ? VM_ERROR_NONE : VM_ERROR_INVALID_ADDRESS;
+}
+
+static void dma_cleanup(VM *vm, void *device_data) {
+    DmaState *dma = (DmaState *)device_data;
+    if (!dma) {
+        return;
+    }
+
+    for (int i = 0; i < DMA_CHANNELS; i++) {
+        events_cancel(vm, dma_run_chunk, &dma->channels[i]);
+    }
+    free(dma);
+}
+
+// Abort every transfer and clear the channel registers
+static void dma_reset(VM *vm, void *device_data) {
+    DmaState *dma = (DmaState *)device_data;
+
+    for (int i = 0; i < DMA_CHANNELS; i++) {
+        events_cancel(vm, dma_run_chunk, &dma->channels[i]);
+    }
+    memset(dma, 0, sizeof(DmaState));
+}
+
+// Snapshot state: the channels plus the delay of each one's next chunk
+typedef struct {
+    DmaState dma;
+    int64_t chunk_in[DMA_CHANNELS];
+} DmaSnapshot;
+
+static size_t dma_save(VM *vm, void *device_data, uint8_t *buffer, size_t size) {
+    DmaState *dma = (DmaState *)device_data;
+    DmaSnapshot snapshot;
+
+    if (size < sizeof(snapshot)) {
+        return 0;
+    }
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.dma = *dma;
+    for (int i = 0; i < DMA_CHANNELS; i++) {
+        snapshot.chunk_in[i] = events_remaining(vm, dma_run_chunk, &dma->channels[i]);
+    }
+    memcpy(buffer, &snapshot, sizeof(snapshot));
+    return sizeof(snapshot);
+}
+
+static int dma_restore(VM *vm, void *device_data, const uint8_t *buffer, size_t len) {
+    DmaState *dma = (DmaState *)device_data;
+    DmaSnapshot snapshot;
+
+    if (len != sizeof(snapshot)) {
+        return VM_ERROR_IO_ERROR;
+    }
+    memcpy(&snapshot, buffer, sizeof(snapshot));
+
+    *dma = snapshot.dma;
+    for (int i = 0; i < DMA_CHANNELS; i++) {
+        events_cancel(vm, dma_run_chunk, &dma->channels[i]);
+        if (snapshot.chunk_in[i] >= 0) {
+            events_schedule(vm, (uint32_t)snapshot.chunk_in[i], dma_run_chunk, &dma->channels[i]);
+        }
+    }
+    return VM_ERROR_NONE;
+}
+
+static uint32_t dma_read(VM *vm, void *device_data, uint16_t port) {
+    DmaState *dma = (DmaState *)device_data;
+    DmaChannel *channel = &dma->channels[port / DMA_CHANNEL_PORTS];
+
+    switch (port % DMA_CHANNEL_PORTS) {
+        case DMA_PORT_SOURCE:     return channel->source;
+        case DMA_PORT_DEST:       return channel->dest;
+        case DMA_PORT_LENGTH:     return channel->length;
+        case DMA_PORT_STRIDE:     return channel->stride;
+        case DMA_PORT_CONTROL:    return channel->control;
+        case DMA_PORT_VECTOR:     return channel->vector;
+        case DMA_PORT_STATUS:     return channel->status;
+        case DMA_PORT_REMAINING:  return channel->length - channel->position;
+        default:                  return 0;
+    }
+}
+
+static void dma_write(VM *vm, void *device_data, uint16_t port, uint32_t value) {
+    DmaState *dma = (DmaState *)device_data;
+    DmaChannel *channel = &dma->channels[port / DMA_CHANNEL_PORTS];
+
+    switch (port % DMA_CHANNEL_PORTS) {
+        case DMA_PORT_SOURCE:
+            channel->source = value;
+            break;
+
+        case DMA_PORT_DEST:
+            channel->dest = value;
+            break;
+
+        case DMA_PORT_LENGTH:
+            channel->length = value;
+            break;
+
+        case DMA_PORT_STRIDE:
+            channel->stride = value;
+            break;
+
+        case DMA_PORT_CONTROL:
+            dma_control(vm, channel, value);
+            break;
+
+        case DMA_PORT_VECTOR:
+            channel->vector = value & 0xFF;
+            break;
+
+        default:
+            // Status and remaining are read-only
+            break;
+    }
+}
+
+// Attach the DMA controller at the given base port
+int io_attach_dma(VM *vm, uint16_t base_port) {
+    DmaState *dma = (DmaState *)calloc(1, sizeof(DmaState));
+    if (!dma) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate DMA controller");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    IODevice dma_device = {
+        .type = IO_DEVICE_DMA,
+        .base_port = base_port,
+        .port_range = DMA_PORT_COUNT,
+        .device_data = dma,
+        .init = dma_init,
+        .cleanup = dma_cleanup,
+        .read = dma_read,
+        .write = dma_write,
+        .save = dma_save,
+        .restore = dma_restore,
+        .reset = dma_reset
+    };
+
+    int result = io_add_device(vm, &dma_device);
+    if (result != VM_ERROR_NONE) {
+        free(dma);
+    }
+    return result;
+}
@@ -0,0 +1,375 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#ifdef SYS_openat2
+#include <linux/openat2.h>
+#endif
+#include "vm_types.h"
+#include "memory.h"
+#include "files.h"
+#include "replay.h"
+
+// Stands in for the host fd of a handle opened during playback
+#define FILES_REPLAY_FD INT_MAX
+
+// Per-VM file descriptor table
+typedef struct {
+    int root_fd;                        // Directory guest paths are resolved in
+    int fds[FILES_MAX_HANDLES];         // Host fd for each handle, -1 if free
+} FileTable;
+
+// Initialize the descriptor table rooted at the current directory
+int files_init(VM *vm) {
+    if (!vm) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    FileTable *table = (FileTable *)calloc(1, sizeof(FileTable));
+    if (!table) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate file table");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    for (int i = 0; i < FILES_MAX_HANDLES; i++) {
+        table->fds[i] = -1;
+    }
+    table->root_fd = -1;
+
+    vm->files = table;
+    return files_set_root(vm, ".");
+}
+
+void files_cleanup(VM *vm) {
+    if (!vm || !vm->files) {
+        return;
+    }
+
+    FileTable *table = (FileTable *)vm->files;
+    files_close_all(vm);
+    if (table->root_fd >= 0) {
+        close(table->root_fd);
+    }
+    free(table);
+    vm->files = NULL;
+}
+
+int files_set_root(VM *vm, const char *root) {
+    if (!vm || !vm->files || !root) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    FileTable *table = (FileTable *)vm->files;
+    int fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Cannot open sandbox directory '%s': %s", root, strerror(errno));
+        return VM_ERROR_IO_ERROR;
+    }
+
+    if (table->root_fd >= 0) {
+        close(table->root_fd);
+    }
+    table->root_fd = fd;
+    return VM_ERROR_NONE;
+}
+
+void files_close_all(VM *vm) {
+    if (!vm || !vm->files) {
+        return;
+    }
+
+    FileTable *table = (FileTable *)vm->files;
+    for (int i = 0; i < FILES_MAX_HANDLES; i++) {
+        if (table->fds[i] >= 0) {
+            if (table->fds[i] != FILES_REPLAY_FD) {
+                close(table->fds[i]);
+            }
+            table->fds[i] = -1;
+        }
+    }
+}
+
+// Map a guest handle to its host fd
+static int files_lookup(FileTable *table, uint32_t handle) {
+    if (handle == 0 || handle > FILES_MAX_HANDLES) {
+        return -1;
+    }
+    return table->fds[handle - 1];
+}
+
+// Copy a NUL-terminated guest path and make it relative to the sandbox root.
+// Returns a pointer into 'path' or NULL if the path is invalid.
+static const char *files_get_path(VM *vm, uint16_t addr, char path[FILES_MAX_PATH]) {
+    uint32_t avail = vm->memory_size > addr ? vm->memory_size - addr : 0;
+    if (avail > FILES_MAX_PATH) {
+        avail = FILES_MAX_PATH;
+    }
+
+    const uint8_t *end = memchr(&vm->memory[addr], 0, avail);
+    if (!end) {
+        return NULL;  // Unterminated or too long
+    }
+
+    uint16_t len = (uint16_t)(end - &vm->memory[addr]);
+    if (memory_check_address_permissions(vm, addr, len + 1, VM_PROT_READ) != VM_ERROR_NONE) {
+        return NULL;
+    }
+    memcpy(path, &vm->memory[addr], len + 1);
+
+    // Absolute paths are taken relative to the root
+    const char *relative = path;
+    while (*relative == '/') {
+        relative++;
+    }
+    if (*relative == '\0') {
+        return ".";
+    }
+
+    // Refuse to climb out of the root; symlinks are handled by files_openat
+    for (const char *p = relative; *p; ) {
+        const char *slash = strchr(p, '/');
+        size_t part = slash ? (size_t)(slash - p) : strlen(p);
+        if (part == 2 && p[0] == '.' && p[1] == '.') {
+            return NULL;
+        }
+        p += part;
+        while (*p == '/') {
+            p++;
+        }
+    }
+
+    return relative;
+}
+
+// Open a path relative to the root without letting it resolve outside the
+// root. openat2 keeps symlinks beneath the root; kernels without it get a
+// walk that opens one directory at a time and refuses symlinks altogether.
+static int files_openat(int root_fd, const char *path, int flags, mode_t mode) {
+#ifdef SYS_openat2
+    struct open_how how;
+    memset(&how, 0, sizeof(how));
+    how.flags = (uint64_t)(flags | O_CLOEXEC);
+    how.mode = (flags & O_CREAT) ? mode : 0;
+    how.resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS;
+
+    int resolved = (int)syscall(SYS_openat2, root_fd, path, &how, sizeof(how));
+    if (resolved >= 0 || errno != ENOSYS) {
+        return resolved;
+    }
+#endif
+
+    int dir_fd = root_fd;
+    const char *p = path;
+    const char *slash;
+    while ((slash = strchr(p, '/')) != NULL) {
+        char name[FILES_MAX_PATH];
+        size_t part = (size_t)(slash - p);
+        memcpy(name, p, part);
+        name[part] = '\0';
+
+        int next = openat(dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (dir_fd != root_fd) {
+            close(dir_fd);
+        }
+        if (next < 0) {
+            return -1;
+        }
+        dir_fd = next;
+
+        p = slash + 1;
+        while (*p == '/') {
+            p++;
+        }
+    }
+
+    int fd = openat(dir_fd, *p ? p : ".", flags | O_NOFOLLOW | O_CLOEXEC, mode);
+    if (dir_fd != root_fd) {
+        int error = errno;
+        close(dir_fd);
+        errno = error;
+    }
+    return fd;
+}
+
+int32_t files_open(VM *vm, uint16_t path_addr, uint8_t mode) {
+    FileTable *table = (FileTable *)vm->files;
+    char buffer[FILES_MAX_PATH];
+
+    const char *path = files_get_path(vm, path_addr, buffer);
+    if (!path) {
+        return -1;
+    }
+
+    int flags;
+    switch (mode) {
+        case FILE_MODE_READ:      flags = O_RDONLY; break;
+        case FILE_MODE_WRITE:     flags = O_WRONLY | O_CREAT | O_TRUNC; break;
+        case FILE_MODE_APPEND:    flags = O_WRONLY | O_CREAT | O_APPEND; break;
+        case FILE_MODE_READWRITE: flags = O_RDWR; break;
+        default:                  return -1;
+    }
+
+    // Find a free handle before touching the host
+    int slot = -1;
+    for (int i = 0; i < FILES_MAX_HANDLES; i++) {
+        if (table->fds[i] < 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        return -1;
+    }
+
+    // Host results go through the replay log; the checks above are the guest's own
+    int fd = REPLAYING(vm) ? FILES_REPLAY_FD : files_openat(table->root_fd, path, flags, 0644);
+    if (!REPLAY_VALUE(vm, REPLAY_FILE, fd >= 0)) {
+        return -1;
+    }
+
+    table->fds[slot] = fd;
+    return slot + 1;
+}
+
+int32_t files_close(VM *vm, uint32_t handle) {
+    FileTable *table = (FileTable *)vm->files;
+    int fd = files_lookup(table, handle);
+    if (fd < 0) {
+        return -1;
+    }
+
+    table->fds[handle - 1] = -1;
+    return (int32_t)REPLAY_VALUE(vm, REPLAY_FILE, close(fd) == 0 ? 0 : -1);
+}
+
+// Host side of a read or write straight from guest memory: count or -1
+static int32_t files_read_host(VM *vm, int fd, uint16_t buffer_addr, uint16_t count) {
+    ssize_t result;
+    do {
+        result = read(fd, &vm->memory[buffer_addr], count);
+    } while (result < 0 && errno == EINTR);
+
+    return result < 0 ? -1 : (int32_t)result;
+}
+
+static int32_t files_write_host(VM *vm, int fd, uint16_t buffer_addr, uint16_t count) {
+    ssize_t result;
+    do {
+        result = write(fd, &vm->memory[buffer_addr], count);
+    } while (result < 0 && errno == EINTR);
+
+    return result < 0 ? -1 : (int32_t)result;
+}
+
+int32_t files_read(VM *vm, uint32_t handle, uint16_t buffer_addr, uint16_t count) {
+    int fd = files_lookup((FileTable *)vm->files, handle);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // Read straight into guest memory once the whole range is known to be writable
+    if (memory_check_address_permissions(vm, buffer_addr, count, VM_PROT_WRITE) != VM_ERROR_NONE) {
+        return -1;
+    }
+
+    int32_t result = (int32_t)REPLAY_VALUE(vm, REPLAY_FILE, files_read_host(vm, fd, buffer_addr, count));
+    if (result > 0 && vm->replay_mode) {
+        replay_data(vm, REPLAY_FILE_DATA, &vm->memory[buffer_addr], (uint32_t)result);
+    }
+    return result;
+}
+
+int32_t files_write(VM *vm, uint32_t handle, uint16_t buffer_addr, uint16_t count) {
+    int fd = files_lookup((FileTable *)vm->files, handle);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (memory_check_address_permissions(vm, buffer_addr, count, VM_PROT_READ) != VM_ERROR_NONE) {
+        return -1;
+    }
+
+    return (int32_t)REPLAY_VALUE(vm, REPLAY_FILE, files_write_host(vm, fd, buffer_addr, count));
+}
+
+int32_t files_seek(VM *vm, uint32_t handle, int32_t offset, uint32_t origin) {
+    int fd = files_lookup((FileTable *)vm->files, handle);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int whence;
+    switch (origin) {
+        case FILE_SEEK_SET: whence = SEEK_SET; break;
+        case FILE_SEEK_CUR: whence = SEEK_CUR; break;
+        case FILE_SEEK_END: whence = SEEK_END; break;
+        default:            return -1;
+    }
+
+    off_t position = (off_t)REPLAY_VALUE(vm, REPLAY_FILE, lseek(fd, offset, whence));
+    if (position < 0 || position > INT32_MAX) {
+        return -1;
+    }
+    return (int32_t)position;
+}
+
+int32_t files_stat(VM *vm, uint16_t path_addr, uint16_t buffer_addr) {
+    FileTable *table = (FileTable *)vm->files;
+    char buffer[FILES_MAX_PATH];
+    struct stat st;
+
+    const char *path = files_get_path(vm, path_addr, buffer);
+    if (!path) {
+        return -1;
+    }
+
+    if (memory_check_address_permissions(vm, buffer_addr, FILE_STAT_BYTES, VM_PROT_WRITE) != VM_ERROR_NONE) {
+        return -1;
+    }
+
+    // Resolve the directory like files_open, then stat the last component
+    // itself so a symlink reports as FILE_TYPE_OTHER instead of its target
+    int found = 0;
+    if (!REPLAYING(vm)) {
+        const char *name = strrchr(path, '/');
+        int dir_fd = table->root_fd;
+        if (name) {
+            buffer[name - buffer] = '\0';
+            name++;
+            dir_fd = files_openat(table->root_fd, path, O_RDONLY | O_DIRECTORY, 0);
+        } else {
+            name = path;
+        }
+
+        if (dir_fd >= 0) {
+            found = fstatat(dir_fd, *name ? name : ".", &st, AT_SYMLINK_NOFOLLOW) == 0;
+            if (dir_fd != table->root_fd) {
+                close(dir_fd);
+            }
+        }
+    }
+    if (!REPLAY_VALUE(vm, REPLAY_FILE, found)) {
+        return -1;
+    }
+
+    uint32_t type = (uint32_t)REPLAY_VALUE(vm, REPLAY_FILE,
+                        S_ISREG(st.st_mode) ? FILE_TYPE_REGULAR :
+                        S_ISDIR(st.st_mode) ? FILE_TYPE_DIRECTORY : FILE_TYPE_OTHER);
+    uint32_t size = (uint32_t)REPLAY_VALUE(vm, REPLAY_FILE,
+                        st.st_size > UINT32_MAX ? UINT32_MAX : (uint32_t)st.st_size);
+    uint32_t mtime = (uint32_t)REPLAY_VALUE(vm, REPLAY_FILE, (uint32_t)st.st_mtime);
+
+    memory_write_dword(vm, buffer_addr + FILE_STAT_SIZE, size);
+    memory_write_dword(vm, buffer_addr + FILE_STAT_MTIME, mtime);
+    memory_write_dword(vm, buffer_addr + FILE_STAT_TYPE, type);
+    return 0;
+}
@@ -2,143 +2,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include "vm_types.h"
+#include "io_manager.h"
 
-// I/O Device Types
-#define IO_DEVICE_CONSOLE     0
-#define IO_DEVICE_DISK        1
-#define IO_DEVICE_TIMER       2
-#define IO_DEVICE_CUSTOM      100
-
-// Maximum number of I/O devices
-#define MAX_IO_DEVICES        16
-
-// I/O device structure
-typedef struct {
-    uint8_t  type;            // Device type
-    uint16_t base_port;       // Base I/O port
-    uint16_t port_range;      // Number of ports used
-    void    *device_data;     // Device-specific data
-    
-    // Device operations
-    int     (*init)(VM *vm, void *device_data);
-    void    (*cleanup)(VM *vm, void *device_data);
-    uint32_t (*read)(VM *vm, void *device_data, uint16_t port);
-    void     (*write)(VM *vm, void *device_data, uint16_t port, uint32_t value);
-} IODevice;
+// Port map: 256 lazily allocated pages of 256 device indices each
+#define IO_PORT_PAGES       256
+#define IO_PORT_PAGE_SIZE   256
+#define IO_PORT_UNMAPPED    0xFFFF
 
 // I/O devices container
 typedef struct {
-    IODevice devices[MAX_IO_DEVICES];
-    int      device_count;
+    IODevice *devices;                      // Grows as devices are added
+    int       device_count;
+    int       device_capacity;
+    uint16_t *port_map[IO_PORT_PAGES];      // Port -> index into devices
 } IODevices;
 
-// Console device operations
-static int console_init(VM *vm, void *device_data) {
-    // Nothing to initialize for console
-    return VM_ERROR_NONE;
-}
-
-static void console_cleanup(VM *vm, void *device_data) {
-    // Nothing to clean up for console
-}
-
-static uint32_t console_read(VM *vm, void *device_data, uint16_t port) {
-    // Simple console input
-    switch (port) {
-        case 0:  // Standard input
-            return getchar();
-            
-        case 1:  // Status (always ready for now)
-            return 1;
-            
-        default:
-            return 0;
-    }
-}
-
-static void console_write(VM *vm, void *device_data, uint16_t port, uint32_t value) {
-    // Simple console output
-    switch (port) {
-        case 0:  // Standard output
-            putchar((int)(value & 0xFF));
-            fflush(stdout);
-            break;
-            
-        case 1:  // Standard error
-            fprintf(stderr, "%c", (char)(value & 0xFF));
-            fflush(stderr);
-            break;
-            
-        default:
-            // Ignore other ports
-            break;
-    }
-}
-
-// Timer device operations
-static int timer_init(VM *vm, void *device_data) {
-    // Initialize timer data
-    if (!device_data) {
-        device_data = calloc(1, sizeof(uint32_t));
-        if (!device_data) {
-            return VM_ERROR_MEMORY_ALLOCATION;
-        }
-    }
-    
-    // Reset timer value
-    *((uint32_t *)device_data) = 0;
-    
-    return VM_ERROR_NONE;
-}
-
-static void timer_cleanup(VM *vm, void *device_data) {
-    // Free timer data
-    if (device_data) {
-        free(device_data);
-    }
-}
-
-static uint32_t timer_read(VM *vm, void *device_data, uint16_t port) {
-    if (!device_data) {
-        return 0;
-    }
-    
-    uint32_t *timer_value = (uint32_t *)device_data;
-    
-    switch (port) {
-        case 0:  // Timer value
-            return *timer_value;
-            
-        default:
-            return 0;
-    }
-}
-
-static void timer_write(VM *vm, void *device_data, uint16_t port, uint32_t value) {
-    if (!device_data) {
-        return;
-    }
-    
-    uint32_t *timer_value = (uint32_t *)device_data;
-    
-    switch (port) {
-        case 0:  // Set timer value
-            *timer_value = value;
-            break;
-            
-        case 1:  // Control (1=start, 0=stop, 2=reset)
-            if (value == 2) {
-                *timer_value = 0;
-            }
-            // Start/stop would be handled by a separate thread in a real implementation
-            break;
-            
-        default:
-            // Ignore other ports
-            break;
-    }
-}
-
 // Initialize I/O system
 int io_init(VM *vm) {
     if (!vm) {
@@ -158,32 +36,40 @@ int io_init(VM *vm) {
     io_devices->device_count = 0;
     
     // Add standard console device
-    IODevice console_device = {
-        .type = IO_DEVICE_CONSOLE,
-        .base_port = 0,
-        .port_range = 2,
-        .device_data = NULL,
-        .init = console_init,
-        .cleanup = console_cleanup,
-        .read = console_read,
-        .write = console_write
-    };
-    
-    io_add_device(vm, &console_device);
+    int result = io_attach_console(vm, IO_PORT_CONSOLE);
+    if (result != VM_ERROR_NONE) {
+        return result;
+    }
+    
+    // Add interrupt controller first so other devices can raise lines on it
+    result = io_attach_pic(vm, IO_PORT_PIC);
+    if (result != VM_ERROR_NONE) {
+        return result;
+    }
     
     // Add timer device
-    IODevice timer_device = {
-        .type = IO_DEVICE_TIMER,
-        .base_port = 8,
-        .port_range = 2,
-        .device_data = NULL,
-        .init = timer_init,
-        .cleanup = timer_cleanup,
-        .read = timer_read,
-        .write = timer_write
-    };
-    
-    io_add_device(vm, &timer_device);
+    result = io_attach_timer(vm, IO_PORT_TIMER);
+    if (result != VM_ERROR_NONE) {
+        return result;
+    }
+    
+    // Add DMA controller
+    result = io_attach_dma(vm, IO_PORT_DMA);
+    if (result != VM_ERROR_NONE) {
+        return result;
+    }
+    
+    // Add shared-memory ring device
+    result = io_attach_vring(vm, IO_PORT_VRING);
+    if (result != VM_ERROR_NONE) {
+        return result;
+    }
+    
+    // Add channel device for streaming to other VMs
+    result = io_attach_channel(vm, IO_PORT_CHANNEL);
+    if (result != VM_ERROR_NONE) {
+        return result;
+    }
     
     return VM_ERROR_NONE;
 }
@@ -206,6 +92,12 @@ void io_cleanup(VM *vm) {
         }
     }
     
+    // Free the port map and device table
+    for (int i = 0; i < IO_PORT_PAGES; i++) {
+        free(io_devices->port_map[i]);
+    }
+    free(io_devices->devices);
+    
     // Free I/O devices container
     free(vm->io_devices);
     vm->io_devices = NULL;
@@ -218,17 +110,69 @@ int io_add_device(VM *vm, IODevice *device) {
     }
     
     IODevices *io_devices = (IODevices *)vm->io_devices;
+    uint32_t first_port = device->base_port;
+    uint32_t end_port = first_port + device->port_range;
     
-    // Check if we have room for another device
-    if (io_devices->device_count >= MAX_IO_DEVICES) {
+    // The port range must fit in the 16-bit port space and be free
+    if (device->port_range == 0 || end_port > 0x10000) {
         vm->last_error = VM_ERROR_IO_ERROR;
         snprintf(vm->error_message, sizeof(vm->error_message), 
-                 "Maximum number of I/O devices reached");
+                 "Invalid I/O port range 0x%04X+%u", device->base_port, device->port_range);
         return VM_ERROR_IO_ERROR;
     }
+    for (uint32_t port = first_port; port < end_port; port++) {
+        uint16_t *page = io_devices->port_map[port / IO_PORT_PAGE_SIZE];
+        if (page && page[port % IO_PORT_PAGE_SIZE] != IO_PORT_UNMAPPED) {
+            vm->last_error = VM_ERROR_IO_ERROR;
+            snprintf(vm->error_message, sizeof(vm->error_message), 
+                     "I/O port 0x%04X is already in use", port);
+            return VM_ERROR_IO_ERROR;
+        }
+    }
+    
+    // Grow the device table if needed
+    if (io_devices->device_count >= io_devices->device_capacity) {
+        int new_capacity = io_devices->device_capacity ?
+                           io_devices->device_capacity * 2 : IO_INITIAL_DEVICES;
+        if (new_capacity > IO_PORT_UNMAPPED) {
+            new_capacity = IO_PORT_UNMAPPED;
+        }
+        if (io_devices->device_count >= new_capacity) {
+            vm->last_error = VM_ERROR_IO_ERROR;
+            snprintf(vm->error_message, sizeof(vm->error_message), 
+                     "Maximum number of I/O devices reached");
+            return VM_ERROR_IO_ERROR;
+        }
+        
+        IODevice *new_devices = (IODevice *)realloc(io_devices->devices,
+                                                    new_capacity * sizeof(IODevice));
+        if (!new_devices) {
+            vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+            snprintf(vm->error_message, sizeof(vm->error_message), 
+                     "Failed to grow I/O device table");
+            return VM_ERROR_MEMORY_ALLOCATION;
+        }
+        io_devices->devices = new_devices;
+        io_devices->device_capacity = new_capacity;
+    }
+    
+    // Allocate the port map pages covered by this device
+    for (uint32_t page = first_port / IO_PORT_PAGE_SIZE; page <= (end_port - 1) / IO_PORT_PAGE_SIZE; page++) {
+        if (!io_devices->port_map[page]) {
+            io_devices->port_map[page] = (uint16_t *)malloc(IO_PORT_PAGE_SIZE * sizeof(uint16_t));
+            if (!io_devices->port_map[page]) {
+                vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+                snprintf(vm->error_message, sizeof(vm->error_message), 
+                         "Failed to allocate I/O port map");
+                return VM_ERROR_MEMORY_ALLOCATION;
+            }
+            memset(io_devices->port_map[page], 0xFF, IO_PORT_PAGE_SIZE * sizeof(uint16_t));
+        }
+    }
     
     // Copy device configuration
-    memcpy(&io_devices->devices[io_devices->device_count], device, sizeof(IODevice));
+    int index = io_devices->device_count;
+    memcpy(&io_devices->devices[index], device, sizeof(IODevice));
     
     // Initialize the device
     if (device->init) {
@@ -241,27 +185,28 @@ int io_add_device(VM *vm, IODevice *device) {
     // Increment device count
     io_devices->device_count++;
     
+    // Route the device's ports to it
+    for (uint32_t port = first_port; port < end_port; port++) {
+        io_devices->port_map[port / IO_PORT_PAGE_SIZE][port % IO_PORT_PAGE_SIZE] = (uint16_t)index;
+    }
+    
     return VM_ERROR_NONE;
 }
 
 // Find device that handles a specific port
-static IODevice* io_find_device(VM *vm, uint16_t port) {
+static inline IODevice* io_find_device(VM *vm, uint16_t port) {
     if (!vm || !vm->io_devices) {
         return NULL;
     }
     
     IODevices *io_devices = (IODevices *)vm->io_devices;
-    
-    // Search for a device that handles this port
-    for (int i = 0; i < io_devices->device_count; i++) {
-        IODevice *device = &io_devices->devices[i];
-        
-        if (port >= device->base_port && port < device->base_port + device->port_range) {
-            return device;
-        }
+    uint16_t *page = io_devices->port_map[port / IO_PORT_PAGE_SIZE];
+    if (!page) {
+        return NULL;
     }
     
-    return NULL;
+    uint16_t index = page[port % IO_PORT_PAGE_SIZE];
+    return (index == IO_PORT_UNMAPPED) ? NULL : &io_devices->devices[index];
 }
 
 // Read from an I/O port
@@ -304,6 +249,103 @@ void io_write(VM *vm, uint16_t port, uint32_t value) {
     }
 }
 
+// Record header in snapshots; a record with type IO_STATE_END closes the list
+typedef struct {
+    uint8_t  type;
+    uint16_t base_port;
+    uint32_t length;
+} IOStateHeader;
+
+#define IO_STATE_END 0xFF
+
+int io_save_state(VM *vm, FILE *file) {
+    if (!vm || !vm->io_devices || !file) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    IODevices *io_devices = (IODevices *)vm->io_devices;
+    uint8_t buffer[IO_STATE_MAX];
+    IOStateHeader header;
+
+    for (int i = 0; i < io_devices->device_count; i++) {
+        IODevice *device = &io_devices->devices[i];
+        if (!device->save) {
+            continue;
+        }
+
+        memset(&header, 0, sizeof(header));
+        header.type = device->type;
+        header.base_port = device->base_port;
+        header.length = (uint32_t)device->save(vm, device->device_data, buffer, sizeof(buffer));
+        if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+            fwrite(buffer, 1, header.length, file) != header.length) {
+            vm->last_error = VM_ERROR_IO_ERROR;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "Failed to write device state");
+            return VM_ERROR_IO_ERROR;
+        }
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.type = IO_STATE_END;
+    return fwrite(&header, sizeof(header), 1, file) == 1 ? VM_ERROR_NONE : VM_ERROR_IO_ERROR;
+}
+
+int io_restore_state(VM *vm, FILE *file) {
+    if (!vm || !vm->io_devices || !file) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    IODevices *io_devices = (IODevices *)vm->io_devices;
+    uint8_t buffer[IO_STATE_MAX];
+    IOStateHeader header = { 0 };
+
+    while (fread(&header, sizeof(header), 1, file) == 1 && header.type != IO_STATE_END) {
+        IODevice *device = NULL;
+        for (int i = 0; i < io_devices->device_count; i++) {
+            if (io_devices->devices[i].type == header.type &&
+                io_devices->devices[i].base_port == header.base_port) {
+                device = &io_devices->devices[i];
+                break;
+            }
+        }
+
+        if (!device || !device->restore || header.length > sizeof(buffer) ||
+            fread(buffer, 1, header.length, file) != header.length ||
+            device->restore(vm, device->device_data, buffer, header.length) != VM_ERROR_NONE) {
+            if (vm->last_error == VM_ERROR_NONE) {
+                vm->last_error = VM_ERROR_IO_ERROR;
+                snprintf(vm->error_message, sizeof(vm->error_message),
+                         "Cannot restore device type %u at port 0x%04X",
+                         header.type, header.base_port);
+            }
+            return vm->last_error;
+        }
+    }
+
+    if (header.type != IO_STATE_END) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Snapshot device state is cut off");
+        return VM_ERROR_IO_ERROR;
+    }
+    return VM_ERROR_NONE;
+}
+
+void io_reset(VM *vm) {
+    if (!vm || !vm->io_devices) {
+        return;
+    }
+
+    IODevices *io_devices = (IODevices *)vm->io_devices;
+    for (int i = 0; i < io_devices->device_count; i++) {
+        IODevice *device = &io_devices->devices[i];
+        if (device->reset) {
+            device->reset(vm, device->device_data);
+        }
+    }
+}
+
 // Get I/O system status information
 void io_get_status(VM *vm, char *buffer, size_t buffer_size) {
     if (!vm || !vm->io_devices || !buffer) {
@@ -335,6 +377,10 @@ void io_get_status(VM *vm, char *buffer, size_t buffer_size) {
             case IO_DEVICE_CONSOLE: type_str = "Console"; break;
             case IO_DEVICE_DISK:    type_str = "Disk"; break;
             case IO_DEVICE_TIMER:   type_str = "Timer"; break;
+            case IO_DEVICE_PIC:     type_str = "PIC"; break;
+            case IO_DEVICE_DMA:     type_str = "DMA"; break;
+            case IO_DEVICE_VRING:   type_str = "Ring"; break;
+            case IO_DEVICE_CHANNEL: type_str = "Channel"; break;
             case IO_DEVICE_CUSTOM:  type_str = "Custom"; break;
         }
         
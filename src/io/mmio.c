@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vm_types.h"
+#include "mmio.h"
+
+// A device window in the guest address space
+typedef struct {
+    uint32_t base;
+    uint32_t size;
+    MmioReadFn read;
+    MmioWriteFn write;
+    void *data;
+} MmioRegion;
+
+typedef struct {
+    MmioRegion regions[MMIO_MAX_REGIONS];
+    int count;
+} MmioState;
+
+// Recompute the span checked by MMIO_HIT. It starts 3 bytes below the lowest
+// region so multi-byte accesses that straddle a region start are caught too.
+static void mmio_update_span(VM *vm, MmioState *mmio) {
+    if (mmio->count == 0) {
+        vm->mmio_base = 0;
+        vm->mmio_span = 0;
+        return;
+    }
+
+    uint32_t low = mmio->regions[0].base;
+    uint32_t high = mmio->regions[0].base + mmio->regions[0].size;
+    for (int i = 1; i < mmio->count; i++) {
+        if (mmio->regions[i].base < low) {
+            low = mmio->regions[i].base;
+        }
+        if (mmio->regions[i].base + mmio->regions[i].size > high) {
+            high = mmio->regions[i].base + mmio->regions[i].size;
+        }
+    }
+
+    low = (low >= 3) ? low - 3 : 0;
+    vm->mmio_base = low;
+    vm->mmio_span = high - low;
+}
+
+// Map a device window; regions may not overlap
+int mmio_map(VM *vm, uint16_t base, uint16_t size, MmioReadFn read, MmioWriteFn write, void *data) {
+    if (!vm || size == 0 || (uint32_t)base + size > vm->memory_size) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    if (!vm->mmio) {
+        vm->mmio = calloc(1, sizeof(MmioState));
+        if (!vm->mmio) {
+            vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "Failed to allocate MMIO regions");
+            return VM_ERROR_MEMORY_ALLOCATION;
+        }
+    }
+
+    MmioState *mmio = (MmioState *)vm->mmio;
+    if (mmio->count >= MMIO_MAX_REGIONS) {
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Maximum number of MMIO regions reached");
+        return VM_ERROR_IO_ERROR;
+    }
+
+    for (int i = 0; i < mmio->count; i++) {
+        MmioRegion *region = &mmio->regions[i];
+        if (base < region->base + region->size && region->base < (uint32_t)base + size) {
+            vm->last_error = VM_ERROR_IO_ERROR;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "MMIO region 0x%04X+%u overlaps an existing region", base, size);
+            return VM_ERROR_IO_ERROR;
+        }
+    }
+
+    MmioRegion *region = &mmio->regions[mmio->count++];
+    region->base = base;
+    region->size = size;
+    region->read = read;
+    region->write = write;
+    region->data = data;
+
+    mmio_update_span(vm, mmio);
+    return VM_ERROR_NONE;
+}
+
+// Remove the region starting at base
+void mmio_unmap(VM *vm, uint16_t base) {
+    if (!vm || !vm->mmio) {
+        return;
+    }
+
+    MmioState *mmio = (MmioState *)vm->mmio;
+    for (int i = 0; i < mmio->count; i++) {
+        if (mmio->regions[i].base == base) {
+            mmio->regions[i] = mmio->regions[--mmio->count];
+            break;
+        }
+    }
+
+    mmio_update_span(vm, mmio);
+}
+
+void mmio_cleanup(VM *vm) {
+    if (!vm) {
+        return;
+    }
+
+    free(vm->mmio);
+    vm->mmio = NULL;
+    vm->mmio_base = 0;
+    vm->mmio_span = 0;
+}
+
+// Find the region an access touches. Sets a fault and returns NULL if the
+// access only partly overlaps a region; returns NULL with no fault if none.
+static MmioRegion *mmio_find(VM *vm, uint16_t address, uint8_t size) {
+    MmioState *mmio = (MmioState *)vm->mmio;
+    uint32_t end = (uint32_t)address + size;
+
+    for (int i = 0; i < mmio->count; i++) {
+        MmioRegion *region = &mmio->regions[i];
+        if (address < region->base + region->size && region->base < end) {
+            if (address >= region->base && end <= region->base + region->size) {
+                return region;
+            }
+            vm->last_error = VM_ERROR_SEGMENTATION_FAULT;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "Access straddles MMIO region: address 0x%04X, size %d", address, size);
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+int mmio_read(VM *vm, uint16_t address, uint8_t size, uint32_t *value) {
+    if (!vm->mmio) {
+        return 0;
+    }
+
+    MmioRegion *region = mmio_find(vm, address, size);
+    if (!region) {
+        // A straddling access has faulted; report it as handled
+        *value = 0;
+        return vm->last_error != VM_ERROR_NONE;
+    }
+
+    *value = region->read ? region->read(vm, region->data, address - region->base, size) : 0;
+    return 1;
+}
+
+int mmio_write(VM *vm, uint16_t address, uint8_t size, uint32_t value) {
+    if (!vm->mmio) {
+        return 0;
+    }
+
+    MmioRegion *region = mmio_find(vm, address, size);
+    if (!region) {
+        return vm->last_error != VM_ERROR_NONE;
+    }
+
+    if (region->write) {
+        region->write(vm, region->data, address - region->base, size, value);
+    }
+    return 1;
+}
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vm_types.h"
+#include "instruction_set.h"
+#include "io_manager.h"
+#include "pic.h"
+#include "cpu.h"
+
+#define PIC_WORDS (PIC_NUM_VECTORS / 32)
+
+// Programmable interrupt controller state
+typedef struct {
+    uint32_t pending[PIC_WORDS];          // Raised but not yet delivered
+    uint32_t masked[PIC_WORDS];           // Masked vectors are held pending
+    uint8_t  priority[PIC_NUM_VECTORS];   // Per-vector priority (higher wins)
+    uint8_t  selected;                    // Vector addressed through the ports
+} PicState;
+
+#define PIC_BIT(vector)  (1u << ((vector) & 31))
+#define PIC_WORD(vector) ((vector) >> 5)
+
+// Check if any unmasked interrupt is pending
+static int pic_has_deliverable(PicState *pic) {
+    for (int i = 0; i < PIC_WORDS; i++) {
+        if (pic->pending[i] & ~pic->masked[i]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Recompute the run loop flag: set only when delivery is actually possible
+void pic_update(VM *vm) {
+    if (!vm || !vm->pic) {
+        return;
+    }
+
+    PicState *pic = (PicState *)vm->pic;
+    vm->irq_pending = (vm->registers[R4_SR] & INT_FLAG) && pic_has_deliverable(pic);
+}
+
+// Raise an interrupt line
+void pic_raise(VM *vm, uint8_t vector) {
+    if (!vm) {
+        return;
+    }
+
+    if (!vm->pic) {
+        // No controller attached, deliver directly
+        cpu_interrupt(vm, vector);
+        return;
+    }
+
+    PicState *pic = (PicState *)vm->pic;
+    pic->pending[PIC_WORD(vector)] |= PIC_BIT(vector);
+    pic_update(vm);
+}
+
+// Withdraw a pending interrupt that has not been delivered yet
+void pic_lower(VM *vm, uint8_t vector) {
+    if (!vm || !vm->pic) {
+        return;
+    }
+
+    PicState *pic = (PicState *)vm->pic;
+    pic->pending[PIC_WORD(vector)] &= ~PIC_BIT(vector);
+    pic_update(vm);
+}
+
+void pic_set_priority(VM *vm, uint8_t vector, uint8_t priority) {
+    if (!vm || !vm->pic) {
+        return;
+    }
+
+    PicState *pic = (PicState *)vm->pic;
+    pic->priority[vector] = priority;
+}
+
+void pic_set_mask(VM *vm, uint8_t vector, int masked) {
+    if (!vm || !vm->pic) {
+        return;
+    }
+
+    PicState *pic = (PicState *)vm->pic;
+    if (masked) {
+        pic->masked[PIC_WORD(vector)] |= PIC_BIT(vector);
+    } else {
+        pic->masked[PIC_WORD(vector)] &= ~PIC_BIT(vector);
+    }
+    pic_update(vm);
+}
+
+// Deliver the highest-priority pending interrupt
+void pic_service(VM *vm) {
+    if (!vm || !vm->pic) {
+        return;
+    }
+
+    PicState *pic = (PicState *)vm->pic;
+
+    // Interrupts were disabled since the flag was set; wait for STI/IRET/POPF
+    if (!(vm->registers[R4_SR] & INT_FLAG)) {
+        vm->irq_pending = 0;
+        return;
+    }
+
+    // Pick the highest priority; ties go to the lowest vector number
+    int best = -1;
+    for (int i = 0; i < PIC_WORDS; i++) {
+        uint32_t bits = pic->pending[i] & ~pic->masked[i];
+        while (bits) {
+            int vector = i * 32 + __builtin_ctz(bits);
+            if (best < 0 || pic->priority[vector] > pic->priority[best]) {
+                best = vector;
+            }
+            bits &= bits - 1;
+        }
+    }
+
+    if (best < 0) {
+        vm->irq_pending = 0;
+        return;
+    }
+
+    pic->pending[PIC_WORD(best)] &= ~PIC_BIT(best);
+
+    // Entering the handler clears INT_FLAG, so the flag drops until re-enabled
+    cpu_interrupt(vm, (uint8_t)best);
+    pic_update(vm);
+}
+
+// PIC device operations
+static int pic_init(VM *vm, void *device_data) {
+    if (!device_data) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    vm->pic = device_data;
+    vm->irq_pending = 0;
+    return VM_ERROR_NONE;
+}
+
+static void pic_cleanup(VM *vm, void *device_data) {
+    if (vm->pic == device_data) {
+        vm->pic = NULL;
+        vm->irq_pending = 0;
+    }
+    free(device_data);
+}
+
+// Power-on state: nothing pending, masked or prioritized
+static void pic_reset(VM *vm, void *device_data) {
+    memset(device_data, 0, sizeof(PicState));
+    pic_update(vm);
+}
+
+static size_t pic_save(VM *vm, void *device_data, uint8_t *buffer, size_t size) {
+    if (size < sizeof(PicState)) {
+        return 0;
+    }
+    memcpy(buffer, device_data, sizeof(PicState));
+    return sizeof(PicState);
+}
+
+static int pic_restore(VM *vm, void *device_data, const uint8_t *buffer, size_t len) {
+    if (len != sizeof(PicState)) {
+        return VM_ERROR_IO_ERROR;
+    }
+    memcpy(device_data, buffer, sizeof(PicState));
+    pic_update(vm);
+    return VM_ERROR_NONE;
+}
+
+static uint32_t pic_read(VM *vm, void *device_data, uint16_t port) {
+    PicState *pic = (PicState *)device_data;
+    uint8_t vector = pic->selected;
+
+    switch (port) {
+        case PIC_PORT_SELECT:
+            return vector;
+
+        case PIC_PORT_PRIORITY:
+            return pic->priority[vector];
+
+        case PIC_PORT_MASK:
+            return (pic->masked[PIC_WORD(vector)] & PIC_BIT(vector)) ? 1 : 0;
+
+        case PIC_PORT_PENDING:
+            return (pic->pending[PIC_WORD(vector)] & PIC_BIT(vector)) ? 1 : 0;
+
+        default:
+            return 0;
+    }
+}
+
+static void pic_write(VM *vm, void *device_data, uint16_t port, uint32_t value) {
+    PicState *pic = (PicState *)device_data;
+    uint8_t vector = pic->selected;
+
+    switch (port) {
+        case PIC_PORT_SELECT:
+            pic->selected = value & 0xFF;
+            break;
+
+        case PIC_PORT_PRIORITY:
+            pic_set_priority(vm, vector, value & 0xFF);
+            break;
+
+        case PIC_PORT_MASK:
+            pic_set_mask(vm, vector, value != 0);
+            break;
+
+        case PIC_PORT_PENDING:
+            if (value) {
+                pic_raise(vm, vector);
+            } else {
+                pic_lower(vm, vector);
+            }
+            break;
+
+        default:
+            // Ignore other ports
+            break;
+    }
+}
+
+// Attach the interrupt controller at the given base port
+int io_attach_pic(VM *vm, uint16_t base_port) {
+    PicState *pic = (PicState *)calloc(1, sizeof(PicState));
+    if (!pic) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate interrupt controller");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    IODevice pic_device = {
+        .type = IO_DEVICE_PIC,
+        .base_port = base_port,
+        .port_range = PIC_PORT_COUNT,
+        .device_data = pic,
+        .init = pic_init,
+        .cleanup = pic_cleanup,
+        .read = pic_read,
+        .write = pic_write,
+        .save = pic_save,
+        .restore = pic_restore,
+        .reset = pic_reset
+    };
+
+    int result = io_add_device(vm, &pic_device);
+    if (result != VM_ERROR_NONE) {
+        free(pic);
+    }
+    return result;
+}
@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vm_types.h"
+#include "io_manager.h"
+#include "events.h"
+#include "timer.h"
+#include "pic.h"
+#include "clock.h"
+
+// Timer device state
+typedef struct {
+    uint32_t period;          // Reload value (instructions, or microseconds in wall-clock mode)
+    uint32_t deadline;        // Instruction count of next expiry (virtual mode)
+    uint64_t wall_deadline;   // Host time of next expiry in microseconds (wall-clock mode)
+    uint32_t expirations;     // Number of expiries since last clear
+    uint8_t  mode;            // TIMER_MODE_* flags
+    uint8_t  vector;          // Interrupt vector raised on expiry
+    uint8_t  running;         // Timer is armed
+} TimerState;
+
+static void timer_expire(VM *vm, void *data);
+static void timer_poll(VM *vm, void *data);
+
+// Guest clock time in microseconds (host or virtual, see clock.h)
+static uint64_t timer_now_us(VM *vm) {
+    return clock_now_ns(vm) / 1000ULL;
+}
+
+// Arm the timer for one full period from now
+static void timer_arm(VM *vm, TimerState *timer) {
+    events_cancel(vm, timer_expire, timer);
+    events_cancel(vm, timer_poll, timer);
+
+    if (!timer->running || timer->period == 0) {
+        return;
+    }
+
+    if (timer->mode & TIMER_MODE_WALLCLOCK) {
+        timer->wall_deadline = timer_now_us(vm) + timer->period;
+        events_schedule(vm, TIMER_WALL_POLL_INTERVAL, timer_poll, timer);
+    } else {
+        timer->deadline = vm->instruction_count + timer->period;
+        events_schedule(vm, timer->period, timer_expire, timer);
+    }
+}
+
+// Signal an expiry to the guest
+static void timer_fire(VM *vm, TimerState *timer) {
+    timer->expirations++;
+    pic_raise(vm, timer->vector);
+}
+
+// Virtual-time expiry event
+static void timer_expire(VM *vm, void *data) {
+    TimerState *timer = (TimerState *)data;
+
+    timer_fire(vm, timer);
+
+    if (timer->mode & TIMER_MODE_PERIODIC) {
+        timer->deadline += timer->period;
+        events_schedule(vm, timer->period, timer_expire, timer);
+    } else {
+        timer->running = 0;
+    }
+}
+
+// Wall-clock mode: check the host clock at regular virtual-time intervals
+static void timer_poll(VM *vm, void *data) {
+    TimerState *timer = (TimerState *)data;
+    uint64_t now = timer_now_us(vm);
+
+    if (now >= timer->wall_deadline) {
+        timer_fire(vm, timer);
+
+        if (!(timer->mode & TIMER_MODE_PERIODIC)) {
+            timer->running = 0;
+            return;
+        }
+
+        // Keep a steady cadence, but don't try to catch up on missed periods
+        timer->wall_deadline += timer->period;
+        if (timer->wall_deadline <= now) {
+            timer->wall_deadline = now + timer->period;
+        }
+    }
+
+    events_schedule(vm, TIMER_WALL_POLL_INTERVAL, timer_poll, timer);
+}
+
+// Timer device operations
+static int timer_init(VM *vm, void *device_data) {
+    TimerState *timer = (TimerState *)device_data;
+    if (!timer) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    timer->vector = TIMER_DEFAULT_VECTOR;
+    return VM_ERROR_NONE;
+}
+
+static void timer_cleanup(VM *vm, void *device_data) {
+    TimerState *timer = (TimerState *)device_data;
+    if (!timer) {
+        return;
+    }
+
+    events_cancel(vm, timer_expire, timer);
+    events_cancel(vm, timer_poll, timer);
+    free(timer);
+}
+
+// Stop the timer and put its registers back to their power-on values
+static void timer_reset(VM *vm, void *device_data) {
+    TimerState *timer = (TimerState *)device_data;
+
+    events_cancel(vm, timer_expire, timer);
+    events_cancel(vm, timer_poll, timer);
+    memset(timer, 0, sizeof(TimerState));
+    timer->vector = TIMER_DEFAULT_VECTOR;
+}
+
+// Snapshot state: the registers plus the delays of pending events
+typedef struct {
+    TimerState timer;
+    int64_t expire_in;
+    int64_t poll_in;
+} TimerSnapshot;
+
+static size_t timer_save(VM *vm, void *device_data, uint8_t *buffer, size_t size) {
+    TimerState *timer = (TimerState *)device_data;
+    TimerSnapshot snapshot;
+
+    if (size < sizeof(snapshot)) {
+        return 0;
+    }
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.timer = *timer;
+    snapshot.expire_in = events_remaining(vm, timer_expire, timer);
+    snapshot.poll_in = events_remaining(vm, timer_poll, timer);
+    memcpy(buffer, &snapshot, sizeof(snapshot));
+    return sizeof(snapshot);
+}
+
+static int timer_restore(VM *vm, void *device_data, const uint8_t *buffer, size_t len) {
+    TimerState *timer = (TimerState *)device_data;
+    TimerSnapshot snapshot;
+
+    if (len != sizeof(snapshot)) {
+        return VM_ERROR_IO_ERROR;
+    }
+    memcpy(&snapshot, buffer, sizeof(snapshot));
+
+    events_cancel(vm, timer_expire, timer);
+    events_cancel(vm, timer_poll, timer);
+    *timer = snapshot.timer;
+    if (snapshot.expire_in >= 0) {
+        events_schedule(vm, (uint32_t)snapshot.expire_in, timer_expire, timer);
+    }
+    if (snapshot.poll_in >= 0) {
+        events_schedule(vm, (uint32_t)snapshot.poll_in, timer_poll, timer);
+    }
+    return VM_ERROR_NONE;
+}
+
+static uint32_t timer_read(VM *vm, void *device_data, uint16_t port) {
+    TimerState *timer = (TimerState *)device_data;
+    if (!timer) {
+        return 0;
+    }
+
+    switch (port) {
+        case TIMER_PORT_COUNTER:  // Remaining time until expiry
+            if (!timer->running) {
+                return timer->period;
+            }
+            if (timer->mode & TIMER_MODE_WALLCLOCK) {
+                uint64_t now = timer_now_us(vm);
+                return now >= timer->wall_deadline ? 0 : (uint32_t)(timer->wall_deadline - now);
+            } else {
+                int32_t remaining = (int32_t)(timer->deadline - vm->instruction_count);
+                return remaining > 0 ? (uint32_t)remaining : 0;
+            }
+
+        case TIMER_PORT_CONTROL:  // Running status
+            return timer->running;
+
+        case TIMER_PORT_MODE:
+            return timer->mode;
+
+        case TIMER_PORT_VECTOR:
+            return timer->vector;
+
+        case TIMER_PORT_EXPIRED:
+            return timer->expirations;
+
+        default:
+            return 0;
+    }
+}
+
+static void timer_write(VM *vm, void *device_data, uint16_t port, uint32_t value) {
+    TimerState *timer = (TimerState *)device_data;
+    if (!timer) {
+        return;
+    }
+
+    switch (port) {
+        case TIMER_PORT_COUNTER:  // Set period, takes effect on next start or reload
+            timer->period = value;
+            break;
+
+        case TIMER_PORT_CONTROL:
+            switch (value) {
+                case TIMER_CMD_STOP:
+                    timer->running = 0;
+                    timer_arm(vm, timer);
+                    break;
+
+                case TIMER_CMD_START:
+                    timer->running = 1;
+                    timer_arm(vm, timer);
+                    break;
+
+                case TIMER_CMD_RESET:
+                    // Restart the current period and clear the expiry count
+                    timer->expirations = 0;
+                    timer_arm(vm, timer);
+                    break;
+            }
+            break;
+
+        case TIMER_PORT_MODE:
+            timer->mode = value & (TIMER_MODE_PERIODIC | TIMER_MODE_WALLCLOCK);
+            timer_arm(vm, timer);
+            break;
+
+        case TIMER_PORT_VECTOR:
+            timer->vector = value & 0xFF;
+            break;
+
+        case TIMER_PORT_EXPIRED:
+            timer->expirations = 0;
+            break;
+
+        default:
+            // Ignore other ports
+            break;
+    }
+}
+
+// Attach a timer device at the given base port
+int io_attach_timer(VM *vm, uint16_t base_port) {
+    TimerState *timer = (TimerState *)calloc(1, sizeof(TimerState));
+    if (!timer) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate timer device");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    IODevice timer_device = {
+        .type = IO_DEVICE_TIMER,
+        .base_port = base_port,
+        .port_range = TIMER_PORT_COUNT,
+        .device_data = timer,
+        .init = timer_init,
+        .cleanup = timer_cleanup,
+        .read = timer_read,
+        .write = timer_write,
+        .save = timer_save,
+        .restore = timer_restore,
+        .reset = timer_reset
+    };
+
+    int result = io_add_device(vm, &timer_device);
+    if (result != VM_ERROR_NONE) {
+        free(timer);
+    }
+    return result;
+}
@@ -0,0 +1,394 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vm_types.h"
+#include "memory.h"
+#include "io_manager.h"
+#include "vring.h"
+#include "pic.h"
+
+// One queue: ring addresses in guest memory plus host-side indices
+typedef struct {
+    uint16_t size;
+    uint16_t desc;
+    uint16_t avail;
+    uint16_t used;
+    uint8_t  enabled;
+    uint16_t last_avail;      // Next available entry to consume
+    uint16_t used_idx;        // Entries pushed by the host
+    uint16_t published;       // Entries visible to the guest through used->idx
+} VringQueue;
+
+// Ring device state
+typedef struct {
+    VringQueue queues[VRING_QUEUES];
+    uint8_t  selected;
+    uint8_t  vector;
+    uint8_t  status;          // Queues with entries published since the last status read
+    VringNotifyFn notify;
+    void    *notify_data;
+} VringState;
+
+// Ring fields are 16-bit little-endian; addresses are checked before each use
+static uint16_t vring_get16(VM *vm, uint32_t address) {
+    return (uint16_t)(vm->memory[address] | (vm->memory[address + 1] << 8));
+}
+
+static void vring_put16(VM *vm, uint32_t address, uint16_t value) {
+    vm->memory[address] = (uint8_t)(value & 0xFF);
+    vm->memory[address + 1] = (uint8_t)(value >> 8);
+}
+
+static VringQueue *vring_queue(VM *vm, int queue) {
+    if (!vm || !vm->vring || queue < 0 || queue >= VRING_QUEUES) {
+        return NULL;
+    }
+
+    VringQueue *q = &((VringState *)vm->vring)->queues[queue];
+    return q->enabled ? q : NULL;
+}
+
+// Check a guest range like any other access. Ring traffic happens outside
+// the guest's instructions, so a bad range is refused without faulting the VM.
+static int vring_check(VM *vm, uint32_t address, uint32_t size, uint8_t perm) {
+    if (address + size > vm->memory_size) {
+        return 0;
+    }
+    if (size == 0) {
+        return 1;
+    }
+
+    int saved_error = vm->last_error;
+    int ok = memory_check_address_permissions(vm, (uint16_t)address, (uint16_t)size, perm) == VM_ERROR_NONE;
+    vm->last_error = saved_error;
+    return ok;
+}
+
+// The guest writes the descriptors and available ring; the host reads them
+// and writes the used ring. Heap blocks can be freed or reprotected while a
+// queue is enabled, so the rings are checked again whenever they are used.
+static int vring_rings_ok(VM *vm, VringQueue *q) {
+    return vring_check(vm, q->desc, q->size * VRING_DESC_SIZE, VM_PROT_READ) &&
+           vring_check(vm, q->avail, VRING_AVAIL_SIZE(q->size), VM_PROT_READ) &&
+           vring_check(vm, q->used, VRING_USED_SIZE(q->size), VM_PROT_READ | VM_PROT_WRITE);
+}
+
+// Enable a queue after checking that the host may access its rings
+static void vring_enable(VM *vm, VringQueue *q) {
+    q->enabled = 0;
+    q->last_avail = 0;
+    q->used_idx = 0;
+    q->published = 0;
+
+    if (q->size == 0 || q->size > VRING_MAX_SIZE || (q->size & (q->size - 1)) != 0) {
+        return;
+    }
+    if (!vring_rings_ok(vm, q)) {
+        return;
+    }
+
+    vring_put16(vm, q->used, 0);
+    vring_put16(vm, q->used + 2, 0);
+    q->enabled = 1;
+}
+
+// Take the next buffer the guest made available on a queue
+int vring_pop(VM *vm, int queue, VringBuffer *buffer) {
+    VringQueue *q = vring_queue(vm, queue);
+    if (!q || !buffer) {
+        return 0;
+    }
+    if (!vring_rings_ok(vm, q)) {
+        q->enabled = 0;
+        return 0;
+    }
+
+    // The host reads TX buffers and writes RX buffers
+    uint8_t perm = (queue == VRING_QUEUE_RX) ? VM_PROT_WRITE : VM_PROT_READ;
+
+    for (;;) {
+        uint16_t pending = (uint16_t)(vring_get16(vm, q->avail + 2) - q->last_avail);
+        if (pending == 0) {
+            return 0;
+        }
+        if (pending > q->size) {
+            // The guest's index is corrupt; stop using the queue until re-enabled
+            q->enabled = 0;
+            return 0;
+        }
+
+        uint16_t slot = q->last_avail & (q->size - 1);
+        uint16_t id = vring_get16(vm, q->avail + 4 + slot * 2);
+        q->last_avail++;
+
+        if (id < q->size) {
+            uint32_t entry = q->desc + id * VRING_DESC_SIZE;
+            uint16_t addr = vring_get16(vm, entry);
+            uint16_t len = vring_get16(vm, entry + 2);
+
+            if (vring_check(vm, addr, len, perm)) {
+                buffer->id = id;
+                buffer->addr = addr;
+                buffer->len = len;
+                buffer->data = &vm->memory[addr];
+                return 1;
+            }
+        }
+
+        // Hand bad descriptors straight back as empty completions
+        vring_push(vm, queue, id, 0);
+    }
+}
+
+// Return a buffer to the guest; 'len' is the number of bytes written into it
+int vring_push(VM *vm, int queue, uint16_t id, uint16_t len) {
+    VringQueue *q = vring_queue(vm, queue);
+    if (!q) {
+        return VM_ERROR_IO_ERROR;
+    }
+    if (!vring_rings_ok(vm, q)) {
+        q->enabled = 0;
+        return VM_ERROR_IO_ERROR;
+    }
+
+    uint32_t entry = q->used + 4 + (q->used_idx & (q->size - 1)) * 4;
+    vring_put16(vm, entry, id);
+    vring_put16(vm, entry + 2, len);
+    q->used_idx++;
+    return VM_ERROR_NONE;
+}
+
+// Publish pushed entries on every queue and raise a single interrupt for the batch
+void vring_flush(VM *vm) {
+    if (!vm || !vm->vring) {
+        return;
+    }
+
+    VringState *vring = (VringState *)vm->vring;
+    int raise = 0;
+
+    for (int i = 0; i < VRING_QUEUES; i++) {
+        VringQueue *q = &vring->queues[i];
+        if (!q->enabled || q->used_idx == q->published) {
+            continue;
+        }
+        if (!vring_rings_ok(vm, q)) {
+            q->enabled = 0;
+            continue;
+        }
+
+        vring_put16(vm, q->used + 2, q->used_idx);
+        q->published = q->used_idx;
+        vring->status |= 1 << i;
+
+        if (!(vring_get16(vm, q->avail) & VRING_AVAIL_NO_INTERRUPT)) {
+            raise = 1;
+        }
+    }
+
+    if (raise && vring->vector != 0) {
+        pic_raise(vm, vring->vector);
+    }
+}
+
+void vring_set_notify(VM *vm, VringNotifyFn notify, void *data) {
+    if (!vm || !vm->vring) {
+        return;
+    }
+
+    VringState *vring = (VringState *)vm->vring;
+    vring->notify = notify;
+    vring->notify_data = data;
+}
+
+// Copy a message into the next RX buffer, truncating to the buffer size
+int vring_send(VM *vm, const void *data, uint16_t len) {
+    VringBuffer buffer;
+    if (!vring_pop(vm, VRING_QUEUE_RX, &buffer)) {
+        return -1;
+    }
+
+    uint16_t count = len < buffer.len ? len : buffer.len;
+    memcpy(buffer.data, data, count);
+    vring_push(vm, VRING_QUEUE_RX, buffer.id, count);
+    return count;
+}
+
+// Copy the next TX message out of guest memory, truncating to 'size'
+int vring_receive(VM *vm, void *data, uint16_t size) {
+    VringBuffer buffer;
+    if (!vring_pop(vm, VRING_QUEUE_TX, &buffer)) {
+        return -1;
+    }
+
+    uint16_t count = buffer.len < size ? buffer.len : size;
+    memcpy(data, buffer.data, count);
+    vring_push(vm, VRING_QUEUE_TX, buffer.id, 0);
+    return count;
+}
+
+// Ring device operations
+static int vring_init(VM *vm, void *device_data) {
+    VringState *vring = (VringState *)device_data;
+    if (!vring) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    vring->vector = VRING_DEFAULT_VECTOR;
+    vm->vring = vring;
+    return VM_ERROR_NONE;
+}
+
+static void vring_cleanup(VM *vm, void *device_data) {
+    if (vm->vring == device_data) {
+        vring_bridge_close(vm);
+        vm->vring = NULL;
+    }
+    free(device_data);
+}
+
+// Snapshot state: everything but the host's notify hook
+typedef struct {
+    VringQueue queues[VRING_QUEUES];
+    uint8_t  selected;
+    uint8_t  vector;
+    uint8_t  status;
+} VringSnapshot;
+
+static size_t vring_save(VM *vm, void *device_data, uint8_t *buffer, size_t size) {
+    VringState *vring = (VringState *)device_data;
+    VringSnapshot snapshot;
+
+    if (size < sizeof(snapshot)) {
+        return 0;
+    }
+    memset(&snapshot, 0, sizeof(snapshot));
+    memcpy(snapshot.queues, vring->queues, sizeof(snapshot.queues));
+    snapshot.selected = vring->selected;
+    snapshot.vector = vring->vector;
+    snapshot.status = vring->status;
+    memcpy(buffer, &snapshot, sizeof(snapshot));
+    return sizeof(snapshot);
+}
+
+static int vring_restore(VM *vm, void *device_data, const uint8_t *buffer, size_t len) {
+    VringState *vring = (VringState *)device_data;
+    VringSnapshot snapshot;
+
+    if (len != sizeof(snapshot)) {
+        return VM_ERROR_IO_ERROR;
+    }
+    memcpy(&snapshot, buffer, sizeof(snapshot));
+
+    memcpy(vring->queues, snapshot.queues, sizeof(vring->queues));
+    vring->selected = snapshot.selected < VRING_QUEUES ? snapshot.selected : 0;
+    vring->vector = snapshot.vector;
+    vring->status = snapshot.status;
+    return VM_ERROR_NONE;
+}
+
+static uint32_t vring_read(VM *vm, void *device_data, uint16_t port) {
+    VringState *vring = (VringState *)device_data;
+    VringQueue *q = &vring->queues[vring->selected];
+
+    switch (port) {
+        case VRING_PORT_SELECT:   return vring->selected;
+        case VRING_PORT_SIZE:     return q->size;
+        case VRING_PORT_DESC:     return q->desc;
+        case VRING_PORT_AVAIL:    return q->avail;
+        case VRING_PORT_USED:     return q->used;
+        case VRING_PORT_ENABLE:   return q->enabled;
+        case VRING_PORT_VECTOR:   return vring->vector;
+
+        case VRING_PORT_STATUS: {
+            uint8_t status = vring->status;
+            vring->status = 0;
+            return status;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+static void vring_write(VM *vm, void *device_data, uint16_t port, uint32_t value) {
+    VringState *vring = (VringState *)device_data;
+    VringQueue *q = &vring->queues[vring->selected];
+
+    switch (port) {
+        case VRING_PORT_SELECT:
+            if (value < VRING_QUEUES) {
+                vring->selected = (uint8_t)value;
+            }
+            break;
+
+        // Layout changes only take effect on the next enable
+        case VRING_PORT_SIZE:
+            q->size = (uint16_t)value;
+            break;
+
+        case VRING_PORT_DESC:
+            q->desc = (uint16_t)value;
+            break;
+
+        case VRING_PORT_AVAIL:
+            q->avail = (uint16_t)value;
+            break;
+
+        case VRING_PORT_USED:
+            q->used = (uint16_t)value;
+            break;
+
+        case VRING_PORT_ENABLE:
+            if (value) {
+                vring_enable(vm, q);
+            } else {
+                q->enabled = 0;
+            }
+            break;
+
+        case VRING_PORT_NOTIFY:
+            if (value < VRING_QUEUES && vring->notify) {
+                vring->notify(vm, (int)value, vring->notify_data);
+            }
+            break;
+
+        case VRING_PORT_VECTOR:
+            vring->vector = value & 0xFF;
+            break;
+
+        default:
+            // Status is read-only
+            break;
+    }
+}
+
+// Attach the ring device at the given base port
+int io_attach_vring(VM *vm, uint16_t base_port) {
+    VringState *vring = (VringState *)calloc(1, sizeof(VringState));
+    if (!vring) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate ring device");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    IODevice vring_device = {
+        .type = IO_DEVICE_VRING,
+        .base_port = base_port,
+        .port_range = VRING_PORT_COUNT,
+        .device_data = vring,
+        .init = vring_init,
+        .cleanup = vring_cleanup,
+        .read = vring_read,
+        .write = vring_write,
+        .save = vring_save,
+        .restore = vring_restore
+    };
+
+    int result = io_add_device(vm, &vring_device);
+    if (result != VM_ERROR_NONE) {
+        free(vring);
+    }
+    return result;
+}
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "vm_types.h"
+#include "events.h"
+#include "vring.h"
+#include "replay.h"
+
+// Room for at least one maximum-size frame plus a batch of smaller ones
+#define VRING_FRAME_MAX       (2 + 0xFFFF)
+#define VRING_BRIDGE_BUFFER   (2 * VRING_FRAME_MAX)
+
+// Socket bridge state
+typedef struct {
+    int listen_fd;
+    int client_fd;
+    int connected;                     // Separate from client_fd, which playback never opens
+    struct sockaddr_un address;
+    uint8_t in[VRING_BRIDGE_BUFFER];   // Received bytes not yet delivered
+    size_t  in_used;
+    uint8_t out[VRING_BRIDGE_BUFFER];  // Frames not yet sent
+    size_t  out_used;
+} VringBridge;
+
+static void vring_bridge_poll(VM *vm, void *data);
+
+static void vring_bridge_disconnect(VringBridge *bridge) {
+    if (bridge->client_fd >= 0) {
+        close(bridge->client_fd);
+    }
+    bridge->client_fd = -1;
+    bridge->connected = 0;
+    bridge->in_used = 0;
+    bridge->out_used = 0;
+}
+
+// Host side of the socket; the pump sees it only through the replay log
+static int vring_bridge_accept(VringBridge *bridge) {
+    bridge->client_fd = accept(bridge->listen_fd, NULL, NULL);
+    if (bridge->client_fd < 0) {
+        return 0;
+    }
+    fcntl(bridge->client_fd, F_SETFL, O_NONBLOCK);
+    return 1;
+}
+
+// Append what the socket has to the input buffer: byte count, or -1 once the peer is gone
+static ssize_t vring_bridge_receive(VringBridge *bridge) {
+    size_t received = 0;
+
+    while (bridge->in_used + received < sizeof(bridge->in)) {
+        ssize_t count = read(bridge->client_fd, bridge->in + bridge->in_used + received,
+                             sizeof(bridge->in) - bridge->in_used - received);
+        if (count > 0) {
+            received += (size_t)count;
+        } else if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            return -1;
+        } else {
+            break;
+        }
+    }
+    return (ssize_t)received;
+}
+
+static ssize_t vring_bridge_send(VringBridge *bridge) {
+    ssize_t count = send(bridge->client_fd, bridge->out, bridge->out_used, MSG_NOSIGNAL);
+    if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;
+    }
+    return count;
+}
+
+// Move messages in both directions, then publish them with one flush
+static void vring_bridge_pump(VM *vm, VringBridge *bridge) {
+    if (!bridge->connected) {
+        bridge->connected = (int)REPLAY_VALUE(vm, REPLAY_SOCKET_ACCEPT, vring_bridge_accept(bridge));
+        if (!bridge->connected) {
+            return;
+        }
+    }
+
+    // Receive whatever the socket has, then deliver complete frames to RX buffers
+    ssize_t received = (ssize_t)REPLAY_VALUE(vm, REPLAY_SOCKET_RECEIVE, vring_bridge_receive(bridge));
+    if (received < 0 || (size_t)received > sizeof(bridge->in) - bridge->in_used) {
+        vring_bridge_disconnect(bridge);
+        return;
+    }
+    if (received > 0 && vm->replay_mode) {
+        replay_data(vm, REPLAY_SOCKET_DATA, bridge->in + bridge->in_used, (uint32_t)received);
+    }
+    bridge->in_used += (size_t)received;
+
+    size_t offset = 0;
+    while (bridge->in_used - offset >= 2) {
+        uint16_t len = (uint16_t)(bridge->in[offset] | (bridge->in[offset + 1] << 8));
+        if (bridge->in_used - offset < 2u + len ||
+            vring_send(vm, bridge->in + offset + 2, len) < 0) {
+            break;
+        }
+        offset += 2u + len;
+    }
+    memmove(bridge->in, bridge->in + offset, bridge->in_used - offset);
+    bridge->in_used -= offset;
+
+    // Frame TX buffers while a maximum-size frame still fits
+    VringBuffer buffer;
+    while (bridge->out_used + VRING_FRAME_MAX <= sizeof(bridge->out) &&
+           vring_pop(vm, VRING_QUEUE_TX, &buffer)) {
+        bridge->out[bridge->out_used] = (uint8_t)(buffer.len & 0xFF);
+        bridge->out[bridge->out_used + 1] = (uint8_t)(buffer.len >> 8);
+        memcpy(bridge->out + bridge->out_used + 2, buffer.data, buffer.len);
+        bridge->out_used += 2u + buffer.len;
+        vring_push(vm, VRING_QUEUE_TX, buffer.id, 0);
+    }
+
+    vring_flush(vm);
+
+    if (bridge->out_used > 0) {
+        ssize_t count = (ssize_t)REPLAY_VALUE(vm, REPLAY_SOCKET, vring_bridge_send(bridge));
+        if (count > 0 && (size_t)count <= bridge->out_used) {
+            memmove(bridge->out, bridge->out + count, bridge->out_used - (size_t)count);
+            bridge->out_used -= (size_t)count;
+        } else if (count < 0) {
+            vring_bridge_disconnect(bridge);
+        }
+    }
+}
+
+// Regular poll so incoming frames arrive even when the guest is not notifying
+static void vring_bridge_poll(VM *vm, void *data) {
+    vring_bridge_pump(vm, (VringBridge *)data);
+    events_schedule(vm, VRING_BRIDGE_POLL_INTERVAL, vring_bridge_poll, data);
+}
+
+// Doorbell from the guest: new TX messages or RX buffers
+static void vring_bridge_notify(VM *vm, int queue, void *data) {
+    vring_bridge_pump(vm, (VringBridge *)data);
+}
+
+// Listen on a Unix-domain socket and connect it to the ring device
+int vring_bridge_open(VM *vm, const char *path) {
+    if (!vm || !vm->vring || !path) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    VringBridge *bridge = (VringBridge *)calloc(1, sizeof(VringBridge));
+    if (!bridge) {
+        vm->last_error = VM_ERROR_MEMORY_ALLOCATION;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Failed to allocate ring bridge");
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    bridge->client_fd = -1;
+    bridge->address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(bridge->address.sun_path)) {
+        free(bridge);
+        vm->last_error = VM_ERROR_IO_ERROR;
+        snprintf(vm->error_message, sizeof(vm->error_message),
+                 "Socket path too long: %s", path);
+        return VM_ERROR_IO_ERROR;
+    }
+    strcpy(bridge->address.sun_path, path);
+
+    // On playback the peer is the log; leave the socket path alone
+    bridge->listen_fd = -1;
+    if (!REPLAYING(vm)) {
+        // Replace a socket left behind by an earlier run
+        unlink(path);
+
+        bridge->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (bridge->listen_fd < 0 ||
+            bind(bridge->listen_fd, (struct sockaddr *)&bridge->address, sizeof(bridge->address)) < 0 ||
+            listen(bridge->listen_fd, 1) < 0) {
+            vm->last_error = VM_ERROR_IO_ERROR;
+            snprintf(vm->error_message, sizeof(vm->error_message),
+                     "Cannot listen on %s: %s", path, strerror(errno));
+            if (bridge->listen_fd >= 0) {
+                close(bridge->listen_fd);
+            }
+            free(bridge);
+            return VM_ERROR_IO_ERROR;
+        }
+        fcntl(bridge->listen_fd, F_SETFL, O_NONBLOCK);
+    }
+
+    vm->vring_bridge = bridge;
+    vring_set_notify(vm, vring_bridge_notify, bridge);
+    events_schedule(vm, VRING_BRIDGE_POLL_INTERVAL, vring_bridge_poll, bridge);
+    return VM_ERROR_NONE;
+}
+
+void vring_bridge_close(VM *vm) {
+    if (!vm || !vm->vring_bridge) {
+        return;
+    }
+
+    VringBridge *bridge = (VringBridge *)vm->vring_bridge;
+
+    // Send out messages the guest queued before stopping
+    if (bridge->connected) {
+        vring_bridge_pump(vm, bridge);
+        vring_bridge_disconnect(bridge);
+    }
+
+    events_cancel(vm, vring_bridge_poll, bridge);
+    vring_set_notify(vm, NULL, NULL);
+    if (bridge->listen_fd >= 0) {
+        close(bridge->listen_fd);
+        unlink(bridge->address.sun_path);
+    }
+    free(bridge);
+    vm->vring_bridge = NULL;
+}
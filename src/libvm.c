@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vm.h"
+#include "libvm.h"
+#include "console.h"
+#include "mmio.h"
+#include "vring.h"
+#include "plugin.h"
+
+#define LIBVM_DEFAULT_MEMORY_SIZE (64 * 1024)
+
+static void *libvm_alloc(const VMAllocator *allocator, size_t size) {
+    return allocator ? allocator->alloc(size, allocator->user_data) : malloc(size);
+}
+
+static void libvm_free(const VMAllocator *allocator, void *ptr) {
+    if (allocator) {
+        allocator->free(ptr, allocator->user_data);
+    } else {
+        free(ptr);
+    }
+}
+
+VM *vm_create(const VMConfig *config) {
+    VMConfig defaults;
+    if (!config) {
+        memset(&defaults, 0, sizeof(defaults));
+        config = &defaults;
+    }
+
+    const VMAllocator *allocator = config->allocator;
+    if (allocator && (!allocator->alloc || !allocator->free)) {
+        return NULL;
+    }
+
+    VM *vm = (VM *)libvm_alloc(allocator, sizeof(VM));
+    if (!vm) {
+        return NULL;
+    }
+
+    uint32_t memory_size = config->memory_size ? config->memory_size : LIBVM_DEFAULT_MEMORY_SIZE;
+    int result = allocator
+        ? vm_init_with_allocator(vm, memory_size, allocator->alloc, allocator->free, allocator->user_data)
+        : vm_init(vm, memory_size);
+    if (result != VM_ERROR_NONE) {
+        libvm_free(allocator, vm);
+        return NULL;
+    }
+
+    vm->log_stream = config->log;
+    vm->user_data = config->user_data;
+
+    if (config->output &&
+        console_set_output_callback(vm, config->output, config->output_data) != VM_ERROR_NONE) {
+        vm_destroy(vm);
+        return NULL;
+    }
+    return vm;
+}
+
+void vm_destroy(VM *vm) {
+    if (!vm) {
+        return;
+    }
+
+    // The struct came from the same allocator as guest memory
+    VMAllocator allocator = { vm->memory_alloc, vm->memory_free, vm->allocator_data };
+    vm_cleanup(vm);
+    libvm_free(allocator.alloc ? &allocator : NULL, vm);
+}
+
+int vm_set_input_fd(VM *vm, int fd) {
+    return console_set_input_fd(vm, fd);
+}
+
+int vm_halted(VM *vm) {
+    return vm ? vm->halted : 1;
+}
+
+uint32_t vm_get_instruction_count(VM *vm) {
+    return vm ? vm->instruction_count : 0;
+}
+
+uint32_t vm_get_register(VM *vm, unsigned int reg) {
+    if (!vm || reg >= 16) {
+        return 0;
+    }
+    return vm->registers[reg];
+}
+
+void vm_set_register(VM *vm, unsigned int reg, uint32_t value) {
+    if (vm && reg < 16) {
+        vm->registers[reg] = value;
+    }
+}
+
+int vm_mmio_map(VM *vm, uint16_t base, uint16_t size, VMMmioReadFn read,
+                VMMmioWriteFn write, void *data) {
+    return mmio_map(vm, base, size, read, write, data);
+}
+
+void vm_mmio_unmap(VM *vm, uint16_t base) {
+    mmio_unmap(vm, base);
+}
+
+int vm_ring_pop(VM *vm, int queue, VMRingBuffer *buffer) {
+    VringBuffer taken;
+    if (!buffer || !vring_pop(vm, queue, &taken)) {
+        return 0;
+    }
+
+    buffer->id = taken.id;
+    buffer->addr = taken.addr;
+    buffer->len = taken.len;
+    buffer->data = taken.data;
+    return 1;
+}
+
+int vm_ring_push(VM *vm, int queue, uint16_t id, uint16_t len) {
+    return vring_push(vm, queue, id, len);
+}
+
+void vm_ring_flush(VM *vm) {
+    vring_flush(vm);
+}
+
+void vm_ring_set_notify(VM *vm, VMRingNotifyFn notify, void *data) {
+    vring_set_notify(vm, notify, data);
+}
+
+int vm_ring_send(VM *vm, const void *data, uint16_t len) {
+    return vring_send(vm, data, len);
+}
+
+int vm_ring_receive(VM *vm, void *data, uint16_t size) {
+    return vring_receive(vm, data, size);
+}
+
+int vm_load_plugin(VM *vm, const char *path) {
+    if (!vm || !path) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+    return plugins_load(vm, path);
+}
+
+void *vm_get_user_data(VM *vm) {
+    return vm ? vm->user_data : NULL;
+}
@@ -2,11 +2,29 @@
 #include <stdlib.h>
 #include <string.h>
 #include <vm.h>
+#include "cpu.h"
+#include "memory.h"
 #include <decoder.h>
 #include <stdbool.h>
 #include "disassembler.h"
 #include <ctype.h>
 #include <debug.h>
+#include "io_manager.h"
+#include "files.h"
+#include "disk.h"
+#include "vring.h"
+#include "plugin.h"
+#include "clock.h"
+#include "channel.h"
+#include "console.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "profile.h"
+#include "stats.h"
+#include "coverage.h"
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 Breakpoint breakpoints[MAX_BREAKPOINTS];
 int breakpoint_count = 0;
@@ -14,6 +32,39 @@ int breakpoint_count = 0;
 // Default memory size for VM
 #define DEFAULT_MEMORY_SIZE (64 * 1024)  // 64KB
 
+// Programs chained after the main one with -c
+#define PIPELINE_MAX_STAGES 8
+
+// Settings from the command line
+typedef struct {
+    int memory_size;                        // Bytes
+    int debug_mode;                         // 1 = -d, 2 = -dd
+    int disassemble_mode;
+    int fast_interrupts;
+    int virtual_time;
+    int quiet;
+    char *sandbox_dir;
+    char *disk_image;
+    char *ring_socket;
+    int console_mmio;                       // Console window address, -1 = none
+    char *plugins[PLUGIN_MAX];
+    int plugin_count;
+    char *stages[PIPELINE_MAX_STAGES];      // Programs run after the main one
+    int stage_count;
+    char *output_file;
+    char *replay_log;
+    int replay_mode;                        // REPLAY_RECORD or REPLAY_PLAYBACK
+    char *snapshot_at;                      // Instruction count or label
+    char *snapshot_file;
+    char *restore_file;
+    char *profile_file;
+    int profile_interval;                   // 0 = PROFILE_DEFAULT_INTERVAL
+    char *stats_file;
+    char *coverage_bits;
+    char *coverage_info;
+    char *program_file;
+} VMOptions;
+
 void print_usage(const char *program_name) {
     printf("Usage: %s [options] [program_file]\n", program_name);
     printf("Options:\n");
@@ -21,24 +72,51 @@ void print_usage(const char *program_name) {
     printf("  -d            Enable debug mode\n");
     printf("  -dd           Enable extra verbose debug mode\n");
     printf("  -D            Disassemble program file instead of running it\n");
+    printf("  -f            Fast interrupts (save context in shadow registers)\n");
+    printf("  -t            Virtual time: clock follows instructions, sleep returns at once\n");
+    printf("  -s DIR        Sandbox directory for guest files (default: current)\n");
+    printf("  -i IMAGE      Attach IMAGE as the block disk device\n");
+    printf("  -u SOCKET     Bridge the ring device to a Unix socket at SOCKET\n");
+    printf("  -M ADDR       Also map the console ports into memory at ADDR (memory-mapped I/O)\n");
+    printf("  -p PLUGIN     Load a native plugin shared object (repeatable)\n");
+    printf("  -c PROGRAM    Run PROGRAM on its own thread, fed by the previous program's\n");
+    printf("                channel output (repeatable, builds a pipeline)\n");
+    printf("  -o FILE       Write guest console output to FILE instead of stdout\n");
+    printf("  -q            Quiet: no loader or runtime messages, only guest output\n");
+    printf("  -r LOG        Record host inputs (clock, console, files, channels) to LOG\n");
+    printf("  -R LOG        Replay a run recorded with -r, without touching the host\n");
+    printf("  -S AT FILE    Run to AT (an instruction count or a label), save a snapshot\n");
+    printf("                to FILE and stop\n");
+    printf("  -L FILE       Resume from a snapshot saved with -S instead of loading a program\n");
+    printf("  -P FILE       Profile: sample the guest and write folded stacks to FILE\n");
+    printf("  -e N          Profile sample interval in instructions (default: %d)\n",
+           PROFILE_DEFAULT_INTERVAL);
+    printf("  -x FILE       Count instructions by opcode, mode, branch, segment and syscall,\n");
+    printf("                with host time per opcode; log tables and write JSON to FILE\n");
+    printf("  -C BITS INFO  Code coverage: merge executed addresses into the bitmap BITS\n");
+    printf("                (kept across runs) and write it as an lcov tracefile INFO\n");
     printf("  -h            Show this help message\n");
     printf("\nExamples:\n");
     printf("  %s program.bin         Run program.bin with default settings\n", program_name);
     printf("  %s -m 128 program.bin  Run with 128KB memory\n", program_name);
     printf("  %s -d program.bin      Run in debug mode\n", program_name);
     printf("  %s -D program.bin      Disassemble program.bin\n", program_name);
+    printf("  %s -S main warm.vms program.bin  Snapshot program.bin at label main\n", program_name);
+    printf("  %s -L warm.vms         Continue from the snapshot\n", program_name);
+    printf("  %s -P out.folded program.bin  Profile program.bin (flamegraph.pl out.folded)\n", program_name);
+    printf("  %s -x stats.json program.bin  Execution statistics for program.bin\n", program_name);
+    printf("  %s -C tests.cov tests.info test1.bin  Add test1.bin's coverage to tests.cov\n", program_name);
 }
 
 // Parse command line arguments
-int parse_arguments(int argc, char *argv[], int *memory_size, int *debug_mode, 
-    int *disassemble_mode, char **program_file) {
+int parse_arguments(int argc, char *argv[], VMOptions *options) {
     int i;
 
     // Set defaults
-    *memory_size = DEFAULT_MEMORY_SIZE;
-    *debug_mode = 0;
-    *disassemble_mode = 0;
-    *program_file = NULL;
+    memset(options, 0, sizeof(*options));
+    options->memory_size = DEFAULT_MEMORY_SIZE;
+    options->console_mmio = -1;
+    options->replay_mode = REPLAY_OFF;
 
     for (i = 1; i < argc; i++) {
         if (argv[i][0] == '-') {
@@ -52,7 +130,7 @@ int parse_arguments(int argc, char *argv[], int *memory_size, int *debug_mode,
                             fprintf(stderr, "Error: Invalid memory size\n");
                             return 0;
                         }
-                        *memory_size = size * 1024;  // Convert KB to bytes
+                        options->memory_size = size * 1024;  // Convert KB to bytes
                         i++;
                     } else {
                         fprintf(stderr, "Error: Missing memory size value\n");
@@ -62,15 +140,201 @@ int parse_arguments(int argc, char *argv[], int *memory_size, int *debug_mode,
                     
                 case 'd':
                     // Debug mode
-                    *debug_mode = 1;
+                    options->debug_mode = 1;
                     if (argv[i][2] == 'd') {
-                        *debug_mode = 2;
+                        options->debug_mode = 2;
                     }
                     break;
                     
                 case 'D':
                     // Disassemble mode
-                    *disassemble_mode = 1;
+                    options->disassemble_mode = 1;
+                    break;
+                    
+                case 'f':
+                    // Fast interrupt entry
+                    options->fast_interrupts = 1;
+                    break;
+                    
+                case 't':
+                    // Virtual time
+                    options->virtual_time = 1;
+                    break;
+                    
+                case 's':
+                    // Sandbox directory for guest files
+                    if (i + 1 < argc) {
+                        options->sandbox_dir = argv[i + 1];
+                        i++;
+                    } else {
+                        fprintf(stderr, "Error: Missing sandbox directory\n");
+                        return 0;
+                    }
+                    break;
+                    
+                case 'i':
+                    // Disk image
+                    if (i + 1 < argc) {
+                        options->disk_image = argv[i + 1];
+                        i++;
+                    } else {
+                        fprintf(stderr, "Error: Missing disk image\n");
+                        return 0;
+                    }
+                    break;
+                    
+                case 'u':
+                    // Ring device socket bridge
+                    if (i + 1 < argc) {
+                        options->ring_socket = argv[i + 1];
+                        i++;
+                    } else {
+                        fprintf(stderr, "Error: Missing socket path\n");
+                        return 0;
+                    }
+                    break;
+                    
+                case 'M':
+                    // Console window in guest memory
+                    if (i + 1 < argc) {
+                        char *end;
+                        unsigned long address = strtoul(argv[i + 1], &end, 0);
+                        if (*end != '\0' || address > 0xFFFF) {
+                            fprintf(stderr, "Error: Invalid console address\n");
+                            return 0;
+                        }
+                        options->console_mmio = (int)address;
+                        i++;
+                    } else {
+                        fprintf(stderr, "Error: Missing console address\n");
+                        return 0;
+                    }
+                    break;
+                    
+                case 'p':
+                    // Native plugin
+                    if (i + 1 >= argc) {
+                        fprintf(stderr, "Error: Missing plugin path\n");
+                        return 0;
+                    }
+                    if (options->plugin_count >= PLUGIN_MAX) {
+                        fprintf(stderr, "Error: Too many plugins (maximum %d)\n", PLUGIN_MAX);
+                        return 0;
+                    }
+                    options->plugins[options->plugin_count++] = argv[i + 1];
+                    i++;
+                    break;
+                    
+                case 'c':
+                    // Next pipeline stage
+                    if (i + 1 >= argc) {
+                        fprintf(stderr, "Error: Missing pipeline program\n");
+                        return 0;
+                    }
+                    if (options->stage_count >= PIPELINE_MAX_STAGES) {
+                        fprintf(stderr, "Error: Too many pipeline stages (maximum %d)\n", PIPELINE_MAX_STAGES);
+                        return 0;
+                    }
+                    options->stages[options->stage_count++] = argv[i + 1];
+                    i++;
+                    break;
+                    
+                case 'o':
+                    // Guest output file
+                    if (i + 1 < argc) {
+                        options->output_file = argv[i + 1];
+                        i++;
+                    } else {
+                        fprintf(stderr, "Error: Missing output file\n");
+                        return 0;
+                    }
+                    break;
+                    
+                case 'q':
+                    // Quiet
+                    options->quiet = 1;
+                    break;
+                    
+                case 'r':
+                case 'R':
+                    // Record or replay log
+                    if (i + 1 >= argc) {
+                        fprintf(stderr, "Error: Missing replay log\n");
+                        return 0;
+                    }
+                    options->replay_log = argv[i + 1];
+                    options->replay_mode = argv[i][1] == 'r' ? REPLAY_RECORD : REPLAY_PLAYBACK;
+                    i++;
+                    break;
+                    
+                case 'S':
+                    // Snapshot point and file
+                    if (i + 2 >= argc) {
+                        fprintf(stderr, "Error: -S needs a point and a snapshot file\n");
+                        return 0;
+                    }
+                    options->snapshot_at = argv[i + 1];
+                    options->snapshot_file = argv[i + 2];
+                    i += 2;
+                    break;
+                    
+                case 'L':
+                    // Snapshot to resume from
+                    if (i + 1 < argc) {
+                        options->restore_file = argv[i + 1];
+                        i++;
+                    } else {
+                        fprintf(stderr, "Error: Missing snapshot file\n");
+                        return 0;
+                    }
+                    break;
+                    
+                case 'P':
+                    // Profile output
+                    if (i + 1 < argc) {
+                        options->profile_file = argv[i + 1];
+                        i++;
+                    } else {
+                        fprintf(stderr, "Error: Missing profile file\n");
+                        return 0;
+                    }
+                    break;
+                    
+                case 'e':
+                    // Profile sample interval
+                    if (i + 1 < argc) {
+                        options->profile_interval = atoi(argv[i + 1]);
+                        if (options->profile_interval <= 0) {
+                            fprintf(stderr, "Error: Invalid sample interval\n");
+                            return 0;
+                        }
+                        i++;
+                    } else {
+                        fprintf(stderr, "Error: Missing sample interval\n");
+                        return 0;
+                    }
+                    break;
+                    
+                case 'x':
+                    // Execution statistics
+                    if (i + 1 < argc) {
+                        options->stats_file = argv[i + 1];
+                        i++;
+                    } else {
+                        fprintf(stderr, "Error: Missing statistics file\n");
+                        return 0;
+                    }
+                    break;
+                    
+                case 'C':
+                    // Coverage bitmap and tracefile
+                    if (i + 2 >= argc) {
+                        fprintf(stderr, "Error: -C needs a bitmap file and an lcov file\n");
+                        return 0;
+                    }
+                    options->coverage_bits = argv[i + 1];
+                    options->coverage_info = argv[i + 2];
+                    i += 2;
                     break;
                     
                 case 'h':
@@ -85,8 +349,8 @@ int parse_arguments(int argc, char *argv[], int *memory_size, int *debug_mode,
             }
         } else {
         // Program file
-            if (*program_file == NULL) {
-                *program_file = argv[i];
+            if (options->program_file == NULL) {
+                options->program_file = argv[i];
             } else {
                 fprintf(stderr, "Error: Multiple program files specified\n");
                 return 0;
@@ -519,7 +783,11 @@ void debug_execution(VM *vm) {
         }
         
         // Process command
-        if (strncmp(cmd, "s", 1) == 0 || strncmp(cmd, "step", 4) == 0) {
+        if (strcmp(cmd, "sc") == 0 || strcmp(cmd, "syscalls") == 0) {
+            // Syscall statistics (checked before the "s" prefix of step)
+            syscalls_print_stats(vm, stdout);
+        }
+        else if (strncmp(cmd, "s", 1) == 0 || strncmp(cmd, "step", 4) == 0) {
             // Step N instructions
             int count = 1;
             sscanf(cmd + 1, "%d", &count);
@@ -650,6 +918,7 @@ void debug_execution(VM *vm) {
             printf("  ls, list-symbols- List all symbols\n");
             printf("  m, memory ADDR N- Dump N bytes of memory at ADDR\n");
             printf("  r, registers    - Show register values\n");
+            printf("  sc, syscalls    - Show syscall counts and latency\n");
             printf("  q, quit         - Quit debugger\n");
             printf("  h, help         - Show this help\n");
         }
@@ -659,89 +928,498 @@ void debug_execution(VM *vm) {
     }
 }
 
+// A pipeline stage after the main program, run on its own thread
+typedef struct {
+    const char *program_file;
+    VM vm;
+    pthread_t thread;
+    int started;
+    int result;
+} PipelineStage;
+
+// Create the stage VMs, load their programs and connect each one's channel
+// input to the output of the VM before it. Stages share the memory size,
+// -f, -t, -s, -o and -q settings of the main program.
+int pipeline_setup(VM *first, PipelineStage *stages, const VMOptions *options, int output_fd) {
+    for (int i = 0; i < options->stage_count; i++) {
+        PipelineStage *stage = &stages[i];
+        VM *previous = (i == 0) ? first : &stages[i - 1].vm;
+        char *program = options->stages[i];
+        int result;
+
+        stage->program_file = program;
+        stage->started = 0;
+        stage->result = VM_ERROR_NONE;
+
+        result = vm_init(&stage->vm, options->memory_size);
+        if (result != VM_ERROR_NONE) {
+            fprintf(stderr, "Failed to initialize VM for '%s': %s\n",
+                    program, vm_get_error_string(result));
+            while (--i >= 0) {
+                vm_cleanup(&stages[i].vm);
+            }
+            return result;
+        }
+
+        stage->vm.fast_interrupts = options->fast_interrupts;
+        if (options->virtual_time) {
+            clock_init(&stage->vm, CLOCK_MODE_VIRTUAL);
+        }
+        if (options->quiet) {
+            vm_set_log(&stage->vm, NULL);
+        }
+
+        result = options->sandbox_dir ? files_set_root(&stage->vm, options->sandbox_dir) : VM_ERROR_NONE;
+        if (result == VM_ERROR_NONE && output_fd >= 0) {
+            result = console_set_output_fd(&stage->vm, output_fd);
+        }
+        if (result == VM_ERROR_NONE) {
+            result = vm_load_program_file(&stage->vm, program);
+        }
+        if (result == VM_ERROR_NONE) {
+            result = channel_connect(previous, &stage->vm, 0);
+            if (result != VM_ERROR_NONE) {
+                // channel_connect reports on the writer
+                snprintf(stage->vm.error_message, sizeof(stage->vm.error_message),
+                         "%s", vm_get_error_message(previous));
+            }
+        }
+        if (result != VM_ERROR_NONE) {
+            fprintf(stderr, "Failed to load program '%s': %s\n",
+                    program, vm_get_error_message(&stage->vm));
+            while (i >= 0) {
+                vm_cleanup(&stages[i--].vm);
+            }
+            return result;
+        }
+    }
+
+    return VM_ERROR_NONE;
+}
+
+// Stage thread: run to completion, then clean up so the neighbours see the
+// channels close
+void *pipeline_stage_run(void *arg) {
+    PipelineStage *stage = (PipelineStage *)arg;
+
+    stage->result = vm_run(&stage->vm);
+    if (stage->result != VM_ERROR_NONE) {
+        fprintf(stderr, "VM error in '%s': %s (PC=0x%04X, after %u instructions)\n",
+                stage->program_file, vm_get_error_message(&stage->vm),
+                stage->vm.error_pc, stage->vm.instruction_count);
+    }
+
+    vm_cleanup(&stage->vm);
+    return NULL;
+}
+
+void pipeline_start(PipelineStage *stages, int count) {
+    for (int i = 0; i < count; i++) {
+        if (pthread_create(&stages[i].thread, NULL, pipeline_stage_run, &stages[i]) == 0) {
+            stages[i].started = 1;
+        } else {
+            // Can't run it; cleaning up closes its channels so the others finish
+            fprintf(stderr, "Failed to start thread for '%s'\n", stages[i].program_file);
+            stages[i].result = VM_ERROR_IO_ERROR;
+            vm_cleanup(&stages[i].vm);
+        }
+    }
+}
+
+// Wait for all stages; returns 0 if every stage completed without error
+int pipeline_join(PipelineStage *stages, int count) {
+    int failed = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (stages[i].started) {
+            pthread_join(stages[i].thread, NULL);
+        }
+        if (stages[i].result != VM_ERROR_NONE) {
+            failed = 1;
+        }
+    }
+    return failed;
+}
+
+// Reject option combinations that can't work together; returns 1 if the
+// options are usable
+int check_options(const VMOptions *options, const char *program_name) {
+    // Check if program file is specified; a snapshot replaces it
+    if (options->program_file == NULL && options->restore_file == NULL) {
+        fprintf(stderr, "Error: No program file specified\n");
+        print_usage(program_name);
+        return 0;
+    }
+    if (options->program_file && options->restore_file) {
+        fprintf(stderr, "Error: -L resumes a snapshot and takes no program file\n");
+        return 0;
+    }
+    
+    // A snapshot holds one VM, taken from a fresh program run
+    if ((options->snapshot_file || options->restore_file) && options->stage_count > 0) {
+        fprintf(stderr, "Error: -S and -L cannot be combined with -c\n");
+        return 0;
+    }
+    if (options->snapshot_file && options->restore_file) {
+        fprintf(stderr, "Error: -S and -L cannot be combined\n");
+        return 0;
+    }
+    if (options->snapshot_file && (options->profile_file || options->stats_file || options->coverage_bits)) {
+        fprintf(stderr, "Error: -S cannot be combined with -P, -x or -C\n");
+        return 0;
+    }
+    
+    // A log holds one VM's inputs
+    if (options->replay_log && options->stage_count > 0) {
+        fprintf(stderr, "Error: -r and -R cannot be combined with -c\n");
+        return 0;
+    }
+    
+    return 1;
+}
+
+// Apply the options to the main VM and attach the devices they ask for.
+// Errors are reported here; the caller cleans up the VM.
+int setup_vm(VM *vm, const VMOptions *options, int output_fd) {
+    int result;
+    
+    // Loader and runtime messages go to the VM log, which -q silences
+    if (options->quiet) {
+        vm_set_log(vm, NULL);
+    }
+    vm_log(vm, "Initializing VM with %d KB memory...\n", options->memory_size / 1024);
+    
+    // Send guest output to a file
+    if (output_fd >= 0) {
+        console_set_output_fd(vm, output_fd);
+    }
+    
+    // Only the main program reads stdin; pipeline stages have no input
+    console_set_input_fd(vm, STDIN_FILENO);
+    
+    // Set debug mode if requested
+    vm->debug_mode = options->debug_mode;
+    vm->fast_interrupts = options->fast_interrupts;
+    if (options->virtual_time) {
+        clock_init(vm, CLOCK_MODE_VIRTUAL);
+    }
+    
+    // Record or replay host inputs; playback also restores the clock mode.
+    // Start before the devices below, which take host input from the start.
+    if (options->replay_log) {
+        result = replay_start(vm, options->replay_log, options->replay_mode);
+        if (result != VM_ERROR_NONE) {
+            fprintf(stderr, "%s\n", vm_get_error_message(vm));
+            return result;
+        }
+    }
+    
+    // Confine guest file access
+    if (options->sandbox_dir) {
+        result = files_set_root(vm, options->sandbox_dir);
+        if (result != VM_ERROR_NONE) {
+            fprintf(stderr, "%s\n", vm_get_error_message(vm));
+            return result;
+        }
+    }
+    
+    // Attach the disk image
+    if (options->disk_image) {
+        result = io_attach_disk(vm, IO_PORT_DISK, options->disk_image);
+        if (result != VM_ERROR_NONE) {
+            fprintf(stderr, "%s\n", vm_get_error_message(vm));
+            return result;
+        }
+    }
+    
+    // Connect the ring device to a socket
+    if (options->ring_socket) {
+        result = vring_bridge_open(vm, options->ring_socket);
+        if (result != VM_ERROR_NONE) {
+            fprintf(stderr, "%s\n", vm_get_error_message(vm));
+            return result;
+        }
+    }
+    
+    // Give the console a window in guest memory as well as its ports
+    if (options->console_mmio >= 0) {
+        result = console_map_mmio(vm, (uint16_t)options->console_mmio);
+        if (result != VM_ERROR_NONE) {
+            fprintf(stderr, "Error: Cannot map the console at 0x%04X\n", options->console_mmio);
+            return result;
+        }
+    }
+    
+    // Load native plugins; they bind their functions to syscalls
+    for (int i = 0; i < options->plugin_count; i++) {
+        result = plugins_load(vm, options->plugins[i]);
+        if (result != VM_ERROR_NONE) {
+            fprintf(stderr, "%s\n", vm_get_error_message(vm));
+            return result;
+        }
+    }
+    
+    return VM_ERROR_NONE;
+}
+
+// Resume from a snapshot, or load the program
+int load_program(VM *vm, const VMOptions *options) {
+    int result;
+    
+    if (options->restore_file) {
+        vm_log(vm, "Restoring snapshot '%s'...\n", options->restore_file);
+        result = snapshot_restore(vm, options->restore_file);
+        if (result != VM_ERROR_NONE) {
+            fprintf(stderr, "Failed to restore snapshot: %s\n", vm_get_error_message(vm));
+            return result;
+        }
+        vm_log(vm, "Snapshot restored at instruction %u, PC 0x%04X\n",
+               vm->instruction_count, vm->registers[R3_PC]);
+        return VM_ERROR_NONE;
+    }
+    
+    // A snapshot point given as a label, profile frames and coverage
+    // lines need the symbol table
+    vm->load_symbols = options->snapshot_at != NULL || options->profile_file != NULL ||
+                       options->coverage_bits != NULL;
+    vm_log(vm, "Loading program '%s'...\n", options->program_file);
+    result = vm_load_program_file(vm, options->program_file);
+    if (options->debug_mode || !vm->load_symbols) {
+        // Symbols loaded only to resolve labels and frames aren't dumped
+        debug_print_source_info(vm);
+        debug_dump_source_mapping(vm);
+    }
+    if (result != VM_ERROR_NONE) {
+        fprintf(stderr, "Failed to load program: %s\n", vm_get_error_message(vm));
+        return result;
+    }
+    
+    vm_log(vm, "Program loaded, starting at 0x%04X\n", vm->registers[R3_PC]);
+    return VM_ERROR_NONE;
+}
+
+// Run to the snapshot point and save the snapshot there
+int run_to_snapshot(VM *vm, const VMOptions *options) {
+    const char *at = options->snapshot_at;
+    int64_t count = -1;
+    int32_t address = -1;
+    char *end;
+    unsigned long value = strtoul(at, &end, 0);
+    int result;
+    
+    if (*at != '\0' && *end == '\0') {
+        count = (int64_t)value;
+    } else {
+        Symbol *symbol = find_symbol_by_name(vm, at);
+        if (!symbol) {
+            fprintf(stderr, "Error: Snapshot point '%s' is neither a count nor a label\n", at);
+            return VM_ERROR_INVALID_ADDRESS;
+        }
+        address = (int32_t)symbol->address;
+    }
+    
+    vm_log(vm, "Running to snapshot point '%s'...\n", at);
+    result = vm_run_until(vm, count, address);
+    if (result == VM_ERROR_NONE && vm->halted) {
+        fprintf(stderr, "Error: Program halted after %u instructions, before reaching '%s'\n",
+                vm->instruction_count, at);
+        return VM_ERROR_INVALID_ADDRESS;
+    } else if (result != VM_ERROR_NONE) {
+        fprintf(stderr, "VM error: %s\n", vm_get_error_message(vm));
+        return result;
+    }
+    
+    result = snapshot_save(vm, options->snapshot_file);
+    if (result != VM_ERROR_NONE) {
+        fprintf(stderr, "%s\n", vm_get_error_message(vm));
+    } else {
+        vm_log(vm, "Snapshot saved to '%s' at instruction %u, PC 0x%04X\n",
+               options->snapshot_file, vm->instruction_count, vm->registers[R3_PC]);
+    }
+    return result;
+}
+
+// Start the profiler, coverage and statistics asked for; they record the
+// run from here on
+int start_reports(VM *vm, const VMOptions *options) {
+    int result = VM_ERROR_NONE;
+    
+    if (options->profile_file) {
+        result = profile_start(vm, (uint32_t)options->profile_interval);
+    }
+    if (result == VM_ERROR_NONE && options->coverage_bits) {
+        result = coverage_start(vm);
+    }
+    if (result == VM_ERROR_NONE && options->stats_file) {
+        result = stats_start(vm);
+    }
+    
+    if (result != VM_ERROR_NONE) {
+        fprintf(stderr, "%s\n", vm_get_error_message(vm));
+    }
+    return result;
+}
+
+// Write the profile, statistics and coverage of the run, and log their tables
+void write_reports(VM *vm, const VMOptions *options) {
+    if (options->profile_file) {
+        if (profile_write_folded(vm, options->profile_file) != VM_ERROR_NONE) {
+            fprintf(stderr, "%s\n", vm_get_error_message(vm));
+        } else {
+            vm_log(vm, "Profile written to '%s'\n", options->profile_file);
+        }
+        profile_report(vm, PROFILE_TOP);
+    }
+
+    if (options->stats_file) {
+        if (stats_write_json(vm, options->stats_file) != VM_ERROR_NONE) {
+            fprintf(stderr, "%s\n", vm_get_error_message(vm));
+        } else {
+            vm_log(vm, "Statistics written to '%s'\n", options->stats_file);
+        }
+        stats_report(vm);
+    }
+
+    if (options->coverage_bits) {
+        uint64_t bits[COVERAGE_WORDS];
+        memset(bits, 0, sizeof(bits));
+        coverage_merge(vm, bits);
+        if (coverage_merge_file(vm, options->coverage_bits, bits) != VM_ERROR_NONE ||
+            coverage_write_lcov(vm, options->coverage_info, bits) != VM_ERROR_NONE) {
+            fprintf(stderr, "%s\n", vm_get_error_message(vm));
+        } else {
+            vm_log(vm, "Coverage merged into '%s' and written to '%s'\n",
+                   options->coverage_bits, options->coverage_info);
+        }
+    }
+}
+
+// Run the main program to completion (or under the debugger) and write the
+// reports; a fault is reported with the failing instruction
+int run_program(VM *vm, const VMOptions *options) {
+    if (options->debug_mode) {
+        // Run in debug mode
+        debug_execution(vm);
+        write_reports(vm, options);
+        return VM_ERROR_NONE;
+    }
+    
+    // Run until halted
+    vm_log(vm, "Running program...\n");
+    int result = vm_run(vm);
+    if (result != VM_ERROR_NONE) {
+        fprintf(stderr, "VM error: %s\n", vm_get_error_message(vm));
+        fprintf(stderr, "Program terminated after %u instructions\n", vm->instruction_count);
+        
+        // Use the saved error PC
+        uint16_t error_pc = vm->error_pc;
+        
+        // Decode and display the instruction
+        Instruction instr;
+        if (vm_decode_instruction(vm, error_pc, &instr) == VM_ERROR_NONE) {
+            char disasm[256];
+            vm_disassemble_instruction(vm, &instr, disasm, sizeof(disasm));
+            fprintf(stderr, "Error occurred at PC=0x%04X, instruction: %s\n", error_pc, disasm);
+        }
+    } else {
+        vm_log(vm, "Program completed after %u instructions\n", vm->instruction_count);
+    }
+    
+    write_reports(vm, options);
+    return result;
+}
+
+// Report disk throughput
+void report_disk(VM *vm) {
+    DiskStats disk_stats;
+    if (disk_get_stats(vm, &disk_stats) && disk_stats.elapsed_seconds > 0) {
+        uint64_t sectors = disk_stats.sectors_read + disk_stats.sectors_written;
+        vm_log(vm, "Disk: %llu sectors read, %llu written, %llu flushes, %.0f sectors/sec\n",
+               (unsigned long long)disk_stats.sectors_read,
+               (unsigned long long)disk_stats.sectors_written,
+               (unsigned long long)disk_stats.flushes,
+               sectors / disk_stats.elapsed_seconds);
+    }
+}
+
+// Clean up the main VM (this closes its channel, so the stages can finish),
+// wait for the stages and close the output file. Returns the exit status.
+int finish(VM *vm, PipelineStage *stages, int stage_count, int output_fd, int failed) {
+    vm_cleanup(vm);
+    
+    if (pipeline_join(stages, stage_count)) {
+        failed = 1;
+    }
+    if (output_fd >= 0) {
+        close(output_fd);
+    }
+    return failed ? 1 : 0;
+}
+
 // Main function
 int main(int argc, char *argv[]) {
-    int memory_size;
-    int debug_mode;
-    int disassemble_mode;
-    char *program_file;
+    VMOptions options;
+    PipelineStage stages[PIPELINE_MAX_STAGES];
+    int output_fd = -1;
     VM vm;
     int result;
     
     // Parse command line arguments
-    if (!parse_arguments(argc, argv, &memory_size, &debug_mode, &disassemble_mode, &program_file)) {
+    if (!parse_arguments(argc, argv, &options) || !check_options(&options, argv[0])) {
         return 1;
     }
     
-    // Check if program file is specified
-    if (program_file == NULL) {
-        fprintf(stderr, "Error: No program file specified\n");
-        print_usage(argv[0]);
-        return 1;
+    // Handle disassemble mode
+    if (options.disassemble_mode && options.program_file) {
+        printf("Disassembling '%s'...\n", options.program_file);
+        return disassemble_file(options.program_file);
     }
     
-    // Handle disassemble mode
-    if (disassemble_mode) {
-        printf("Disassembling '%s'...\n", program_file);
-        return disassemble_file(program_file);
+    // Guest output file, shared with the pipeline stages
+    if (options.output_file) {
+        output_fd = open(options.output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (output_fd < 0) {
+            fprintf(stderr, "Error: Cannot open output file '%s'\n", options.output_file);
+            return 1;
+        }
     }
     
     // Initialize VM
-    printf("Initializing VM with %d KB memory...\n", memory_size / 1024);
-    result = vm_init(&vm, memory_size);
+    result = vm_init(&vm, options.memory_size);
     if (result != VM_ERROR_NONE) {
         fprintf(stderr, "Failed to initialize VM: %s\n", vm_get_error_string(result));
+        if (output_fd >= 0) {
+            close(output_fd);
+        }
         return 1;
     }
     
-    // Set debug mode if requested
-    vm.debug_mode = debug_mode;
+    if (setup_vm(&vm, &options, output_fd) != VM_ERROR_NONE ||
+        load_program(&vm, &options) != VM_ERROR_NONE) {
+        return finish(&vm, stages, 0, output_fd, 1);
+    }
     
-    // Load program
-    printf("Loading program '%s'...\n", program_file);
-    result = vm_load_program_file(&vm, program_file);
-    debug_print_source_info(&vm);
-    debug_dump_source_mapping(&vm);
-    if (result != VM_ERROR_NONE) {
-        fprintf(stderr, "Failed to load program: %s\n", vm_get_error_message(&vm));
-        vm_cleanup(&vm);
-        return 1;
+    // Run to the snapshot point, save and stop
+    if (options.snapshot_file) {
+        result = run_to_snapshot(&vm, &options);
+        return finish(&vm, stages, 0, output_fd, result != VM_ERROR_NONE);
     }
     
-    printf("Program loaded, starting at 0x%04X\n", vm.registers[R3_PC]);
+    if (start_reports(&vm, &options) != VM_ERROR_NONE) {
+        return finish(&vm, stages, 0, output_fd, 1);
+    }
     
-    // Execute program
-    if (debug_mode) {
-        // Run in debug mode
-        debug_execution(&vm);
-    } else {
-        // Run until halted
-        printf("Running program...\n");
-        result = vm_run(&vm);
-        if (result != VM_ERROR_NONE) {
-            fprintf(stderr, "VM error: %s\n", vm_get_error_message(&vm));
-            fprintf(stderr, "Program terminated after %u instructions\n", vm.instruction_count);
-            
-            // Use the saved error PC
-            uint16_t error_pc = vm.error_pc;
-            
-            // Decode and display the instruction
-            Instruction instr;
-            if (vm_decode_instruction(&vm, error_pc, &instr) == VM_ERROR_NONE) {
-                char disasm[256];
-                vm_disassemble_instruction(&vm, &instr, disasm, sizeof(disasm));
-                fprintf(stderr, "Error occurred at PC=0x%04X, instruction: %s\n", error_pc, disasm);
-            }
-            
-            vm_cleanup(&vm);
-            return 1;
+    // Chain the pipeline stages to this program's channel output
+    if (options.stage_count > 0) {
+        if (pipeline_setup(&vm, stages, &options, output_fd) != VM_ERROR_NONE) {
+            return finish(&vm, stages, 0, output_fd, 1);
         }
-        
-        printf("Program completed after %u instructions\n", vm.instruction_count);
+        pipeline_start(stages, options.stage_count);
     }
     
-    // Clean up
-    vm_cleanup(&vm);
-    
-    return 0;
-}
\ No newline at end of file
+    result = run_program(&vm, &options);
+    if (result == VM_ERROR_NONE) {
+        report_disk(&vm);
+    }
+    return finish(&vm, stages, options.stage_count, output_fd, result != VM_ERROR_NONE);
+}
@@ -0,0 +1,74 @@
+#include <string.h>
+#include "random.h"
+
+static inline uint64_t random_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// splitmix64 spreads even small or similar seeds over the whole state
+void random_seed(uint64_t *state, uint64_t seed) {
+    for (int i = 0; i < RANDOM_STATE_WORDS; i++) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        state[i] = z ^ (z >> 31);
+    }
+}
+
+uint64_t random_next(uint64_t *state) {
+    uint64_t result = random_rotl(state[1] * 5, 7) * 9;
+    uint64_t t = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = random_rotl(state[3], 45);
+
+    return result;
+}
+
+// Lemire's multiply-and-reject method: one multiply in the common case
+uint32_t random_below(uint64_t *state, uint32_t bound) {
+    if (bound == 0) {
+        return (uint32_t)(random_next(state) >> 32);
+    }
+
+    uint64_t product = (random_next(state) >> 32) * bound;
+    uint32_t low = (uint32_t)product;
+    if (low < bound) {
+        uint32_t threshold = (uint32_t)(-bound) % bound;
+        while (low < threshold) {
+            product = (random_next(state) >> 32) * bound;
+            low = (uint32_t)product;
+        }
+    }
+    return (uint32_t)(product >> 32);
+}
+
+void random_fill(uint64_t *state, uint8_t *buffer, size_t size) {
+    // Keep the state in locals so the loop body stays in registers
+    uint64_t s0 = state[0], s1 = state[1], s2 = state[2], s3 = state[3];
+
+    while (size > 0) {
+        uint64_t value = random_rotl(s1 * 5, 7) * 9;
+        uint64_t t = s1 << 17;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = random_rotl(s3, 45);
+
+        size_t count = size < sizeof(value) ? size : sizeof(value);
+        memcpy(buffer, &value, count);
+        buffer += count;
+        size -= count;
+    }
+
+    state[0] = s0;
+    state[1] = s1;
+    state[2] = s2;
+    state[3] = s3;
+}
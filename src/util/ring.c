@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <string.h>
+#include "vm_types.h"
+#include "ring.h"
+
+// Initialize a ring; capacity is rounded up to a power of two
+int ring_init(Ring *ring, uint32_t capacity) {
+    if (!ring || capacity == 0 || capacity > 0x80000000u) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+
+    uint32_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    ring->buffer = (uint8_t *)malloc(size);
+    if (!ring->buffer) {
+        return VM_ERROR_MEMORY_ALLOCATION;
+    }
+
+    ring->capacity = size;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    return VM_ERROR_NONE;
+}
+
+void ring_free(Ring *ring) {
+    if (!ring) {
+        return;
+    }
+
+    free(ring->buffer);
+    ring->buffer = NULL;
+    ring->capacity = 0;
+}
+
+uint32_t ring_used(Ring *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail;
+}
+
+uint32_t ring_write(Ring *ring, const uint8_t *data, uint32_t len) {
+    // Only the producer modifies head, so a relaxed load is enough
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t space = ring->capacity - (head - tail);
+
+    if (len > space) {
+        len = space;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    // Copy in at most two pieces around the wrap point
+    uint32_t offset = head & (ring->capacity - 1);
+    uint32_t first = ring->capacity - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(ring->buffer + offset, data, first);
+    memcpy(ring->buffer, data + first, len - first);
+
+    // Publish the bytes to the consumer
+    atomic_store_explicit(&ring->head, head + len, memory_order_seq_cst);
+    return len;
+}
+
+uint32_t ring_peek(Ring *ring, const uint8_t **data) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t used = head - tail;
+    uint32_t offset = tail & (ring->capacity - 1);
+    uint32_t contiguous = ring->capacity - offset;
+
+    *data = ring->buffer + offset;
+    return used < contiguous ? used : contiguous;
+}
+
+void ring_consume(Ring *ring, uint32_t len) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + len, memory_order_release);
+}
@@ -1,17 +1,47 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include "vm.h"
 #include "cpu.h"
 #include "memory.h"
 #include "debug.h"
+#include "events.h"
+#include "io_manager.h"
+#include "pic.h"
+#include "console.h"
+#include "files.h"
+#include "mmio.h"
+#include "vring.h"
+#include "plugin.h"
+#include "clock.h"
+#include "random.h"
+#include "replay.h"
+#include "hooks.h"
+#include "profile.h"
+#include "stats.h"
+#include "coverage.h"
 
 // Initialize the VM with the specified memory size
 int vm_init(VM *vm, uint32_t memory_size) {
-    if (!vm) {
+    return vm_init_with_allocator(vm, memory_size, NULL, NULL, NULL);
+}
+
+// Initialize the VM, taking guest memory from a host allocator
+int vm_init_with_allocator(VM *vm, uint32_t memory_size,
+                           void *(*alloc)(size_t size, void *data),
+                           void (*release)(void *ptr, void *data), void *data) {
+    if (!vm || (!alloc) != (!release)) {
         return VM_ERROR_INVALID_ADDRESS;
     }
     
+    // Start from a clean state so every subsystem sees zeroed fields
+    memset(vm, 0, sizeof(VM));
+    vm->log_stream = stdout;
+    vm->memory_alloc = alloc;
+    vm->memory_free = release;
+    vm->allocator_data = data;
+    
     // Initialize memory subsystem
     int result = memory_init(vm, memory_size);
     if (result != VM_ERROR_NONE) {
@@ -25,8 +55,47 @@ int vm_init(VM *vm, uint32_t memory_size) {
         return result;
     }
     
-    // Initialize I/O devices (if any)
-    vm->io_devices = NULL;  // No I/O devices by default
+    // Initialize the event queue used by devices for timed work
+    result = events_init(vm);
+    if (result != VM_ERROR_NONE) {
+        memory_cleanup(vm);
+        return result;
+    }
+    
+    // Every VM starts from the same random sequence until the guest seeds it
+    random_seed(vm->random_state, RANDOM_DEFAULT_SEED);
+    
+    // Start the guest clock in real time; main may switch it to virtual
+    clock_init(vm, CLOCK_MODE_REAL);
+    
+    // Initialize I/O devices
+    result = io_init(vm);
+    if (result != VM_ERROR_NONE) {
+        io_cleanup(vm);
+        events_cleanup(vm);
+        memory_cleanup(vm);
+        return result;
+    }
+    
+    // Initialize the guest file descriptor table
+    result = files_init(vm);
+    if (result != VM_ERROR_NONE) {
+        files_cleanup(vm);
+        io_cleanup(vm);
+        events_cleanup(vm);
+        memory_cleanup(vm);
+        return result;
+    }
+    
+    // Install the built-in syscalls
+    result = syscalls_init(vm);
+    if (result != VM_ERROR_NONE) {
+        files_cleanup(vm);
+        io_cleanup(vm);
+        events_cleanup(vm);
+        memory_cleanup(vm);
+        return result;
+    }
     
     // Clear error state
     vm->last_error = VM_ERROR_NONE;
@@ -44,14 +113,36 @@ void vm_cleanup(VM *vm) {
         return;
     }
     
-    // Free memory
+    // Stop the ring bridge while guest memory is still there to drain
+    vring_bridge_close(vm);
+    
+    // Close the replay log after the bridge's last exchange
+    replay_stop(vm);
+    
+    // The profiler's event and hooks go before the queue and hook table
+    profile_stop(vm);
+    stats_stop(vm);
+    coverage_stop(vm);
+    
+    // Close guest files
+    files_cleanup(vm);
+    
+    // Free I/O devices (devices may still cancel their events)
+    io_cleanup(vm);
+    
+    // Drop memory-mapped regions left by devices or the embedder
+    mmio_cleanup(vm);
+    
+    // Free guest memory once nothing that reads or writes it is left
     memory_cleanup(vm);
     
-    // Free I/O devices (if any)
-    if (vm->io_devices) {
-        free(vm->io_devices);
-        vm->io_devices = NULL;
-    }
+    // Free pending events
+    events_cleanup(vm);
+    
+    // Free the syscall table, then the plugins its entries may point into
+    syscalls_cleanup(vm);
+    plugins_unload(vm);
+    hooks_cleanup(vm);
 }
 
 // Reset the VM to initial state
@@ -66,15 +157,28 @@ int vm_reset(VM *vm) {
         return result;
     }
     
+    // Guest file handles do not survive a reset, and a log covers one run
+    files_close_all(vm);
+    replay_stop(vm);
+    
     // Clear memory (optional - this can be expensive)
     if (vm->memory) {
         memset(vm->memory, 0, vm->memory_size);
     }
     
+    // Devices drop their pending interrupts, timers and transfers
+    io_reset(vm);
+    
+    // Events that remain (profiler samples, console polls) keep their
+    // distance from the current instruction as the count restarts at 0
+    events_shift(vm, -vm->instruction_count);
+    
     // Reset VM state flags
     vm->halted = 0;
     vm->debug_mode = 0;
     vm->instruction_count = 0;
+    clock_init(vm, vm->clock_mode);
+    random_seed(vm->random_state, RANDOM_DEFAULT_SEED);
     
     // Clear error state
     vm->last_error = VM_ERROR_NONE;
@@ -83,6 +187,22 @@ int vm_reset(VM *vm) {
     return VM_ERROR_NONE;
 }
 
+// Single-instruction step of one of the engines
+typedef int (*VMStepFn)(VM *vm);
+
+static int vm_step_plain(VM *vm);
+static int vm_step_covered(VM *vm);
+static int vm_step_hooked(VM *vm);
+
+// Pick the engine once per run, so the plain one never checks for hooks
+// or coverage, and coverage alone keeps the plain interpreter
+static VMStepFn vm_engine(VM *vm) {
+    if (hooks_active(vm)) {
+        return vm_step_hooked;
+    }
+    return vm->coverage ? vm_step_covered : vm_step_plain;
+}
+
 // Run the VM until halted
 int vm_run(VM *vm) {
     if (!vm) {
@@ -90,13 +210,61 @@ int vm_run(VM *vm) {
     }
     
     // Execute instructions until halted or error
+    VMStepFn step = vm_engine(vm);
+    while (!vm->halted) {
+        int result = step(vm);
+        if (result != VM_ERROR_NONE) {
+            // Guest output must precede the host's error report
+            console_flush(vm);
+            return result;
+        }
+    }
+    
+    console_flush(vm);
+    return VM_ERROR_NONE;
+}
+
+// Run at most 'count' instructions; stops early when the program halts
+int vm_run_for(VM *vm, uint32_t count) {
+    if (!vm) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+    
+    VMStepFn step = vm_engine(vm);
+    for (uint32_t i = 0; i < count && !vm->halted; i++) {
+        int result = step(vm);
+        if (result != VM_ERROR_NONE) {
+            console_flush(vm);
+            return result;
+        }
+    }
+    
+    console_flush(vm);
+    return VM_ERROR_NONE;
+}
+
+// Run until halted, or stopped before the instruction at 'address' or once
+// 'count' instructions have run (-1 disables either stop)
+int vm_run_until(VM *vm, int64_t count, int32_t address) {
+    if (!vm) {
+        return VM_ERROR_INVALID_ADDRESS;
+    }
+    
+    VMStepFn step = vm_engine(vm);
     while (!vm->halted) {
-        int result = vm_step(vm);
+        if ((count >= 0 && vm->instruction_count >= (uint64_t)count) ||
+            (address >= 0 && vm->registers[R3_PC] == (uint32_t)address)) {
+            break;
+        }
+        
+        int result = step(vm);
         if (result != VM_ERROR_NONE) {
+            console_flush(vm);
             return result;
         }
     }
     
+    console_flush(vm);
     return VM_ERROR_NONE;
 }
 
@@ -105,11 +273,28 @@ int vm_step(VM *vm) {
         return VM_ERROR_INVALID_ADDRESS;
     }
     
+    return vm_engine(vm)(vm);
+}
+
+// Engine features, passed as constants so each engine's copy of
+// vm_step_engine keeps only its own checks
+#define VM_STEP_COVERAGE 1   // Set the coverage bit of every instruction
+#define VM_STEP_HOOKS    2   // Instruction hook and instrumented interpreter
+
+static inline __attribute__((always_inline)) int vm_step_engine(VM *vm, const int features) {
     // Check if VM is halted
     if (vm->halted) {
         return VM_ERROR_NONE;
     }
     
+    // Deliver a pending device interrupt at the instruction boundary
+    if (vm->irq_pending) {
+        pic_service(vm);
+        if (vm->last_error != VM_ERROR_NONE) {
+            return vm->last_error;
+        }
+    }
+    
     // Record the current PC (before execution)
     uint16_t current_pc = vm->registers[R3_PC];
     vm->error_pc = current_pc;
@@ -124,12 +309,23 @@ int vm_step(VM *vm) {
     // Save current instruction for debugging
     vm->current_instr = instr;
     
+    if (features & VM_STEP_COVERAGE) {
+        COVERAGE_MARK(vm->coverage, current_pc);
+    }
+    if (features & VM_STEP_HOOKS) {
+        hooks_instruction(vm, current_pc, &instr);
+    }
+    
     // IMPORTANT: Increment PC BEFORE executing the instruction
     // This is because some instructions (like CALL) rely on PC pointing to the next instruction
     vm->registers[R3_PC] += 4;
     
     // Execute instruction and get result
-    result = cpu_execute_instruction(vm, &instr);
+    if (features & VM_STEP_HOOKS) {
+        result = cpu_execute_instruction_hooked(vm, &instr);
+    } else {
+        result = cpu_execute_instruction(vm, &instr);
+    }
     
     // Check for errors
     if (result != VM_ERROR_NONE) {
@@ -141,9 +337,31 @@ int vm_step(VM *vm) {
     // Increment instruction count
     vm->instruction_count++;
     
+    // Run device events (timers etc.) whose deadline has been reached
+    if (EVENTS_DUE(vm)) {
+        events_dispatch(vm);
+        return vm->last_error;
+    }
+    
     return VM_ERROR_NONE;
 }
 
+static int vm_step_plain(VM *vm) {
+    return vm_step_engine(vm, 0);
+}
+
+// The plain interpreter plus one bit-set per instruction
+static int vm_step_covered(VM *vm) {
+    return vm_step_engine(vm, VM_STEP_COVERAGE);
+}
+
+// Coverage (if recording), the instruction hook and the instrumented
+// interpreter
+static int vm_step_hooked(VM *vm) {
+    return vm->coverage ? vm_step_engine(vm, VM_STEP_COVERAGE | VM_STEP_HOOKS)
+                        : vm_step_engine(vm, VM_STEP_HOOKS);
+}
+
 // Execute the current instruction pointed to by PC
 int vm_execute_instruction(VM *vm) {
     if (!vm) {
@@ -186,19 +404,27 @@ void vm_write_dword(VM *vm, uint16_t address, uint32_t value) {
     memory_write_dword(vm, address, value);
 }
 
-// I/O operations (placeholder implementations)
+// I/O operations
 int vm_io_read(VM *vm, uint16_t port) {
-    // Placeholder - implement I/O device reading
-    return 0;
+    return (int)io_read(vm, port);
 }
 
 void vm_io_write(VM *vm, uint16_t port, uint32_t value) {
-    // Placeholder - implement I/O device writing
-    
-    // Special case for console output
-    if (port == 0) {
-        printf("%c", (char)value);
+    io_write(vm, port, value);
+}
+
+// Guest memory access for host extensions
+uint8_t *vm_guest_ptr(VM *vm, uint16_t address, uint16_t size, uint8_t access) {
+    if (memory_check_address_permissions(vm, address, size, access) != VM_ERROR_NONE) {
+        return NULL;
     }
+    return &vm->memory[address];
+}
+
+// Host syscall registration
+int vm_register_syscall(VM *vm, uint16_t number, const char *name, uint8_t arg_count,
+                        uint8_t may_block, SyscallHandler handler) {
+    return syscalls_register(vm, number, name, arg_count, may_block, handler);
 }
 
 // Load a program into memory
@@ -266,7 +492,7 @@ int vm_load_program(VM *vm, const uint8_t *program, uint32_t size) {
         }
         
         // Load debug symbols if available
-        if (symbol_size > 0 && vm->debug_mode) {
+        if (symbol_size > 0 && (vm->debug_mode || vm->load_symbols)) {
             load_debug_symbols(vm, 
                               program + header_size + code_size + data_size, 
                               symbol_size);
@@ -337,9 +563,9 @@ int vm_load_program_file(VM *vm, const char *filename) {
         uint32_t data_size = *((uint32_t*)(header_buffer + 24));
         uint32_t symbol_size = *((uint32_t*)(header_buffer + 28));
         
-        printf("Loading optimized format binary (v%d.%d)\n", major_ver, minor_ver);
-        printf("  Code segment: 0x%04X - %d bytes\n", code_base, code_size);
-        printf("  Data segment: 0x%04X - %d bytes\n", data_base, data_size);
+        vm_log(vm, "Loading optimized format binary (v%d.%d)\n", major_ver, minor_ver);
+        vm_log(vm, "  Code segment: 0x%04X - %d bytes\n", code_base, code_size);
+        vm_log(vm, "  Data segment: 0x%04X - %d bytes\n", data_base, data_size);
         
         // Validate sizes
         if (code_size > CODE_SEGMENT_SIZE) {
@@ -394,20 +620,20 @@ int vm_load_program_file(VM *vm, const char *filename) {
         }
         
         // Load debug symbols if present and debug mode is enabled
-        if (symbol_size > 0 && vm->debug_mode) {
-            printf("  Symbol table: %d bytes\n", symbol_size);
+        if (symbol_size > 0 && (vm->debug_mode || vm->load_symbols)) {
+            vm_log(vm, "  Symbol table: %d bytes\n", symbol_size);
             
             // Allocate a buffer for the symbol table
             uint8_t *symbol_buffer = (uint8_t *)malloc(symbol_size);
             if (!symbol_buffer) {
                 // Non-fatal error - we can continue without debug info
-                printf("Warning: Failed to allocate memory for symbol table\n");
+                fprintf(stderr, "Warning: Failed to allocate memory for symbol table\n");
             } else {
                 // Read symbol table
                 fseek(file, symbol_offset, SEEK_SET);
                 size_t bytes_read = fread(symbol_buffer, 1, symbol_size, file);
                 if (bytes_read != symbol_size) {
-                    printf("Warning: Failed to read symbol table: %zu of %d bytes\n",
+                    fprintf(stderr, "Warning: Failed to read symbol table: %zu of %d bytes\n",
                            bytes_read, symbol_size);
                     free(symbol_buffer);
                 } else {
@@ -431,7 +657,7 @@ int vm_load_program_file(VM *vm, const char *filename) {
     }
     
     // Legacy format - load differently
-    printf("Loading legacy format binary\n");
+    vm_log(vm, "Loading legacy format binary\n");
     
     // Check if file fits in memory
     if (file_size > vm->memory_size) {
@@ -462,7 +688,7 @@ int vm_load_program_file(VM *vm, const char *filename) {
     }
     else if (file_size <= vm->memory_size) {
         // Check if this might be a larger binary with data segment
-        printf("  Loading large binary with possible data segment\n");
+        vm_log(vm, "  Loading large binary with possible data segment\n");
         
         // Try to find where code ends and data begins
         long data_start = CODE_SEGMENT_SIZE;
@@ -486,7 +712,7 @@ int vm_load_program_file(VM *vm, const char *filename) {
             size_t data_read = fread(vm->memory + DATA_SEGMENT_BASE, 1, data_to_read, file);
             if (data_read != data_to_read) {
                 // Warning but not a fatal error - we loaded the code
-                printf("Warning: Failed to read complete data segment: %zu of %ld bytes\n",
+                fprintf(stderr, "Warning: Failed to read complete data segment: %zu of %ld bytes\n",
                        data_read, data_to_read);
             }
         }
@@ -534,6 +760,10 @@ const char* vm_get_error_string(int error_code) {
             return "I/O operation error";
         case VM_ERROR_PROTECTION_FAULT:
             return "Memory protection fault";
+        case VM_ERROR_NESTED_INTERRUPT:
+            return "Nested interrupt";
+        case VM_ERROR_REPLAY:
+            return "Replay log mismatch";
         default:
             return "Unknown error";
     }
@@ -582,6 +812,24 @@ void vm_dump_state(VM *vm) {
     printf("\n");
 }
 
+void vm_set_log(VM *vm, FILE *stream) {
+    if (vm) {
+        vm->log_stream = stream;
+    }
+}
+
+void vm_log(VM *vm, const char *format, ...) {
+    FILE *stream = vm ? vm->log_stream : stdout;
+    if (!stream) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(stream, format, args);
+    va_end(args);
+}
+
 const char* vm_get_error_message(VM *vm) {
     if (!vm) {
         return "Invalid VM pointer";
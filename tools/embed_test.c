@@ -0,0 +1,119 @@
+/**
+ * Embedding check host (see tools/test_libvm.py)
+ *
+ * Runs a program through the API in libvm.h only, the way an embedding
+ * application would:
+ *     embed_test program.bin plugins/fnv_hash.so
+ *
+ * Guest output is collected by an output callback and printed after the
+ * run. Console input comes from a pipe holding "x\n". Syscall 100 adds R0
+ * and R5; syscall 101 upper-cases R5 bytes at R0 in place and faults if
+ * the range is outside guest memory. The program runs in slices of 5
+ * instructions, and the allocator counts the blocks it hands out.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "libvm.h"
+
+#define SLICE 5
+
+typedef struct {
+    char output[4096];
+    size_t length;
+    int allocations;
+    int host_calls;
+} Session;
+
+static void *session_alloc(size_t size, void *user_data) {
+    ((Session *)user_data)->allocations++;
+    return malloc(size);
+}
+
+static void session_free(void *ptr, void *user_data) {
+    ((Session *)user_data)->allocations--;
+    free(ptr);
+}
+
+static void on_output(VM *vm, const char *data, size_t len, void *user_data) {
+    Session *session = user_data;
+    (void)vm;
+    if (len > sizeof(session->output) - session->length) {
+        len = sizeof(session->output) - session->length;
+    }
+    memcpy(session->output + session->length, data, len);
+    session->length += len;
+}
+
+static int host_add(VM *vm, const uint32_t *args) {
+    ((Session *)vm_get_user_data(vm))->host_calls++;
+    vm_set_register(vm, 0, args[0] + args[1]);
+    return 0;
+}
+
+static int host_upper(VM *vm, const uint32_t *args) {
+    uint16_t length = args[1];
+    uint8_t *data = vm_guest_ptr(vm, args[0], length, VM_ACCESS_READ | VM_ACCESS_WRITE);
+    ((Session *)vm_get_user_data(vm))->host_calls++;
+    if (!data) {
+        return vm_get_last_error(vm);
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        if (data[i] >= 'a' && data[i] <= 'z') {
+            data[i] -= 'a' - 'A';
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s program.bin plugin.so\n", argv[0]);
+        return 2;
+    }
+
+    Session session = {0};
+    VMAllocator allocator = { session_alloc, session_free, &session };
+    VMConfig config = { .allocator = &allocator, .output = on_output,
+                        .output_data = &session, .user_data = &session };
+    VM *vm = vm_create(&config);
+    if (!vm) {
+        fprintf(stderr, "vm_create failed\n");
+        return 1;
+    }
+
+    int input[2];
+    if (pipe(input) != 0 || write(input[1], "x\n", 2) != 2) {
+        perror("pipe");
+        return 1;
+    }
+    close(input[1]);
+
+    if (vm_set_input_fd(vm, input[0]) != 0 ||
+        vm_register_syscall(vm, 100, "add", 2, 0, host_add) != 0 ||
+        vm_register_syscall(vm, 101, "upper", 2, 0, host_upper) != 0 ||
+        vm_load_plugin(vm, argv[2]) != 0 ||
+        vm_load_program_file(vm, argv[1]) != 0) {
+        fprintf(stderr, "setup failed: %s\n", vm_get_error_message(vm));
+        return 1;
+    }
+
+    int slices = 0;
+    int error = 0;
+    while (!vm_halted(vm) && error == 0) {
+        error = vm_run_for(vm, SLICE);
+        slices++;
+    }
+
+    fwrite(session.output, 1, session.length, stdout);
+    printf("host calls: %d\n", session.host_calls);
+    printf("stopped: %s\n", error ? vm_get_error_message(vm) : "halted");
+    printf("sliced: %s\n", slices > 1 && vm_get_instruction_count(vm) <= (uint32_t)slices * SLICE
+                           ? "yes" : "no");
+
+    vm_destroy(vm);
+    close(input[0]);
+    printf("allocations left: %d\n", session.allocations);
+    return 0;
+}
@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+"""
+DMA Overlap Check
+
+Assembles and runs assembler/examples/dma_overlap_test.asm, which moves 512
+overlapping bytes up and then down by one byte. The transfer spans several
+DMA chunks, and each direction must match a single memmove.
+
+Usage: test_dma_overlap.py [path/to/vm]
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "assembler", "examples", "dma_overlap_test.asm")
+ASSEMBLER = os.path.join(ROOT, "assembler", "assembler.py")
+
+def main():
+    """Run the program and check both directions."""
+    vm = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "vm")
+
+    with tempfile.TemporaryDirectory() as tmp:
+        program = os.path.join(tmp, "dma_overlap_test.bin")
+        subprocess.run([sys.executable, ASSEMBLER, SOURCE, "-o", program],
+                       check=True, stdout=subprocess.DEVNULL)
+        result = subprocess.run([vm, "-q", program], capture_output=True)
+
+    if result.returncode != 0:
+        sys.exit("vm failed: %s" % result.stderr.decode(errors="replace"))
+    expected = b"up: ok\ndown: ok\n"
+    if result.stdout != expected:
+        sys.exit("FAIL: output %r, expected %r" % (result.stdout, expected))
+    print("PASS: overlapping DMA transfers match memmove")
+
+if __name__ == "__main__":
+    main()
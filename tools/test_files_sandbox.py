@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""
+File Sandbox Check
+
+Builds a sandbox directory holding a file, a subdirectory, a symlink to a
+file outside the sandbox and a symlink to a directory outside it, then runs
+assembler/examples/files_sandbox_test.asm with -s. Files inside the sandbox
+must open; names that leave it through a symlink must be refused, and the
+status of a symlink must describe the link, not its target.
+
+Usage: test_files_sandbox.py [path/to/vm]
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "assembler", "examples", "files_sandbox_test.asm")
+ASSEMBLER = os.path.join(ROOT, "assembler", "assembler.py")
+
+def write(path, text):
+    """Create a small text file."""
+    with open(path, "w") as f:
+        f.write(text)
+
+def main():
+    """Run the program against a sandbox with escaping symlinks."""
+    vm = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "vm")
+
+    with tempfile.TemporaryDirectory() as tmp:
+        program = os.path.join(tmp, "files_sandbox_test.bin")
+        subprocess.run([sys.executable, ASSEMBLER, SOURCE, "-o", program],
+                       check=True, stdout=subprocess.DEVNULL)
+
+        sandbox = os.path.join(tmp, "sandbox")
+        outside = os.path.join(tmp, "outside")
+        os.makedirs(os.path.join(sandbox, "sub"))
+        os.makedirs(outside)
+        write(os.path.join(sandbox, "inside.txt"), "inside\n")
+        write(os.path.join(sandbox, "sub", "inner.txt"), "inner\n")
+        write(os.path.join(outside, "secret.txt"), "secret\n")
+        os.symlink(os.path.join(outside, "secret.txt"), os.path.join(sandbox, "file_link"))
+        os.symlink(outside, os.path.join(sandbox, "dir_link"))
+
+        result = subprocess.run([vm, "-q", "-s", sandbox, program], capture_output=True)
+        if result.returncode != 0:
+            sys.exit("vm failed: %s" % result.stderr.decode(errors="replace"))
+
+    # Opens: inside, file link, directory link, subdirectory; then the
+    # link's status and type, then status through the directory link
+    expected = b"0 1 1 0 0 2\n1\n"
+    if result.stdout != expected:
+        sys.exit("FAIL: output %r, expected %r" % (result.stdout, expected))
+    print("PASS: symlinks cannot leave the file sandbox")
+
+if __name__ == "__main__":
+    main()
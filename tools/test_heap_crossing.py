@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""
+Heap Crossing Check
+
+Assembles assembler/examples/heap_crossing_test.asm and runs each of its
+cases. Every case makes one block transfer into guest memory that starts
+below the heap (0xC000) and runs into the first block's header. Such a
+transfer must fault before it writes anything; if it doesn't, the header
+is overwritten and freeing the block fails instead. The string print case
+must stop looking for the terminator at the heap instead of scanning the
+block header.
+
+Usage: test_heap_crossing.py [path/to/vm]
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "assembler", "examples", "heap_crossing_test.asm")
+ASSEMBLER = os.path.join(ROOT, "assembler", "assembler.py")
+
+# Case letter, description and the expected fault; "n" stays below the
+# heap and must succeed
+CASES = [
+    ("n", "random fill below the heap", None),
+    ("r", "random fill (syscall 42)", "unallocated heap"),
+    ("f", "file read (syscall 12)", "unallocated heap"),
+    ("l", "line read (syscall 52)", "unallocated heap"),
+    ("s", "string print (syscall 51)", "Unterminated string"),
+    ("d", "disk sector read", "unallocated heap"),
+    ("c", "channel read (syscall 61)", "unallocated heap"),
+]
+
+def run_case(vm, program, case, tmp):
+    """Run one case and return (exit code, stdout, stderr)."""
+    # The rest of the line is input for the line read
+    line = case.encode() + b"x" * 63 + b"\n"
+    result = subprocess.run([vm, "-q", "-i", "heap_crossing.img", program], input=line,
+                            capture_output=True, cwd=tmp, timeout=10)
+    return result.returncode, result.stdout, result.stderr.decode(errors="replace")
+
+def main():
+    """Run every case and check that only the control case completes."""
+    vm = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "vm")
+    failed = 0
+
+    with tempfile.TemporaryDirectory() as tmp:
+        program = os.path.join(tmp, "heap_crossing_test.bin")
+        subprocess.run([sys.executable, ASSEMBLER, SOURCE, "-o", program],
+                       check=True, stdout=subprocess.DEVNULL)
+
+        # Data for the file read, in the VM's default sandbox
+        with open(os.path.join(tmp, "heap_crossing.txt"), "wb") as f:
+            f.write(bytes(range(64)))
+
+        # Two sectors for the disk read
+        with open(os.path.join(tmp, "heap_crossing.img"), "wb") as f:
+            f.write(b"\xAA" * 1024)
+
+        for case, description, fault in CASES:
+            code, output, errors = run_case(vm, program, case, tmp)
+            if fault is None:
+                ok = code == 0 and output == b"heap ok\n"
+            else:
+                ok = code != 0 and fault in errors
+            if not ok:
+                print("FAIL: %s: exit %d, output %r, errors %r" % (description, code, output, errors))
+                failed += 1
+
+    if failed:
+        sys.exit(1)
+    print("PASS: transfers into the heap from below fault")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""
+Interrupt Latency Benchmark for VM
+
+This script generates a binary program that enters and leaves an
+interrupt handler in a tight loop. Time it with and without the -f
+(fast interrupt) option to compare context save/restore cost:
+
+    python3 tools/test_interrupt_latency.py 1000 > latency.bin
+    time ./vm latency.bin
+    time ./vm -f latency.bin
+
+The optional argument is the number of interrupts in thousands.
+"""
+
+import struct
+import sys
+
+# Addressing modes
+IMM_MODE = 0x0   # Immediate: Value in instruction
+REG_MODE = 0x1   # Register: Value in register
+MEM_MODE = 0x2   # Memory: Direct address
+
+# Register definitions
+R0_ACC = 0   # Accumulator
+R5 = 5       # General purpose register
+R6 = 6       # General purpose register
+
+# Opcodes
+NOP_OP = 0x00      # No operation
+LOAD_OP = 0x01     # Load value into register
+STORE_OP = 0x02    # Store value to memory
+MOVE_OP = 0x03     # Copy register to register
+DEC_OP = 0x26      # Decrement
+JNZ_OP = 0x62      # Jump if not zero
+SYSCALL_OP = 0x6C  # System call
+INT_OP = 0xA1      # Generate interrupt
+STI_OP = 0xA3      # Set interrupt flag
+IRET_OP = 0xA4     # Return from interrupt
+HALT_OP = 0xA0     # Halt execution
+
+# Constants
+VECTOR_TABLE_BASE = 0x0100
+INTERRUPT_HANDLER_BASE = 0x1000
+INNER_LOOP_COUNT = 1000
+
+def encode_instruction(opcode, mode, reg1, reg2, immediate):
+    """Encode a VM instruction into a 32-bit value."""
+    # Ensure fields are within their bit limits
+    opcode = opcode & 0xFF        # 8 bits
+    mode = mode & 0x0F            # 4 bits
+    reg1 = reg1 & 0x0F            # 4 bits
+    reg2 = reg2 & 0x0F            # 4 bits
+    immediate = immediate & 0xFFF  # 12 bits
+
+    # Build the instruction
+    instruction = (opcode << 24) | (mode << 20) | (reg1 << 16) | (reg2 << 12) | immediate
+    return instruction
+
+def encode_imm16(opcode, mode, reg1, value):
+    """Encode an instruction whose reg2 field extends the immediate to 16 bits."""
+    return encode_instruction(opcode, mode, reg1, (value >> 12) & 0xF, value & 0xFFF)
+
+def generate_latency_program(thousands):
+    """Generate a program that takes 'thousands' * 1000 interrupts."""
+    # Pad for the vector table at 0x0100
+    program = [0] * (VECTOR_TABLE_BASE // 4)
+
+    main_program = []
+
+    # Install the handler for interrupt 0x10 and enable interrupts
+    main_program.append(encode_imm16(LOAD_OP, IMM_MODE, R0_ACC, INTERRUPT_HANDLER_BASE))
+    main_program.append(encode_imm16(STORE_OP, MEM_MODE, R0_ACC, VECTOR_TABLE_BASE + (0x10 * 4)))
+    main_program.append(encode_instruction(STI_OP, IMM_MODE, 0, 0, 0))
+
+    # Outer loop counter
+    main_program.append(encode_imm16(LOAD_OP, IMM_MODE, R6, thousands))
+
+    # Outer loop: reload the inner counter
+    outer_loop = len(main_program) * 4
+    main_program.append(encode_imm16(LOAD_OP, IMM_MODE, R5, INNER_LOOP_COUNT))
+
+    # Inner loop: one interrupt round trip per iteration
+    inner_loop = len(main_program) * 4
+    main_program.append(encode_instruction(INT_OP, IMM_MODE, 0, 0, 0x10))
+    main_program.append(encode_instruction(DEC_OP, REG_MODE, R5, 0, 0))
+    main_program.append(encode_imm16(JNZ_OP, IMM_MODE, 0, inner_loop))
+    main_program.append(encode_instruction(DEC_OP, REG_MODE, R6, 0, 0))
+    main_program.append(encode_imm16(JNZ_OP, IMM_MODE, 0, outer_loop))
+
+    # Print the (preserved) loop counter and halt
+    main_program.append(encode_instruction(MOVE_OP, REG_MODE, R0_ACC, R6, 0))
+    main_program.append(encode_instruction(SYSCALL_OP, IMM_MODE, 0, 0, 1))  # Print int
+    main_program.append(encode_instruction(LOAD_OP, IMM_MODE, R0_ACC, 0, 10))
+    main_program.append(encode_instruction(SYSCALL_OP, IMM_MODE, 0, 0, 0))  # Print newline
+    main_program.append(encode_instruction(HALT_OP, IMM_MODE, 0, 0, 0))
+
+    # The jump targets above are absolute, so place the main program at 0x0000
+    program[:len(main_program)] = main_program
+
+    # Pad with NOPs up to the interrupt handler
+    program.extend([encode_instruction(NOP_OP, IMM_MODE, 0, 0, 0)] *
+                   ((INTERRUPT_HANDLER_BASE // 4) - len(program)))
+
+    # Interrupt handler: clobber a loop counter, then return
+    program.append(encode_instruction(LOAD_OP, IMM_MODE, R5, 0, 0))
+    program.append(encode_instruction(IRET_OP, IMM_MODE, 0, 0, 0))
+
+    # Convert instructions to binary
+    binary_program = bytearray()
+    for instr in program:
+        binary_program.extend(struct.pack("<I", instr))
+
+    return binary_program
+
+def main():
+    """Main function to generate and output the benchmark program."""
+    thousands = int(sys.argv[1]) if len(sys.argv) > 1 else 1000
+    if thousands <= 0 or thousands > 0xFFFF:
+        sys.stderr.write("Interrupt count must be between 1 and 65535 thousand\n")
+        sys.exit(1)
+
+    binary_program = generate_latency_program(thousands)
+
+    # Write to stdout in binary mode
+    if hasattr(sys.stdout, 'buffer'):
+        sys.stdout.buffer.write(binary_program)
+    else:
+        sys.stdout.write(binary_program)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""
+Embedding Library Check
+
+Builds libvm.a, libvm.so and the example plugin with make, then compiles
+tools/embed_test.c against each library and runs
+assembler/examples/embed_test.asm in it. The host feeds console input
+through a pipe, adds two syscalls of its own, loads plugins/fnv_hash.so,
+collects output with a callback and runs the program in small slices
+until a host syscall faults. Both builds must print the same, free every
+block they allocated, and libvm.so must export only the functions
+declared in include/libvm.h.
+
+Usage: test_libvm.py
+"""
+
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "assembler", "examples", "embed_test.asm")
+ASSEMBLER = os.path.join(ROOT, "assembler", "assembler.py")
+HOST = os.path.join(ROOT, "tools", "embed_test.c")
+HEADER = os.path.join(ROOT, "include", "libvm.h")
+PLUGIN = os.path.join(ROOT, "plugins", "fnv_hash.so")
+CC = os.environ.get("CC", "gcc")
+
+EXPECTED = (b"x\n42\n0x4f9f2cab\nHELLO\n"
+            b"host calls: 3\n"
+            b"stopped: Memory access violation: address 0xFFF0, size 32\n"
+            b"sliced: yes\n"
+            b"allocations left: 0\n")
+
+def exported_symbols():
+    """Return the functions libvm.so exports."""
+    result = subprocess.run(["nm", "-D", "--defined-only", os.path.join(ROOT, "libvm.so")],
+                            check=True, capture_output=True, text=True)
+    return {line.split()[2].split("@")[0] for line in result.stdout.splitlines()
+            if line.split()[1] == "T"}
+
+def declared_functions():
+    """Return the functions declared in libvm.h."""
+    with open(HEADER) as f:
+        return set(re.findall(r"\b(vm_\w+)\(", f.read()))
+
+def main():
+    """Build both hosts, run them and check the export list."""
+    failed = 0
+
+    subprocess.run(["make", "-C", ROOT, "lib", "plugins"], check=True, stdout=subprocess.DEVNULL)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        program = os.path.join(tmp, "embed_test.bin")
+        subprocess.run([sys.executable, ASSEMBLER, SOURCE, "-o", program],
+                       check=True, stdout=subprocess.DEVNULL)
+
+        # The static host exports the API itself (-rdynamic) for the plugin
+        hosts = {
+            "libvm.a": [os.path.join(ROOT, "libvm.a"), "-rdynamic"],
+            "libvm.so": ["-L" + ROOT, "-lvm", "-Wl,-rpath," + ROOT],
+        }
+        for name, link in hosts.items():
+            host = os.path.join(tmp, "embed_" + name.replace(".", "_"))
+            subprocess.run([CC, "-Wall", "-I" + os.path.join(ROOT, "include"), HOST]
+                           + link + ["-lpthread", "-ldl", "-o", host], check=True)
+            result = subprocess.run([host, program, PLUGIN], capture_output=True, timeout=10)
+            if result.returncode != 0 or result.stdout != EXPECTED:
+                print("FAIL: %s host: exit %d, output %r, errors %r"
+                      % (name, result.returncode, result.stdout,
+                         result.stderr.decode(errors="replace")))
+                failed += 1
+
+    exported = exported_symbols()
+    declared = declared_functions()
+    if exported != declared:
+        print("FAIL: libvm.so exports %s and misses %s"
+              % (sorted(exported - declared), sorted(declared - exported)))
+        failed += 1
+
+    if failed:
+        sys.exit(1)
+    print("PASS: hosts built on libvm.a and libvm.so run programs and plugins")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+"""
+Memory-Mapped Console Check
+
+Assembles assembler/examples/mmio_console_test.asm and runs it with the
+console mapped at 0x7FF0 (-M). The program prints and echoes its input
+using only byte loads and stores, so the output shows that both directions
+of the mapping reach the console device.
+
+Usage: test_mmio_console.py [path/to/vm]
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "assembler", "examples", "mmio_console_test.asm")
+ASSEMBLER = os.path.join(ROOT, "assembler", "assembler.py")
+
+def main():
+    """Run the program with the console window mapped."""
+    vm = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "vm")
+
+    with tempfile.TemporaryDirectory() as tmp:
+        program = os.path.join(tmp, "mmio_console_test.bin")
+        subprocess.run([sys.executable, ASSEMBLER, SOURCE, "-o", program],
+                       check=True, stdout=subprocess.DEVNULL)
+        # Without the mapping the program would spin on plain RAM
+        result = subprocess.run([vm, "-q", "-M", "0x7FF0", program], input=b"abc\n",
+                                capture_output=True, timeout=10)
+
+    if result.returncode != 0:
+        sys.exit("vm failed: %s" % result.stderr.decode(errors="replace"))
+    expected = b"mmio: abc\n"
+    if result.stdout != expected:
+        sys.exit("FAIL: output %r, expected %r" % (result.stdout, expected))
+    print("PASS: loads and stores reach the memory-mapped console")
+
+if __name__ == "__main__":
+    main()
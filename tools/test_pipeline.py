@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""
+Channel Pipeline Check
+
+Assembles assembler/examples/pipeline_test.asm and runs it as a three stage
+pipeline with -c. The first stage reads stdin with read_line (syscall 52),
+the middle one upper-cases what comes over the channel (syscalls 60-62) and
+the last writes it out with write_buffer and write_string (syscalls 50 and
+51). A short input covers blank lines and a missing final newline; a long
+one is bigger than the channel rings, so the stages have to wait on each
+other. A two stage run skips the filter and must pass lines through as
+they are.
+
+Usage: test_pipeline.py [path/to/vm]
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "assembler", "examples", "pipeline_test.asm")
+ASSEMBLER = os.path.join(ROOT, "assembler", "assembler.py")
+
+def run(vm, args, text, tmp):
+    """Run the VM with text on stdin and return (exit code, stdout, stderr)."""
+    result = subprocess.run([vm, "-q"] + args, input=text, capture_output=True,
+                            cwd=tmp, timeout=10)
+    return result.returncode, result.stdout, result.stderr.decode(errors="replace")
+
+def main():
+    """Run each input through the pipeline and compare the output."""
+    vm = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "vm")
+    failed = 0
+
+    short = b"hello world\nPipeline 3 stages\n\nlast line"
+    long = b"".join(b"line %d of the quick brown fox\n" % i for i in range(5000))
+    cases = [
+        ("three stages, short input", 3, short,
+         b"HELLO WORLD\nPIPELINE 3 STAGES\n\nLAST LINE\n"),
+        ("three stages, long input", 3, long, long.upper()),
+        ("two stages", 2, short, short + b"\n"),
+    ]
+
+    with tempfile.TemporaryDirectory() as tmp:
+        program = os.path.join(tmp, "pipeline_test.bin")
+        subprocess.run([sys.executable, ASSEMBLER, SOURCE, "-o", program],
+                       check=True, stdout=subprocess.DEVNULL)
+
+        for name, stages, text, expected in cases:
+            args = [program] + ["-c", program] * (stages - 1)
+            code, output, errors = run(vm, args, text, tmp)
+            expected += b"end of stream\n"
+            if code != 0 or output != expected:
+                print("FAIL: %s: exit %d, output %r, expected %r, errors %r"
+                      % (name, code, output[:200], expected[:200], errors))
+                failed += 1
+
+    if failed:
+        sys.exit(1)
+    print("PASS: lines pass through the pipeline in order")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""
+Random Number Check
+
+Assembles assembler/examples/random_test.asm and runs it twice. Draws from
+syscall 40 must stay within [0, max] and hit every value in that range,
+max 0 must give full 32-bit values, and syscall 42 must fill exactly the
+requested bytes and leave the guard bytes on either side alone. The
+program seeds the generator, so both runs must print the same.
+
+Usage: test_random.py [path/to/vm]
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "assembler", "examples", "random_test.asm")
+ASSEMBLER = os.path.join(ROOT, "assembler", "assembler.py")
+
+GUARD = 85  # 'U'
+
+def run(vm, args, tmp):
+    """Run the VM and return (exit code, stdout, stderr)."""
+    result = subprocess.run([vm, "-q"] + args, capture_output=True, cwd=tmp, timeout=10)
+    return result.returncode, result.stdout, result.stderr.decode(errors="replace")
+
+def check(output):
+    """Return a list of problems with one run's output."""
+    lines = output.decode().splitlines()
+    if len(lines) != 5:
+        return ["expected 5 lines, got %d" % len(lines)]
+    problems = []
+
+    for line, count, top in ((lines[0], 2000, 6), (lines[1], 200, 1)):
+        draws = [int(value) for value in line.split()]
+        if len(draws) != count:
+            problems.append("max %d: %d draws instead of %d" % (top, len(draws), count))
+        elif set(draws) != set(range(top + 1)):
+            problems.append("max %d: drew %s" % (top, sorted(set(draws))))
+
+    draws = [int(value) & 0xFFFFFFFF for value in lines[2].split()]
+    if len(draws) != 100 or max(draws) < 0x80000000 or len(set(draws)) < 95:
+        problems.append("max 0: draws do not cover 32 bits: %r" % draws[:10])
+
+    filled = [int(value) for value in lines[4].split()]
+    if lines[3] != "30":
+        problems.append("fill returned %s instead of 30" % lines[3])
+    if len(filled) != 32 or filled[0] != GUARD or filled[31] != GUARD:
+        problems.append("fill touched the guard bytes: %r" % filled)
+    elif filled[1:31] == [32] * 30:
+        problems.append("fill left the buffer unchanged")
+    return problems
+
+def main():
+    """Check one run, then compare it with a second run."""
+    vm = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "vm")
+    failed = 0
+
+    with tempfile.TemporaryDirectory() as tmp:
+        program = os.path.join(tmp, "random_test.bin")
+        subprocess.run([sys.executable, ASSEMBLER, SOURCE, "-o", program],
+                       check=True, stdout=subprocess.DEVNULL)
+
+        code, first, errors = run(vm, [program], tmp)
+        if code != 0:
+            sys.exit("FAIL: exit %d, errors %r" % (code, errors))
+        for problem in check(first):
+            print("FAIL: %s" % problem)
+            failed += 1
+
+        code, second, errors = run(vm, [program], tmp)
+        if code != 0 or second != first:
+            print("FAIL: second run with the same seed differs: exit %d, errors %r"
+                  % (code, errors))
+            failed += 1
+
+    if failed:
+        sys.exit(1)
+    print("PASS: random numbers stay in range and fills stay in bounds")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+"""
+Record/Replay Check for Console Input
+
+Assembles assembler/examples/console_replay_test.asm, records a run that
+reads its input with syscalls 3 and 4, then replays the log with different
+input on stdin. The replayed output must match the recording, and the
+syscall 4 read must see the input that follows the syscall 3 byte.
+
+Usage: test_replay_console.py [path/to/vm]
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "assembler", "examples", "console_replay_test.asm")
+ASSEMBLER = os.path.join(ROOT, "assembler", "assembler.py")
+
+def run_vm(vm, args, stdin):
+    """Run the VM quietly and return its output."""
+    result = subprocess.run([vm, "-q"] + args, input=stdin, capture_output=True)
+    if result.returncode != 0:
+        sys.exit("vm %s failed: %s" % (" ".join(args), result.stderr.decode(errors="replace")))
+    return result.stdout
+
+def main():
+    """Record with one input, replay with another, and compare."""
+    vm = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "vm")
+
+    with tempfile.TemporaryDirectory() as tmp:
+        program = os.path.join(tmp, "console_replay_test.bin")
+        log = os.path.join(tmp, "console.log")
+        subprocess.run([sys.executable, ASSEMBLER, SOURCE, "-o", program],
+                       check=True, stdout=subprocess.DEVNULL)
+
+        recorded = run_vm(vm, ["-r", log, program], b"hello\nworld\n")
+        replayed = run_vm(vm, ["-R", log, program], b"other\ninput\n")
+
+    expected = b"> h[ello]\n"
+    if recorded != expected:
+        sys.exit("FAIL: recorded output %r, expected %r" % (recorded, expected))
+    if replayed != recorded:
+        sys.exit("FAIL: replay printed %r, recording printed %r" % (replayed, recorded))
+    print("PASS: syscall 4 input is recorded and replayed")
+
+if __name__ == "__main__":
+    main()
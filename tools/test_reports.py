@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""
+Run Report Check
+
+Runs assembler/examples/fib.asm with coverage (-C) alone, then together
+with the profiler (-P) and statistics (-x), which all attach through
+instrumentation hooks. The lcov file must have a DA line, hit once, for
+every instruction line of fib.asm and match between the two runs; the
+folded stacks and the JSON statistics must both count every executed
+instruction. Coverage of assembler/examples/pipeline_test.asm run on its
+own must leave the channel stages unhit, and a second run with input must
+merge into the same bitmap without losing lines.
+
+Usage: test_reports.py [path/to/vm]
+"""
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+EXAMPLES = os.path.join(ROOT, "assembler", "examples")
+ASSEMBLER = os.path.join(ROOT, "assembler", "assembler.py")
+
+FIB_OUTPUT = b"\nFactorial result: 120\n"
+FIB_SYSCALLS = {0: 2, 1: 1, 2: 1}
+
+def run(vm, args, tmp, text=b""):
+    """Run the VM and return (exit code, stdout, stderr)."""
+    result = subprocess.run([vm, "-q"] + args, input=text, capture_output=True,
+                            cwd=tmp, timeout=10)
+    return result.returncode, result.stdout, result.stderr.decode(errors="replace")
+
+def assemble(name, tmp):
+    """Assemble an example into tmp and return the program path."""
+    program = os.path.join(tmp, name + ".bin")
+    subprocess.run([sys.executable, ASSEMBLER, os.path.join(EXAMPLES, name + ".asm"),
+                    "-o", program], check=True, stdout=subprocess.DEVNULL)
+    return program
+
+def instruction_lines(name):
+    """Return the numbers of the source lines holding an instruction."""
+    lines = set()
+    with open(os.path.join(EXAMPLES, name + ".asm")) as f:
+        for number, line in enumerate(f, 1):
+            code = line.split(";")[0].strip()
+            if ":" in code:
+                code = code.split(":", 1)[1].strip()
+            if code == ".data":
+                break
+            if code and not code.startswith("."):
+                lines.add(number)
+    return lines
+
+def read_lcov(path):
+    """Return (source files, {line: count}, complete) for an lcov file."""
+    files, counts = [], {}
+    with open(path) as f:
+        text = f.read()
+    for line in text.splitlines():
+        if line.startswith("SF:"):
+            files.append(line[3:])
+        elif line.startswith("DA:"):
+            number, count = line[3:].split(",")
+            counts[int(number)] = int(count)
+    return files, counts, text.rstrip().endswith("end_of_record")
+
+def check_fib(vm, tmp):
+    """Check the fib.asm reports; return the number of failures."""
+    failed = 0
+    program = assemble("fib", tmp)
+
+    code, output, errors = run(vm, ["-C", "fib.bits", "fib.info", program], tmp)
+    files, counts, complete = read_lcov(os.path.join(tmp, "fib.info"))
+    expected = instruction_lines("fib")
+    if (code != 0 or output != FIB_OUTPUT or files != ["fib.asm"] or not complete
+            or set(counts) != expected or set(counts.values()) != {1}):
+        print("FAIL: fib.asm coverage: exit %d, files %r, lines %r, expected %r, errors %r"
+              % (code, files, sorted(counts.items()), sorted(expected), errors))
+        failed += 1
+
+    code, output, errors = run(vm, ["-C", "hooked.bits", "hooked.info", "-e", "1",
+                                    "-P", "fib.folded", "-x", "fib.json", program], tmp)
+    if code != 0 or output != FIB_OUTPUT:
+        print("FAIL: fib.asm with all reports: exit %d, output %r, errors %r"
+              % (code, output, errors))
+        return failed + 1
+    if read_lcov(os.path.join(tmp, "hooked.info"))[1] != counts:
+        print("FAIL: coverage differs when the profiler and statistics run too")
+        failed += 1
+
+    with open(os.path.join(tmp, "fib.json")) as f:
+        stats = json.load(f)
+    syscalls = {entry["number"]: entry["calls"] for entry in stats["syscalls"]}
+    executed = sum(entry["count"] for entry in stats["opcodes"])
+    if syscalls != FIB_SYSCALLS or executed != stats["instructions"]:
+        print("FAIL: fib.json: syscalls %r, opcodes add up to %d of %d instructions"
+              % (syscalls, executed, stats["instructions"]))
+        failed += 1
+
+    # With -e 1 every instruction is a sample
+    with open(os.path.join(tmp, "fib.folded")) as f:
+        samples = sum(int(line.rsplit(" ", 1)[1]) for line in f if line.strip())
+    if samples != stats["instructions"]:
+        print("FAIL: fib.folded has %d samples for %d instructions"
+              % (samples, stats["instructions"]))
+        failed += 1
+    return failed
+
+def check_merge(vm, tmp):
+    """Check partial coverage and merging; return the number of failures."""
+    failed = 0
+    program = assemble("pipeline_test", tmp)
+    args = ["-C", "pipeline.bits", "pipeline.info", program]
+
+    code, output, errors = run(vm, args, tmp)
+    first = read_lcov(os.path.join(tmp, "pipeline.info"))[1]
+    hit = {line for line, count in first.items() if count}
+    if code != 0 or not hit or len(hit) == len(first):
+        print("FAIL: pipeline_test.asm without input: exit %d, %d of %d lines hit, errors %r"
+              % (code, len(hit), len(first), errors))
+        return failed + 1
+
+    code, output, errors = run(vm, args, tmp, b"line\n")
+    second = read_lcov(os.path.join(tmp, "pipeline.info"))[1]
+    merged = {line for line, count in second.items() if count}
+    if code != 0 or not hit < merged or len(merged) == len(second):
+        print("FAIL: merged coverage: exit %d, %d lines hit before, %d after, of %d, errors %r"
+              % (code, len(hit), len(merged), len(second), errors))
+        failed += 1
+    return failed
+
+def main():
+    """Check the fib.asm reports, then coverage merging."""
+    vm = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "vm")
+
+    with tempfile.TemporaryDirectory() as tmp:
+        failed = check_fib(vm, tmp) + check_merge(vm, tmp)
+
+    if failed:
+        sys.exit(1)
+    print("PASS: coverage, profile and statistics reports agree")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""
+Snapshot Round Trip Check
+
+Assembles assembler/examples/snapshot_test.asm, which prints a heap counter
+and a seeded random number ten times, and runs it three ways: straight
+through, stopped with a snapshot at the label "middle", and restored from
+that snapshot. The saved half and the restored half must add up to the
+straight run. A truncated snapshot and one restored into a VM with a
+different memory size must be rejected with an error instead of crashing.
+
+Usage: test_snapshot.py [path/to/vm]
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "assembler", "examples", "snapshot_test.asm")
+ASSEMBLER = os.path.join(ROOT, "assembler", "assembler.py")
+
+def run(vm, args, tmp):
+    """Run the VM and return (exit code, stdout, stderr)."""
+    result = subprocess.run([vm, "-q"] + args, capture_output=True, cwd=tmp, timeout=10)
+    return result.returncode, result.stdout, result.stderr.decode(errors="replace")
+
+def main():
+    """Check the round trip, then the two restores that must fail."""
+    vm = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "vm")
+    failed = 0
+
+    with tempfile.TemporaryDirectory() as tmp:
+        program = os.path.join(tmp, "snapshot_test.bin")
+        subprocess.run([sys.executable, ASSEMBLER, SOURCE, "-o", program],
+                       check=True, stdout=subprocess.DEVNULL)
+
+        code, full, errors = run(vm, [program], tmp)
+        if code != 0 or full.count(b"\n") != 10:
+            sys.exit("FAIL: straight run: exit %d, output %r, errors %r" % (code, full, errors))
+
+        code, first, errors = run(vm, ["-S", "middle", "snapshot.vms", program], tmp)
+        if code != 0:
+            sys.exit("FAIL: saving the snapshot: exit %d, errors %r" % (code, errors))
+        code, second, errors = run(vm, ["-L", "snapshot.vms"], tmp)
+        if code != 0 or first + second != full:
+            print("FAIL: round trip: exit %d, output %r + %r, expected %r, errors %r"
+                  % (code, first, second, full, errors))
+            failed += 1
+
+        with open(os.path.join(tmp, "snapshot.vms"), "rb") as f:
+            data = f.read()
+        with open(os.path.join(tmp, "truncated.vms"), "wb") as f:
+            f.write(data[:8192])
+        code, output, errors = run(vm, ["-L", "truncated.vms"], tmp)
+        if code != 1 or "truncated" not in errors:
+            print("FAIL: truncated snapshot: exit %d, errors %r" % (code, errors))
+            failed += 1
+
+        code, output, errors = run(vm, ["-m", "128", "-L", "snapshot.vms"], tmp)
+        if code != 1 or "memory" not in errors:
+            print("FAIL: memory size mismatch: exit %d, errors %r" % (code, errors))
+            failed += 1
+
+    if failed:
+        sys.exit(1)
+    print("PASS: snapshots round trip and bad ones are rejected")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""
+Syscall Table Check
+
+Assembles assembler/examples/syscall_table_test.asm and runs it with and
+without plugins/fnv_hash.so. An unused number below 70 must return with
+R5 = 1, syscall 200 must fault until the plugin binds it, and the never
+registered syscall 150 must stop the program with an invalid syscall
+error. The -x statistics must list the plugin's entry by name.
+
+Usage: test_syscall_table.py [path/to/vm]
+"""
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "assembler", "examples", "syscall_table_test.asm")
+ASSEMBLER = os.path.join(ROOT, "assembler", "assembler.py")
+PLUGIN = os.path.join(ROOT, "plugins", "fnv_hash.so")
+
+def run(vm, args, tmp):
+    """Run the VM and return (exit code, stdout, stderr)."""
+    result = subprocess.run([vm, "-q"] + args, capture_output=True, cwd=tmp, timeout=10)
+    return result.returncode, result.stdout, result.stderr.decode(errors="replace")
+
+def main():
+    """Run without the plugin, then with it and the statistics."""
+    vm = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "vm")
+    failed = 0
+
+    subprocess.run(["make", "-C", ROOT, "plugins"], check=True, stdout=subprocess.DEVNULL)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        program = os.path.join(tmp, "syscall_table_test.bin")
+        subprocess.run([sys.executable, ASSEMBLER, SOURCE, "-o", program],
+                       check=True, stdout=subprocess.DEVNULL)
+
+        code, output, errors = run(vm, [program], tmp)
+        if code != 1 or output != b"1\n" or "Invalid system call: 200" not in errors:
+            print("FAIL: without the plugin: exit %d, output %r, errors %r"
+                  % (code, output, errors))
+            failed += 1
+
+        code, output, errors = run(vm, ["-p", PLUGIN, "-x", "stats.json", program], tmp)
+        if (code != 1 or output != b"1\n0x4f9f2cab\n"
+                or "Invalid system call: 150" not in errors):
+            print("FAIL: with the plugin: exit %d, output %r, errors %r"
+                  % (code, output, errors))
+            failed += 1
+
+        try:
+            with open(os.path.join(tmp, "stats.json")) as f:
+                syscalls = {entry["number"]: entry for entry in json.load(f)["syscalls"]}
+        except (OSError, ValueError, KeyError) as error:
+            print("FAIL: reading stats.json: %s" % error)
+            failed += 1
+        else:
+            entry = syscalls.get(200)
+            if not entry or entry["calls"] != 1 or not entry["name"]:
+                print("FAIL: syscall 200 in stats.json: %r" % entry)
+                failed += 1
+
+    if failed:
+        sys.exit(1)
+    print("PASS: unused, plugin and unregistered syscalls behave as documented")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""
+Ring Device Socket Client for VM
+
+This script connects to the socket opened by the VM's -u option, sends each
+message given on the command line as one frame and prints the replies.
+Frames are a 16-bit little-endian length followed by the payload:
+
+    ./vm -u /tmp/vm.sock echo.bin &
+    python3 tools/vring_client.py /tmp/vm.sock hello world
+
+With --bench N it sends N numbered messages, keeping up to 8 in flight,
+checks that they come back in order and reports the message rate.
+"""
+
+import socket
+import struct
+import sys
+import time
+
+# Messages in flight during the benchmark (one per guest RX buffer)
+WINDOW = 8
+
+def connect(path):
+    """Connect to the VM, retrying while it starts up."""
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    for _ in range(100):
+        try:
+            sock.connect(path)
+            return sock
+        except OSError:
+            time.sleep(0.05)
+    sys.stderr.write("Cannot connect to %s\n" % path)
+    sys.exit(1)
+
+def frame(payload):
+    """Encode one message."""
+    return struct.pack("<H", len(payload)) + payload
+
+class Reader:
+    """Split the byte stream from the VM into messages."""
+    def __init__(self, sock):
+        self.sock = sock
+        self.buffer = b""
+
+    def next(self):
+        while True:
+            if len(self.buffer) >= 2:
+                length = struct.unpack("<H", self.buffer[:2])[0]
+                if len(self.buffer) >= 2 + length:
+                    payload = self.buffer[2:2 + length]
+                    self.buffer = self.buffer[2 + length:]
+                    return payload
+            data = self.sock.recv(65536)
+            if not data:
+                return None
+            self.buffer += data
+
+def bench(sock, count):
+    """Send numbered messages and check the echoes."""
+    reader = Reader(sock)
+    sent = 0
+    received = 0
+    start = time.time()
+
+    while received < count:
+        batch = b""
+        while sent < count and sent - received < WINDOW:
+            batch += frame(b"msg%d" % sent)
+            sent += 1
+        if batch:
+            sock.sendall(batch)
+
+        reply = reader.next()
+        if reply != b"msg%d" % received:
+            sys.stderr.write("Unexpected reply %r for message %d\n" % (reply, received))
+            sys.exit(1)
+        received += 1
+
+    elapsed = time.time() - start
+    print("%d messages in %.2f s (%.0f messages/sec)" % (count, elapsed, count / elapsed))
+
+def main():
+    """Main function to send messages and print replies."""
+    if len(sys.argv) < 3:
+        sys.stderr.write("Usage: %s SOCKET MESSAGE... | SOCKET --bench N\n" % sys.argv[0])
+        sys.exit(1)
+
+    sock = connect(sys.argv[1])
+
+    if sys.argv[2] == "--bench":
+        bench(sock, int(sys.argv[3]))
+    else:
+        reader = Reader(sock)
+        for message in sys.argv[2:]:
+            sock.sendall(frame(message.encode()))
+            reply = reader.next()
+            if reply is None:
+                break
+            print(reply.decode(errors="replace"))
+
+    sock.close()
+
+if __name__ == "__main__":
+    main()